@@ -0,0 +1,34 @@
+-- an allocation heavy script : each frame makes colors and temporary tables, keeps a tenth of them
+-- for a few frames and drops the rest, as particles or ui code does
+-- run it as the main.lua of the engine, once built as is and once with LUASDL_SYSTEM_ALLOC
+-- it never starts SDL so the engine exits once it is done
+local FRAMES = 2000
+local OBJECTS = 5000
+
+local function churn()
+    local kept, ring = {}, 8
+    for frame = 1, FRAMES do
+        local slot = {}
+        for i = 1, OBJECTS do
+            local c = Color.new(i % 256, frame % 256, 0)
+            local p = { x = i, y = frame }
+            local v = { i, frame }
+            if i % 10 == 0 then slot[#slot + 1] = { c, p, v } end
+        end
+        kept[frame % ring + 1] = slot
+    end
+end
+
+local Memory = LuaSDL.Memory
+local before = Memory.GetAllocStats()
+collectgarbage("collect")
+local start = os.clock()
+churn()
+local seconds = os.clock() - start
+local after = Memory.GetAllocStats()
+
+local allocs = after.allocs - before.allocs
+print(string.format("%.0f ms, %d allocations, %.1f ns each with the script's work, %d from the pools, %d from the system",
+    seconds * 1000, allocs, seconds * 1e9 / allocs,
+    after.smallAllocs - before.smallAllocs, after.largeAllocs - before.largeAllocs))
+print(string.format("lua heap peak %d kB, slabs %d kB", after.peak // 1024, after.reserved // 1024))
@@ -0,0 +1,125 @@
+// SDL_mixer and the SDL subsystems, stubbed : opening the device starts a thread that calls the
+// post mix callback on a silent buffer every half millisecond, like a device with a short buffer
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include <include/SDL.h>
+#include <include/SDL_mixer.h>
+#include <include/SDL_image.h>
+
+#include "AudioStub.hpp"
+#include "../src/Voice.hpp"
+
+static std::thread device;
+static std::atomic<bool> opened(false), stalled(false);
+static std::atomic<unsigned long long> callbacks(0);
+static int frequency = 0, channels = 0;
+static Uint16 format = 0;
+static int chunksize = 0;
+static void (SDLCALL* postMix)(void*, Uint8*, int) = NULL;
+static void* postMixData = NULL;
+static SDL_SpinLock postMixLock = 0;
+
+static void run()
+{
+    int len = chunksize * channels * SDL_AUDIO_BITSIZE(format) / 8;
+    Uint8* buffer = new Uint8[len];
+    while (opened)
+    {
+        if (!stalled)
+        {
+            memset(buffer, 0, len);
+            SDL_AtomicLock(&postMixLock);
+            if (postMix != NULL) postMix(postMixData, buffer, len);
+            SDL_AtomicUnlock(&postMixLock);
+            callbacks++;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    delete[] buffer;
+}
+
+// the SDL_mixer channels aren't built, the native mixer only reads their limit
+int Voice_GetLimit()
+{
+    return VOICE_DEFAULT_LIMIT;
+}
+
+void Device_Stall(bool s)
+{
+    stalled = s;
+}
+unsigned long long Device_GetCallbacks()
+{
+    return callbacks;
+}
+
+extern "C"
+{
+int Mix_OpenAudioDevice(int f, Uint16 fmt, int c, int chunk, const char* name, int changes)
+{
+    frequency = f;
+    format = fmt;
+    channels = c;
+    chunksize = chunk;
+    opened = true;
+    device = std::thread(run);
+    return 0;
+}
+int Mix_QuerySpec(int* f, Uint16* fmt, int* c)
+{
+    *f = frequency;
+    *fmt = format;
+    *c = channels;
+    return opened ? 1 : 0;
+}
+void Mix_SetPostMix(void (SDLCALL* mix)(void*, Uint8*, int), void* arg)
+{
+    SDL_AtomicLock(&postMixLock);
+    postMix = mix;
+    postMixData = arg;
+    SDL_AtomicUnlock(&postMixLock);
+}
+void Mix_CloseAudio(void)
+{
+    // a stalled device is let go, like SDL closing it
+    stalled = false;
+    opened = false;
+    if (device.joinable()) device.join();
+}
+int Mix_Init(int flags)
+{
+    return flags;
+}
+void Mix_Quit(void)
+{
+}
+int IMG_Init(int flags)
+{
+    return flags;
+}
+void IMG_Quit(void)
+{
+}
+
+static Uint32 inited = 0;
+int SDL_InitSubSystem(Uint32 flags)
+{
+    inited |= flags;
+    return 0;
+}
+void SDL_QuitSubSystem(Uint32 flags)
+{
+    inited &= ~flags;
+}
+Uint32 SDL_WasInit(Uint32 flags)
+{
+    return inited & flags;
+}
+void SDL_Quit(void)
+{
+    inited = 0;
+}
+}
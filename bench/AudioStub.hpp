@@ -0,0 +1,8 @@
+#ifndef AUDIOSTUB_HPP
+#define AUDIOSTUB_HPP
+
+// the stubbed device stops calling the post mix callback until resumed
+void Device_Stall(bool stalled);
+// callbacks run so far
+unsigned long long Device_GetCallbacks();
+#endif
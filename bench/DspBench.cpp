@@ -0,0 +1,147 @@
+// effects : times each effect type on noise, checks that a send rings the same tail as the effects
+// run on the voice and keeps ringing after the voice ended, then swaps sends and bus chains while
+// the stubbed device runs the callback, stalling it, so ASan or TSan catch a line freed too early
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+// the sends are static, the effects are built in this file
+#include "../src/Dsp.cpp"
+#include "AudioStub.hpp"
+
+#define BENCH_FRAMES 512
+#define BENCH_SECONDS 10
+
+static unsigned seed = 1;
+static void noise(float* samples, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        samples[i] = ((seed >> 16) & 0x7fff) / 32768.0f - 0.5f;
+    }
+}
+
+static void timeEffects(const AudioSpec* spec)
+{
+    static float block[BENCH_FRAMES * 2];
+    int blocks = spec->frequency * BENCH_SECONDS / BENCH_FRAMES;
+    for (int t = DSP_LOWPASS; t <= DSP_REVERB; t++)
+    {
+        DspParams params;
+        Dsp_Defaults((DspType)t, &params);
+        DspEffect* effect = Dsp_Create(&params, spec);
+
+        double sum = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (int b = 0; b < blocks; b++)
+        {
+            noise(block, BENCH_FRAMES * 2);
+            Dsp_Process(effect, block, sizeof(block));
+            sum += block[0];
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // the noise is part of the time, it is the same for every type
+        printf("%-8s %6.2f us per callback, %.3f%% of a core (%g)\n", dspTypes[t],
+            seconds * 1000000.0 / blocks, seconds / BENCH_SECONDS * 100.0, sum);
+        Dsp_Destroy(effect);
+    }
+}
+
+// a voice of BENCH_FRAMES of noise through a delay then a reverb, once on the voice as before,
+// once through the send with the voice ending after its chunk
+static void checkTail(const AudioSpec* spec)
+{
+    DspParams params[2];
+    Dsp_Defaults(DSP_DELAY, &params[0]);
+    Dsp_Defaults(DSP_REVERB, &params[1]);
+    DspEffect* chain[2] = { Dsp_Create(&params[0], spec), Dsp_Create(&params[1], spec) };
+    static int owner;
+    DspSend* send = Dsp_GetSend(&owner, params, 2, spec);
+
+    static float voice[BENCH_FRAMES * 2], dry[BENCH_FRAMES * 2], out[BENCH_FRAMES * 2];
+    noise(voice, BENCH_FRAMES * 2);
+    double error = 0.0;
+    int rung = 0, ran = 0;
+    double ringing = 0.0, idle = 0.0;
+    for (int b = 0; b < spec->frequency * 20 / BENCH_FRAMES; b++)
+    {
+        // only the first callback has the voice, the chain on the voice stops with it
+        if (b == 0) memcpy(dry, voice, sizeof(dry));
+        else memset(dry, 0, sizeof(dry));
+        memcpy(out, dry, sizeof(out));
+        if (b == 0)
+        {
+            // fed in two halves, as a looping voice is
+            Dsp_Feed(send, 3, dry, sizeof(dry) / 2, 1.0f);
+            Dsp_Feed(send, 3, dry + BENCH_FRAMES, sizeof(dry) / 2, 1.0f);
+        }
+        auto start = std::chrono::steady_clock::now();
+        Dsp_ProcessSends((Uint8*)out, sizeof(out));
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        processChain(chain, 2, dry, sizeof(dry));
+        float peak = 0.0f;
+        for (int i = 0; i < BENCH_FRAMES * 2; i++)
+        {
+            error = std::max(error, (double)fabsf(out[i] - dry[i]));
+            peak = std::max(peak, fabsf(out[i]));
+        }
+        if (peak >= DSP_SILENCE) rung = b + 1;
+        if (send->idle < send->span || b == 0)
+        {
+            ran = b + 1;
+            ringing += us;
+        }
+        else idle += us;
+    }
+    int total = spec->frequency * 20 / BENCH_FRAMES;
+    printf("send : error %g against the voice chain, rang for %d ms after a %d ms voice, ran %d ms,\n"
+        "       %.2f us per callback ringing, %.3f us once quiet\n",
+        error, rung * BENCH_FRAMES * 1000 / spec->frequency, BENCH_FRAMES * 1000 / spec->frequency,
+        ran * BENCH_FRAMES * 1000 / spec->frequency, ringing / std::max(ran, 1), idle / std::max(total - ran, 1));
+
+    Dsp_ReleaseSend(&owner);
+    Dsp_Destroy(chain[0]);
+    Dsp_Destroy(chain[1]);
+}
+
+int main()
+{
+    AudioSpec spec = { 48000, AUDIO_F32SYS, 2, BENCH_FRAMES };
+    timeEffects(&spec);
+    checkTail(&spec);
+
+    spec.format = AUDIO_S16SYS;
+    if (!Audio_Open(&spec)) return 1;
+    DspParams params[2];
+    Dsp_Defaults(DSP_REVERB, &params[0]);
+    Dsp_Defaults(DSP_DELAY, &params[1]);
+    static int owners[DSP_SENDS + 1];
+    int sends = 0, full = 0;
+    for (int round = 0; round < 2000; round++)
+    {
+        // the device stops calling back for longer than the game thread waits
+        if (round == 500 || round == 1500) Device_Stall(true);
+        if (round == 505 || round == 1505) Device_Stall(false);
+
+        const void* owner = &owners[rand() % (DSP_SENDS + 1)];
+        if (rand() % 2 == 0)
+        {
+            if (Dsp_GetSend(owner, params, 2, Audio_GetSpec()) != NULL) sends++;
+            else full++;
+        }
+        else Dsp_ReleaseSend(owner);
+        if (rand() % 16 == 0) Dsp_SetBus(params, 1 + rand() % 2, Audio_GetSpec());
+        Audio_Reclaim();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    printf("%d sends got, %d refused with every send taken, %llu callbacks\n", sends, full, Device_GetCallbacks());
+    Audio_Close();
+    Dsp_SetBus(NULL, 0, &spec);
+    return 0;
+}
@@ -0,0 +1,163 @@
+// native mixer : checks the simd kernels against the scalar ones on random data, then plays
+// and releases sounds from the game thread while the stubbed device runs the callback, including
+// while the callback stalls, so ASan or TSan catch samples read after they were freed
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+// the kernels are static, the mixer is built in this file
+#include "../src/Mixer.cpp"
+#include "AudioStub.hpp"
+
+static std::atomic<int> freed(0);
+static void freeSamples(void* samples)
+{
+    // poisoned first, so a late read mixes garbage even without ASan
+    memset(samples, 0x55, 4);
+    free(samples);
+    freed++;
+}
+
+static void checkKernels()
+{
+    const int N = 1000;
+    static Sint16 src[N];
+    static float fsrc[N];
+    srand(1);
+    for (int i = 0; i < N; i++)
+    {
+        src[i] = (Sint16)(rand() % 65536 - 32768);
+        fsrc[i] = (rand() % 2000 - 1000) / 1000.0f;
+    }
+    float gains[2] = { 0.7f, 0.3f };
+
+    MixerKernels all[3] = {
+        { mixS16Scalar, mixF32Scalar, outS16Scalar, outF32Scalar, "scalar" },
+#ifdef MIXER_X86
+        { mixS16SSE2, mixF32SSE2, outS16SSE2, outF32SSE2, "sse2" },
+        { mixS16AVX2, mixF32AVX2, outS16AVX2, outF32AVX2, "avx2" }
+#endif
+    };
+    int count = 1;
+#ifdef MIXER_X86
+    count = SDL_HasAVX2() ? 3 : 2;
+#endif
+
+    static float ref[N], refF32[N];
+    static Sint16 refOut[N];
+    for (int k = 0; k < count; k++)
+    {
+        // odd lengths go through the scalar tails too
+        static float acc[N], accF32[N], outF32[N];
+        static Sint16 out[N];
+        memset(acc, 0, sizeof(acc));
+        memset(accF32, 0, sizeof(accF32));
+        for (int i = 0; i < N; i++)
+        {
+            out[i] = src[(i * 7) % N] / 2;
+            outF32[i] = fsrc[(i * 3) % N];
+        }
+        all[k].mixS16(acc, src, N - 3, gains);
+        all[k].outS16(out, acc, N - 3);
+        all[k].mixF32(accF32, fsrc, N - 1, gains);
+        all[k].outF32(outF32, accF32, N - 1);
+        if (k == 0)
+        {
+            memcpy(ref, acc, sizeof(ref));
+            memcpy(refOut, out, sizeof(refOut));
+            memcpy(refF32, outF32, sizeof(refF32));
+            continue;
+        }
+
+        double mixError = 0.0, f32Error = 0.0;
+        int outError = 0;
+        for (int i = 0; i < N; i++)
+        {
+            mixError = std::max(mixError, (double)fabsf(acc[i] - ref[i]));
+            outError = std::max(outError, abs(out[i] - refOut[i]));
+            f32Error = std::max(f32Error, (double)fabsf(outF32[i] - refF32[i]));
+        }
+        printf("%s : mix error %g, s16 out error %d, f32 out error %g\n", all[k].name, mixError, outError, f32Error);
+    }
+}
+
+int main()
+{
+    checkKernels();
+
+    AudioSpec spec = { 48000, AUDIO_S16SYS, 2, 512 };
+    if (!Audio_Open(&spec) || !Mixer_Start(Audio_GetSpec())) return 1;
+    for (int i = 0; i < 3; i++) Group_Create();
+    printf("kernel %s\n", Mixer_GetStats()->kernel);
+
+    int released = 0, deferred = 0;
+    for (int round = 0; round < 2000; round++)
+    {
+        // the device stops calling back for longer than the mixer waits, twice
+        if (round == 500 || round == 1500) Device_Stall(true);
+        if (round == 520 || round == 1520) Device_Stall(false);
+
+        int frames = 200 + rand() % 5000;
+        Sint16* samples = (Sint16*)malloc(frames * 4);
+        for (int i = 0; i < frames * 2; i++) samples[i] = 1000;
+        Mixer_Play(samples, frames * 4, samples, rand() % 4, rand() % 3, 0, 0.5f, 0.0f);
+        if (rand() % 4 == 0) Mixer_Pause(samples);
+        if (rand() % 8 == 0) Group_SetVolume(1 + rand() % 3, (rand() % 10) / 10.0f);
+        if (rand() % 8 == 0) Group_SetPaused(1 + rand() % 3, rand() % 2);
+        if (rand() % 16 == 0) Mixer_HaltGroup(1 + rand() % 3);
+        if (rand() % 32 == 0)
+        {
+            // the id comes back at once, as the lowest free one
+            int group = 1 + rand() % 3;
+            Mixer_Ungroup(group);
+            Group_Destroy(group);
+            Group_Create();
+        }
+        int before = freed.load();
+        Mixer_Release(samples, freeSamples, samples);
+        released++;
+        if (freed.load() == before) deferred++;
+    }
+
+    // sounds playing when the callback stalls, then so many commands the queue is full
+    // and their halts can't even be sent
+    Sint16* held[4];
+    for (int i = 0; i < 4; i++)
+    {
+        held[i] = (Sint16*)malloc(48000 * 4);
+        for (int j = 0; j < 48000 * 2; j++) held[i][j] = 1000;
+        Mixer_Play(held[i], 48000 * 4, held[i], 0, 3, -1, 0.5f, 0.0f);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    Device_Stall(true);
+    for (int i = 0; i < MIXER_COMMANDS; i++) Mixer_SetVolume(held[i % 4], 0.5f, 0.0f);
+    for (int i = 0; i < 4; i++)
+    {
+        int before = freed.load();
+        Mixer_Release(held[i], freeSamples, held[i]);
+        released++;
+        if (freed.load() == before) deferred++;
+    }
+    Device_Stall(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // keep some playing, then stop
+    static Sint16 keep[20000];
+    for (int i = 0; i < 100; i++) Mixer_Play(keep, sizeof(keep), keep + i, 0, i % 4, -1, 1.0f, 0.5f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const MixerStats* stats = Mixer_GetStats();
+    printf("voices %d, commands %llu, dropped %llu, steals %llu, drops %llu, callback %.1f us (longest %.1f)\n",
+        stats->voices, (unsigned long long)stats->commands, (unsigned long long)stats->dropped,
+        (unsigned long long)stats->steals, (unsigned long long)stats->drops, stats->callbackTime, stats->maxCallbackTime);
+    printf("%d releases deferred, freed %d of %d released sounds before the stop\n", deferred, freed.load(), released);
+
+    Mixer_Stop();
+    Audio_Close();
+    Mixer_Shutdown();
+    printf("freed %d of %d after the shutdown\n", freed.load(), released);
+    return freed.load() == released ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+-- the same track loaded as a Music, streamed, and as a Sound, decoded whole, compared by the
+-- memory categories they are accounted in and by the time each takes to load
+-- run it as the main.lua of the engine, with the track next to it ; it opens the audio device
+-- but never starts the window, so the engine exits once it is done
+local TRACK = "track.ogg"
+
+local Memory = LuaSDL.Memory
+local function bytes(category)
+    return Memory.GetStats()[category].bytes
+end
+
+-- the device is opened first, so neither load pays for it
+LuaSDL.Audio.Open()
+local spec = LuaSDL.Audio.QuerySpec()
+
+local before = bytes("music")
+local start = os.clock()
+local music = Music.new(TRACK)
+local musicTime = os.clock() - start
+local musicBytes = bytes("music") - before
+
+before = bytes("chunks")
+start = os.clock()
+local sound = Sound.new(TRACK)
+local soundTime = os.clock() - start
+local soundBytes = bytes("chunks") - before
+
+-- the decoded chunk is in the device format
+local sampleSize = ({ u8 = 1, s8 = 1, s16 = 2, s32 = 4, f32 = 4 })[spec.format]
+local seconds = soundBytes / (spec.frequency * spec.channels * sampleSize)
+print(string.format("%s, %.1f s at %d Hz, %d channels", TRACK, seconds, spec.frequency, spec.channels))
+print(string.format("Music %8.1f kB in \"music\",  loaded in %6.1f ms", musicBytes / 1024, musicTime * 1000))
+print(string.format("Sound %8.1f kB in \"chunks\", loaded in %6.1f ms", soundBytes / 1024, soundTime * 1000))
+print(string.format("the sound holds %.1f times the bytes of the music, %.1f MB more a minute",
+    soundBytes / musicBytes, (soundBytes - musicBytes) / seconds * 60 / 1048576))
+
+music:Release()
+sound:Release()
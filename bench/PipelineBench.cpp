@@ -0,0 +1,202 @@
+// render pipeline : runs the same frames serially and pipelined over a stubbed renderer whose
+// present sleeps as a gpu and vsync would, and polls window events while frames are in flight,
+// where SDL's renderer watch updates the renderer on the game thread
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include "../src/Pipeline.hpp"
+
+struct SDL_Renderer
+{
+    // set while a call uses the renderer
+    std::atomic<bool> busy;
+    int calls;
+    SDL_Rect viewport;
+};
+
+typedef struct Watch
+{
+    SDL_EventFilter filter;
+    void* data;
+} Watch;
+static std::vector<Watch> watches;
+static double presentMs = 4.0;
+// window events that found the renderer in use by the render thread
+static std::atomic<int> races(0);
+
+static void use(SDL_Renderer* renderer)
+{
+    renderer->busy = true;
+    renderer->calls++;
+}
+static void done(SDL_Renderer* renderer)
+{
+    renderer->busy = false;
+}
+static void spin(double ms)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds((long)(ms * 1000.0));
+    while (std::chrono::steady_clock::now() < end);
+}
+
+// what SDL_RendererEventWatch does on a resize
+static int SDLCALL rendererWatch(void* data, SDL_Event* event)
+{
+    SDL_Renderer* renderer = (SDL_Renderer*)data;
+    if (event->type != SDL_WINDOWEVENT) return 0;
+    if (renderer->busy) races++;
+    renderer->viewport = { 0, 0, event->window.data1, event->window.data2 };
+    return 0;
+}
+
+extern "C"
+{
+Uint32 SDL_GetWindowID(SDL_Window* window)
+{
+    return 1;
+}
+void SDL_AddEventWatch(SDL_EventFilter filter, void* data)
+{
+    watches.push_back({ filter, data });
+}
+void SDL_DelEventWatch(SDL_EventFilter filter, void* data)
+{
+    for (size_t i = 0; i < watches.size(); i++)
+    {
+        if (watches[i].filter != filter || watches[i].data != data) continue;
+        watches.erase(watches.begin() + i);
+        return;
+    }
+}
+
+SDL_Renderer* SDL_CreateRenderer(SDL_Window* window, int index, Uint32 flags)
+{
+    SDL_Renderer* renderer = new SDL_Renderer();
+    SDL_AddEventWatch(rendererWatch, renderer);
+    return renderer;
+}
+void SDL_DestroyRenderer(SDL_Renderer* renderer)
+{
+    SDL_DelEventWatch(rendererWatch, renderer);
+    delete renderer;
+}
+int SDL_SetRenderDrawColor(SDL_Renderer* renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    use(renderer); done(renderer);
+    return 0;
+}
+int SDL_GetRenderDrawColor(SDL_Renderer* renderer, Uint8* r, Uint8* g, Uint8* b, Uint8* a)
+{
+    return 0;
+}
+int SDL_RenderClear(SDL_Renderer* renderer)
+{
+    use(renderer); done(renderer);
+    return 0;
+}
+int SDL_RenderDrawPoint(SDL_Renderer* renderer, int x, int y)
+{
+    use(renderer); done(renderer);
+    return 0;
+}
+int SDL_RenderDrawRect(SDL_Renderer* renderer, const SDL_Rect* rect)
+{
+    use(renderer); done(renderer);
+    return 0;
+}
+int SDL_RenderFillRect(SDL_Renderer* renderer, const SDL_Rect* rect)
+{
+    use(renderer); done(renderer);
+    return 0;
+}
+int SDL_RenderCopy(SDL_Renderer* renderer, SDL_Texture* tex, const SDL_Rect* src, const SDL_Rect* dst)
+{
+    use(renderer); done(renderer);
+    return 0;
+}
+int SDL_RenderDrawPoints(SDL_Renderer* renderer, const SDL_Point* points, int count) { use(renderer); done(renderer); return 0; }
+int SDL_RenderDrawPointsF(SDL_Renderer* renderer, const SDL_FPoint* points, int count) { use(renderer); done(renderer); return 0; }
+int SDL_RenderDrawRects(SDL_Renderer* renderer, const SDL_Rect* rects, int count) { use(renderer); done(renderer); return 0; }
+int SDL_RenderDrawRectsF(SDL_Renderer* renderer, const SDL_FRect* rects, int count) { use(renderer); done(renderer); return 0; }
+int SDL_RenderFillRects(SDL_Renderer* renderer, const SDL_Rect* rects, int count) { use(renderer); done(renderer); return 0; }
+int SDL_RenderFillRectsF(SDL_Renderer* renderer, const SDL_FRect* rects, int count) { use(renderer); done(renderer); return 0; }
+void SDL_RenderPresent(SDL_Renderer* renderer)
+{
+    use(renderer);
+    std::this_thread::sleep_for(std::chrono::microseconds((long)(presentMs * 1000.0)));
+    done(renderer);
+}
+}
+
+// what SDL_PollEvent does with a window event : every watch sees it on the polling thread
+static void pollResize(int frame)
+{
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = SDL_WINDOWEVENT;
+    event.window.event = SDL_WINDOWEVENT_SIZE_CHANGED;
+    event.window.windowID = 1;
+    event.window.data1 = 640 + frame;
+    event.window.data2 = 480;
+    for (const Watch& watch : std::vector<Watch>(watches))
+        watch.filter(watch.data, &event);
+}
+
+static void run(bool pipelined, double updateMs, int resizeEvery)
+{
+    SDL_Renderer* renderer = pipelined ? Pipeline_Start(NULL, 0) : SDL_CreateRenderer(NULL, -1, 0);
+    static float rects[1000 * 4];
+    for (int i = 0; i < 1000 * 4; i++) rects[i] = (float)(i % 97) + 0.5f;
+
+    const int frames = 200;
+    races = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++)
+    {
+        Pipeline_BeginFrame();
+        if (resizeEvery > 0 && f % resizeEvery == 0) pollResize(f);
+        // the script updating the world
+        spin(updateMs);
+
+        PipeCommand cmd = {};
+        cmd.type = PIPE_COLOR;
+        cmd.r = cmd.g = 20;
+        cmd.b = 40;
+        cmd.a = 255;
+        Pipeline_Draw(renderer, &cmd);
+        cmd.type = PIPE_CLEAR;
+        Pipeline_Draw(renderer, &cmd);
+        for (int i = 0; i < 500; i++)
+        {
+            PipeCommand fill = {};
+            fill.type = PIPE_FILL;
+            fill.rect = { i, i, 4, 4 };
+            Pipeline_Draw(renderer, &fill);
+        }
+        Pipeline_DrawMany(renderer, PIPE_FILL, rects, true, 1000);
+        Pipeline_Present(renderer);
+    }
+    double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (pipelined) Pipeline_Stop();
+    else SDL_DestroyRenderer(renderer);
+
+    const PipelineStats* stats = Pipeline_GetStats();
+    printf("%-9s update %.0f ms : %.2f ms per frame, render %.2f, wait %.2f, latency %.2f, %d resizes raced the render thread\n",
+        pipelined ? "pipelined" : "serial", updateMs, total / frames, stats->renderTime, stats->waitTime, stats->latency, races.load());
+}
+
+// the statistics add up for the whole run, so each mode runs on its own
+// args : serial or pipelined, (optional, default : 4) update time and present time in ms
+int main(int argc, char** argv)
+{
+    bool pipelined = argc > 1 && strcmp(argv[1], "pipelined") == 0;
+    double update = (argc > 2) ? atof(argv[2]) : 4.0;
+    if (argc > 3) presentMs = atof(argv[3]);
+    run(pipelined, update, pipelined ? 10 : 0);
+    return 0;
+}
@@ -0,0 +1,119 @@
+// lua allocator : replays what a script churning small objects asks of lua_Alloc, through the
+// pools and through malloc as luaL_newstate would, and times both
+// the sizes are the ones lua 5.4 asks for on 64 bit : a Color userdata, a table, the array part
+// of {x, y}, the hash part of {x = .., y = ..} and a short string, with now and then a list growing
+// past the pools ; most die young, swept in the reverse of their creation as lua's list of objects
+// is, the rest live for a few frames
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include <include/lua.h>
+
+#include "../src/Pool.hpp"
+
+#define BENCH_FRAMES 2000
+#define BENCH_OBJECTS 5000
+#define BENCH_ROUNDS 3
+
+typedef struct Block
+{
+    void* p;
+    size_t size;
+    int death;
+} Block;
+
+static const size_t sizes[] = { 36, 56, 32, 48, 40 };
+
+static unsigned seed;
+static unsigned next()
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+// return ns per block asked for
+static double replay(lua_Alloc alloc, Uint64* blocks)
+{
+    seed = 1;
+    std::vector<Block> young, old;
+    young.reserve(BENCH_OBJECTS);
+    Uint64 count = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++)
+    {
+        for (int i = 0; i < BENCH_OBJECTS; i++)
+        {
+            Block b;
+            b.size = sizes[next() % 5];
+            b.p = alloc(NULL, NULL, 0, b.size);
+            // touched, as lua initializes what it gets
+            *(volatile char*)b.p = 0;
+            b.death = (next() % 10 == 0) ? frame + 1 + next() % 8 : frame;
+            count++;
+            if (next() % 200 == 0)
+            {
+                // a list of 8 grows to 256 values, then dies with the frame
+                size_t size = 8 * 16;
+                void* list = alloc(NULL, NULL, 0, size);
+                for (; size < 256 * 16; size *= 2)
+                {
+                    list = alloc(NULL, list, size, size * 2);
+                    count++;
+                }
+                young.push_back({ list, size, frame });
+                count++;
+            }
+            young.push_back(b);
+        }
+
+        // the sweep frees the young that died, the last created first
+        for (size_t i = young.size(); i-- > 0;)
+        {
+            if (young[i].death == frame) alloc(NULL, young[i].p, young[i].size, 0);
+            else old.push_back(young[i]);
+        }
+        young.clear();
+        size_t kept = 0;
+        for (size_t i = 0; i < old.size(); i++)
+        {
+            if (old[i].death <= frame) alloc(NULL, old[i].p, old[i].size, 0);
+            else old[kept++] = old[i];
+        }
+        old.resize(kept);
+    }
+    for (const Block& b : old) alloc(NULL, b.p, b.size, 0);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    *blocks = count;
+    return seconds * 1e9 / (double)count;
+}
+
+int main()
+{
+    double best[2] = { 1e9, 1e9 };
+    lua_Alloc allocs[2] = { Pool_Alloc, Pool_SystemAlloc };
+    const char* names[2] = { "pools", "malloc" };
+    AllocStats stats[2] = {};
+    Uint64 blocks = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            AllocStats before = *Pool_GetStats();
+            best[k] = std::min(best[k], replay(allocs[k], &blocks));
+            stats[k] = *Pool_GetStats();
+            stats[k].smallAllocs -= before.smallAllocs;
+            stats[k].largeAllocs -= before.largeAllocs;
+            Pool_Release();
+        }
+    }
+    for (int k = 0; k < 2; k++)
+        printf("%-6s %6.2f ns per block, %llu small %llu large, peak %zu kB, slabs %zu kB\n", names[k], best[k],
+            (unsigned long long)stats[k].smallAllocs, (unsigned long long)stats[k].largeAllocs,
+            stats[k].peak / 1024, stats[k].reserved / 1024);
+    printf("%llu blocks per round, the pools take %.0f%% of the time malloc does\n",
+        (unsigned long long)blocks, best[0] / best[1] * 100.0);
+    return 0;
+}
@@ -0,0 +1,196 @@
+// just enough of SDL, on top of the standard library, to run the benches without its binaries
+// only the calls the benched modules make are implemented
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <strings.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include <include/SDL.h>
+
+struct SDL_semaphore
+{
+    std::mutex mutex;
+    std::condition_variable posted;
+    Uint32 value;
+};
+struct SDL_Thread
+{
+    std::thread thread;
+    int status;
+};
+
+static Uint64 now()
+{
+    return (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+extern "C"
+{
+int SDL_SetError(const char* fmt, ...)
+{
+    return -1;
+}
+int SDL_Error(SDL_errorcode code)
+{
+    return -1;
+}
+
+Uint64 SDL_GetPerformanceCounter(void)
+{
+    return now();
+}
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+    return 1000000000ull;
+}
+Uint32 SDL_GetTicks(void)
+{
+    return (Uint32)(now() / 1000000ull);
+}
+void SDL_Delay(Uint32 ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void SDL_AtomicLock(SDL_SpinLock* lock)
+{
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+        std::this_thread::yield();
+}
+void SDL_AtomicUnlock(SDL_SpinLock* lock)
+{
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+SDL_sem* SDL_CreateSemaphore(Uint32 value)
+{
+    SDL_sem* sem = new SDL_sem;
+    sem->value = value;
+    return sem;
+}
+void SDL_DestroySemaphore(SDL_sem* sem)
+{
+    delete sem;
+}
+int SDL_SemWaitTimeout(SDL_sem* sem, Uint32 ms)
+{
+    std::unique_lock<std::mutex> lock(sem->mutex);
+    auto ready = [sem] { return sem->value > 0; };
+    if (ms == SDL_MUTEX_MAXWAIT) sem->posted.wait(lock, ready);
+    else if (!sem->posted.wait_for(lock, std::chrono::milliseconds(ms), ready)) return SDL_MUTEX_TIMEDOUT;
+    sem->value--;
+    return 0;
+}
+int SDL_SemWait(SDL_sem* sem)
+{
+    return SDL_SemWaitTimeout(sem, SDL_MUTEX_MAXWAIT);
+}
+int SDL_SemPost(SDL_sem* sem)
+{
+    {
+        std::lock_guard<std::mutex> lock(sem->mutex);
+        sem->value++;
+    }
+    sem->posted.notify_one();
+    return 0;
+}
+
+SDL_Thread* SDL_CreateThread(SDL_ThreadFunction fn, const char* name, void* data)
+{
+    SDL_Thread* thread = new SDL_Thread;
+    thread->status = 0;
+    thread->thread = std::thread([thread, fn, data] { thread->status = fn(data); });
+    return thread;
+}
+void SDL_WaitThread(SDL_Thread* thread, int* status)
+{
+    if (thread == NULL) return;
+    thread->thread.join();
+    if (status != NULL) *status = thread->status;
+    delete thread;
+}
+SDL_threadID SDL_ThreadID(void)
+{
+    return (SDL_threadID)std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+SDL_bool SDL_HasSSE2(void)
+{
+    return SDL_TRUE;
+}
+// NOAVX=1 benches the sse2 kernels on an avx2 cpu
+SDL_bool SDL_HasAVX2(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (getenv("NOAVX") == NULL && __builtin_cpu_supports("avx2")) ? SDL_TRUE : SDL_FALSE;
+#else
+    return SDL_FALSE;
+#endif
+}
+
+void* SDL_malloc(size_t size)
+{
+    return malloc(size);
+}
+void* SDL_calloc(size_t count, size_t size)
+{
+    return calloc(count, size);
+}
+void SDL_free(void* mem)
+{
+    free(mem);
+}
+void* SDL_memset(void* dst, int c, size_t len)
+{
+    return memset(dst, c, len);
+}
+void* SDL_memcpy(void* dst, const void* src, size_t len)
+{
+    return memcpy(dst, src, len);
+}
+int SDL_snprintf(char* text, size_t maxlen, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int written = vsnprintf(text, maxlen, fmt, ap);
+    va_end(ap);
+    return written;
+}
+int SDL_strcasecmp(const char* a, const char* b)
+{
+    return strcasecmp(a, b);
+}
+char* SDL_strrchr(const char* str, int c)
+{
+    return (char*)strrchr(str, c);
+}
+void* SDL_SIMDAlloc(const size_t len)
+{
+    return aligned_alloc(64, (len + 63) / 64 * 64);
+}
+void SDL_SIMDFree(void* ptr)
+{
+    free(ptr);
+}
+
+// there is no renderer nor rwops, the benched modules only pass them through
+int SDL_QueryTexture(SDL_Texture* texture, Uint32* format, int* access, int* w, int* h)
+{
+    return -1;
+}
+SDL_RWops* SDL_RWFromFile(const char* file, const char* mode)
+{
+    return NULL;
+}
+SDL_RWops* SDL_RWFromConstMem(const void* mem, int size)
+{
+    return NULL;
+}
+}
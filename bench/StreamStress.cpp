@@ -0,0 +1,70 @@
+// audio streams : creates, feeds and destroys streams while the stubbed device runs the callback,
+// including a callback that stalls halfway through the slots, so ASan or TSan catch a stream
+// freed while the callback still holds it, and LeakSanitizer one that is never freed
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <chrono>
+
+// the slots are static, the streams are built in this file
+#include "../src/Stream.cpp"
+#include "AudioStub.hpp"
+
+// what a callback stuck inside Stream_Process does : it took the streams, then reads them late
+static void stalledPass(std::atomic<bool>* holding, int ms)
+{
+    Audio_BeginPass();
+    Stream* held[STREAM_SLOTS];
+    for (int i = 0; i < STREAM_SLOTS; i++)
+        held[i] = slots[i].load();
+    *holding = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    int fill = 0;
+    for (int i = 0; i < STREAM_SLOTS; i++)
+        if (held[i] != NULL) fill += (int)Ring_Count(&held[i]->ring);
+    Audio_EndPass();
+    printf("stalled pass read %d frames\n", fill);
+}
+
+int main()
+{
+    AudioSpec spec = { 48000, AUDIO_S16SYS, 2, 512 };
+    if (!Audio_Open(&spec)) return 1;
+
+    float block[256];
+    for (int i = 0; i < 256; i++) block[i] = (i % 2) ? 0.5f : -0.5f;
+    for (int round = 0; round < 3000; round++)
+    {
+        Stream* stream = Stream_Create(1 + round % 2, 1000);
+        stream->playing = true;
+        for (int k = 0; k < 4; k++) Stream_Write(stream, block, 128 / stream->channels);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        Stream_Destroy(stream);
+    }
+
+    // destroyed while the callback holds it, the stream must outlive the pass
+    Stream* stream = Stream_Create(2, 4096);
+    stream->playing = true;
+    Stream_Write(stream, block, 128);
+    Device_Stall(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    std::atomic<bool> holding(false);
+    std::thread stalled(stalledPass, &holding, AUDIO_WAIT_TIMEOUT * 2);
+    while (!holding) std::this_thread::yield();
+    Uint32 start = SDL_GetTicks();
+    Stream_Destroy(stream);
+    printf("destroy gave up after %u ms\n", SDL_GetTicks() - start);
+    stalled.join();
+    Device_Stall(false);
+    Audio_Reclaim();
+
+    stream = Stream_Create(2, 4096);
+    stream->playing = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    printf("underruns %llu, fill %d of %d\n", (unsigned long long)stream->underruns.load(), Stream_GetFill(stream), Stream_GetCapacity(stream));
+    Stream_Destroy(stream);
+
+    Audio_Close();
+    return 0;
+}
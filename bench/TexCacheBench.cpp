@@ -0,0 +1,119 @@
+// texture cache : loads a set of png images three times, as the engine's startup would, and times
+// each pass : decoded without the cache, decoded then stored on a cold cache, mapped from the warm
+// cache. libpng decodes, as it does behind SDL_image, and a swizzle stands for the conversion to
+// the renderer's format
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <chrono>
+
+#include <png.h>
+
+#include <include/lua.hpp>
+
+#include "../src/TexCache.hpp"
+#include "../src/Pak.hpp"
+
+// Memory.cpp reads the lua heap, there is no state here
+int lua_gc(lua_State*, int, ...)
+{
+    return 0;
+}
+
+static int imageSize = 512;
+
+// a gradient with noise, about as compressible as game art
+static void writeImage(const std::string& path, int index)
+{
+    std::vector<Uint8> rgba((size_t)imageSize * imageSize * 4);
+    unsigned seed = (unsigned)index + 1;
+    for (int y = 0; y < imageSize; y++)
+        for (int x = 0; x < imageSize; x++)
+        {
+            seed = seed * 1103515245 + 12345;
+            Uint8* p = &rgba[((size_t)y * imageSize + x) * 4];
+            p[0] = (Uint8)(x + index);
+            p[1] = (Uint8)(y * 2);
+            p[2] = (Uint8)((x ^ y) + ((seed >> 16) & 15));
+            p[3] = (x / 32 + y / 32) % 3 == 0 ? 0 : 255;
+        }
+    png_image image = {};
+    image.version = PNG_IMAGE_VERSION;
+    image.width = imageSize;
+    image.height = imageSize;
+    image.format = PNG_FORMAT_RGBA;
+    png_image_write_to_file(&image, path.c_str(), 0, rgba.data(), 0, NULL);
+}
+
+// what loadImage does on a miss : decode, convert, and store when the cache is on
+static bool decodeImage(const std::string& path, SDL_Surface* surf, std::vector<Uint8>& pixels)
+{
+    png_image image = {};
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, path.c_str())) return false;
+    image.format = PNG_FORMAT_BGRA;
+    pixels.resize(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, NULL, pixels.data(), 0, NULL)) return false;
+
+    surf->w = (int)image.width;
+    surf->h = (int)image.height;
+    surf->pitch = (int)PNG_IMAGE_ROW_STRIDE(image);
+    surf->pixels = pixels.data();
+    TexCache_Store(path.c_str(), surf);
+    return true;
+}
+
+// what loadImage does on a hit, copying into a surface as gpu resident images don't need to
+static bool mapImage(const std::string& path, std::vector<Uint8>& pixels)
+{
+    TexCacheEntry cached;
+    if (!TexCache_Open(path.c_str(), SDL_PIXELFORMAT_ARGB8888, &cached)) return false;
+    pixels.resize((size_t)cached.pitch * cached.h);
+    memcpy(pixels.data(), cached.pixels, pixels.size());
+    TexCache_Close(&cached);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 100;
+    if (argc > 2) imageSize = atoi(argv[2]);
+    namespace fs = std::filesystem;
+    std::string root = "texbench";
+    fs::remove_all(root);
+    fs::create_directories(root + "/assets");
+
+    std::vector<std::string> paths;
+    Uint64 encoded = 0;
+    for (int i = 0; i < count; i++)
+    {
+        paths.push_back(root + "/assets/" + std::to_string(i) + ".png");
+        writeImage(paths.back(), i);
+        encoded += fs::file_size(paths.back());
+    }
+    printf("%d images of %dx%d, %.1f MB of png, %.1f MB decoded\n", count, imageSize, imageSize,
+        encoded / 1048576.0, (double)count * imageSize * imageSize * 4 / 1048576.0);
+
+    SDL_PixelFormat format = {};
+    format.format = SDL_PIXELFORMAT_ARGB8888;
+    SDL_Surface surf = {};
+    surf.format = &format;
+    std::vector<Uint8> pixels;
+    const char* passes[3] = { "no cache", "cold", "warm" };
+    for (int pass = 0; pass < 3; pass++)
+    {
+        TexCache_SetDir(pass == 0 ? NULL : (root + "/cache").c_str());
+        int loaded = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& path : paths)
+            if (pass == 2 ? mapImage(path, pixels) : decodeImage(path, &surf, pixels)) loaded++;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printf("%-8s %8.1f ms, %.2f ms per image, %d loaded\n", passes[pass], ms, ms / count, loaded);
+    }
+
+    fs::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,105 @@
+-- Vec2 batch functions against the same work in a lua loop, on 10k vectors
+-- run it as the main.lua of the engine, it never starts SDL so the engine exits once it is done
+local COUNT = 10000
+local ROUNDS = 200
+
+-- the same vectors in a Float32Array and in a table, as a script would keep them without one
+local function vectors()
+    local arr, t = Float32Array.new(COUNT * 2), {}
+    for i = 1, COUNT * 2 do
+        local v = (i % 97) / 97 - 0.5
+        arr[i] = v
+        t[i] = v
+    end
+    return arr, t
+end
+
+-- ns per vector of fn, once warmed up, and the part of it spent in the native kernel
+local function time(fn)
+    fn()
+    local before = Vec2.GetStats()
+    local start = os.clock()
+    for _ = 1, ROUNDS do fn() end
+    local ns = (os.clock() - start) * 1e9 / (ROUNDS * COUNT)
+    local after = Vec2.GetStats()
+    local vectors = after.vectors - before.vectors
+    local kernel = (vectors > 0) and (after.time - before.time) * 1e3 / vectors or 0
+    return ns, kernel
+end
+
+local function report(name, native, kernel, loop, arrayLoop)
+    print(string.format("%-10s native %6.2f ns (kernel %5.2f), lua loop %6.2f ns, %5.1fx faster, loop over the array %6.2f ns",
+        name, native, kernel, loop, loop / native, arrayLoop))
+end
+
+local dst, tdst = vectors()
+local src, tsrc = vectors()
+local adst = vectors()
+local native, kernel = time(function() Vec2.AddScaledArray(dst, src, 0.5) end)
+local loop = time(function()
+    for i = 1, COUNT * 2 do tdst[i] = tdst[i] + tsrc[i] * 0.5 end
+end)
+-- the array goes through __index and __newindex for each number
+local arrayLoop = time(function()
+    for i = 1, COUNT * 2 do adst[i] = adst[i] + src[i] * 0.5 end
+end)
+report("addscaled", native, kernel, loop, arrayLoop)
+
+-- both did the same rounds, only the float rounding may differ
+local difference = 0
+for i = 1, COUNT * 2 do difference = math.max(difference, math.abs(dst[i] - tdst[i])) end
+print(string.format("addscaled  largest difference with the lua loop %g", difference))
+
+local v, tv = vectors()
+local av = vectors()
+native, kernel = time(function() Vec2.RotateArray(v, 0.01) end)
+local c, s = math.cos(0.01), math.sin(0.01)
+loop = time(function()
+    for i = 1, COUNT * 2, 2 do
+        local x, y = tv[i], tv[i + 1]
+        tv[i], tv[i + 1] = x * c - y * s, x * s + y * c
+    end
+end)
+arrayLoop = time(function()
+    for i = 1, COUNT * 2, 2 do
+        local x, y = av[i], av[i + 1]
+        av[i], av[i + 1] = x * c - y * s, x * s + y * c
+    end
+end)
+report("rotate", native, kernel, loop, arrayLoop)
+
+v, tv = vectors()
+av = vectors()
+native, kernel = time(function() Vec2.NormalizeArray(v) end)
+loop = time(function()
+    for i = 1, COUNT * 2, 2 do
+        local x, y = tv[i], tv[i + 1]
+        local length = math.sqrt(x * x + y * y)
+        if length > 0 then tv[i], tv[i + 1] = x / length, y / length end
+    end
+end)
+arrayLoop = time(function()
+    for i = 1, COUNT * 2, 2 do
+        local x, y = av[i], av[i + 1]
+        local length = math.sqrt(x * x + y * y)
+        if length > 0 then av[i], av[i + 1] = x / length, y / length end
+    end
+end)
+report("normalize", native, kernel, loop, arrayLoop)
+
+v, tv = vectors()
+local out, tout = Float32Array.new(COUNT), {}
+native, kernel = time(function() Vec2.LengthArray(v, out) end)
+loop = time(function()
+    for i = 1, COUNT do
+        local x, y = tv[i * 2 - 1], tv[i * 2]
+        tout[i] = math.sqrt(x * x + y * y)
+    end
+end)
+arrayLoop = time(function()
+    for i = 1, COUNT do
+        local x, y = v[i * 2 - 1], v[i * 2]
+        out[i] = math.sqrt(x * x + y * y)
+    end
+end)
+report("length", native, kernel, loop, arrayLoop)
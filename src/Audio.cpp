@@ -0,0 +1,235 @@
+#include <vector>
+#include <atomic>
+
+#include <include/SDL.h>
+#include <include/SDL_mixer.h>
+
+#include "Audio.hpp"
+#include "Mixer.hpp"
+#include "Stream.hpp"
+#include "Dsp.hpp"
+#include "Spectrum.hpp"
+#include "Subsystem.hpp"
+
+static bool opened = false;
+static AudioSpec obtained = { 0, 0, 0, 0 };
+
+// written by the mixer thread, read under the lock
+static SDL_SpinLock statsLock = 0;
+static Uint64 lastCallback = 0;
+static double intervalSum = 0.0, intervalMax = 0.0;
+static Uint64 callbacks = 0;
+static int callbackFrames = 0;
+static AudioStats stats = { 0, 0.0, 0.0, 0.0, { 0 }, 0, 0, 0, -1 };
+
+// odd while the callback runs a pass
+static std::atomic<Uint32> epoch(0);
+
+// freed once the pass that was running when it was retired ended
+typedef struct Retired
+{
+    AudioFree free;
+    void* data;
+    Uint32 epoch;
+} Retired;
+static std::vector<Retired> retired;
+
+static int histogramBucket(double us)
+{
+    int bucket = 0;
+    for (double edge = AUDIO_HISTOGRAM_BASE; us >= edge && bucket < AUDIO_HISTOGRAM_BUCKETS - 1; edge *= 2.0)
+        bucket++;
+    return bucket;
+}
+
+static void SDLCALL postMix(void*, Uint8* stream, int len)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    int frameSize = SDL_AUDIO_BITSIZE(obtained.format) / 8 * obtained.channels;
+    int frames = (frameSize > 0) ? len / frameSize : 0;
+    double budget = (obtained.frequency > 0) ? frames * 1000000.0 / obtained.frequency : 0.0;
+
+    Audio_BeginPass();
+    Mixer_Process(stream, len);
+    int lowest;
+    int dry = Stream_Process(stream, len, &obtained, &lowest);
+    Dsp_ProcessSends(stream, len);
+    Dsp_ProcessBus(stream, len);
+    Spectrum_Tap(stream, len, &obtained);
+    Audio_EndPass();
+
+    double us = (double)(SDL_GetPerformanceCounter() - now) * 1000000.0 / frequency;
+
+    SDL_AtomicLock(&statsLock);
+    // a callback half a buffer late may have let the device play out what it had
+    bool late = false;
+    if (lastCallback != 0)
+    {
+        double interval = (double)(now - lastCallback) * 1000.0 / frequency;
+        intervalSum += interval;
+        if (interval > intervalMax) intervalMax = interval;
+        callbacks++;
+        late = interval * 1000.0 > budget * 1.5;
+    }
+    lastCallback = now;
+    callbackFrames = frames;
+
+    stats.callbacks++;
+    stats.callbackTime += us;
+    if (us > stats.maxCallbackTime) stats.maxCallbackTime = us;
+    stats.budget = budget;
+    stats.histogram[histogramBucket(us)]++;
+    if (late) stats.late++;
+    if (dry > 0) stats.underruns++;
+    if (us > budget) stats.overruns++;
+    stats.fill = lowest;
+    SDL_AtomicUnlock(&statsLock);
+}
+
+bool Audio_Open(const AudioSpec* spec)
+{
+    Audio_Close();
+
+    if (!Subsystem_Init(SDL_INIT_AUDIO))
+        return false;
+    if (Mix_OpenAudioDevice(spec->frequency, spec->format, spec->channels, spec->chunksize,
+        NULL, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE) != 0)
+    {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    int frequency, channels;
+    Uint16 format;
+    Mix_QuerySpec(&frequency, &format, &channels);
+    obtained.frequency = frequency;
+    obtained.format = format;
+    obtained.channels = channels;
+    obtained.chunksize = spec->chunksize;
+
+    lastCallback = 0;
+    intervalSum = intervalMax = 0.0;
+    callbacks = 0;
+    callbackFrames = 0;
+    Audio_ResetStats();
+    Mix_SetPostMix(postMix, NULL);
+    opened = true;
+    return true;
+}
+void Audio_Close()
+{
+    if (!opened) return;
+
+    Mix_SetPostMix(NULL, NULL);
+    Mix_CloseAudio();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    opened = false;
+    // the last pass ended with the device
+    Dsp_CloseSends();
+    Audio_Reclaim();
+}
+bool Audio_IsOpen()
+{
+    return opened;
+}
+const AudioSpec* Audio_GetSpec()
+{
+    SDL_AtomicLock(&statsLock);
+    if (callbackFrames > 0)
+        obtained.chunksize = callbackFrames;
+    SDL_AtomicUnlock(&statsLock);
+    return &obtained;
+}
+AudioLatency Audio_GetLatency()
+{
+    AudioLatency latency;
+    const AudioSpec* spec = Audio_GetSpec();
+
+    SDL_AtomicLock(&statsLock);
+    latency.buffer = (spec->frequency > 0) ? spec->chunksize * 1000.0 / spec->frequency : 0.0;
+    latency.estimate = latency.buffer * 2.0;
+    latency.interval = (callbacks > 0) ? intervalSum / (double)callbacks : 0.0;
+    latency.maxInterval = intervalMax;
+    latency.callbacks = callbacks;
+    SDL_AtomicUnlock(&statsLock);
+    return latency;
+}
+AudioStats Audio_GetStats()
+{
+    SDL_AtomicLock(&statsLock);
+    AudioStats copy = stats;
+    SDL_AtomicUnlock(&statsLock);
+
+    // summed while running
+    if (copy.callbacks > 0)
+        copy.callbackTime /= (double)copy.callbacks;
+    return copy;
+}
+void Audio_ResetStats()
+{
+    SDL_AtomicLock(&statsLock);
+    SDL_zero(stats);
+    stats.fill = -1;
+    SDL_AtomicUnlock(&statsLock);
+}
+
+bool Audio_Wait(bool (*done)(void* data), void* data)
+{
+    Uint32 start = SDL_GetTicks();
+    while (!done(data))
+    {
+        if (!opened || SDL_GetTicks() - start > AUDIO_WAIT_TIMEOUT) return false;
+        SDL_Delay(1);
+    }
+    return true;
+}
+
+void Audio_BeginPass()
+{
+    // sequentially consistent with the game thread, see isHeld
+    epoch.fetch_add(1);
+}
+void Audio_EndPass()
+{
+    epoch.fetch_add(1, std::memory_order_release);
+}
+
+// the game thread took data out of reach before reading the epoch, both sequentially consistent,
+// so only a pass already running when it was read may hold it
+static bool isHeld(Uint32 seen)
+{
+    return (seen & 1) && epoch.load(std::memory_order_acquire) == seen;
+}
+static bool isReleased(void* seen)
+{
+    return !isHeld(*(Uint32*)seen);
+}
+void Audio_Retire(AudioFree free, void* data)
+{
+    Uint32 seen = epoch.load();
+    Audio_Wait(isReleased, &seen);
+    if (isHeld(seen))
+    {
+        Retired r = { free, data, seen };
+        retired.push_back(r);
+    }
+    else
+        free(data);
+    Audio_Reclaim();
+}
+void Audio_Reclaim()
+{
+    for (size_t i = 0; i < retired.size();)
+    {
+        if (isHeld(retired[i].epoch))
+        {
+            i++;
+            continue;
+        }
+        Retired r = retired[i];
+        retired[i] = retired.back();
+        retired.pop_back();
+        r.free(r.data);
+    }
+}
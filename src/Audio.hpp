@@ -0,0 +1,90 @@
+#ifndef AUDIO_HPP
+#define AUDIO_HPP
+
+#include <include/SDL.h>
+#include <include/SDL_mixer.h>
+
+// defaults favour latency : the device rate avoids resampling,
+// and 512 frames are about 10 ms at 48 kHz
+#define AUDIO_DEFAULT_FREQUENCY 48000
+#define AUDIO_DEFAULT_FORMAT AUDIO_S16SYS
+#define AUDIO_DEFAULT_CHANNELS 2
+#define AUDIO_DEFAULT_CHUNKSIZE 512
+
+typedef struct AudioSpec
+{
+	int frequency;
+	SDL_AudioFormat format;
+	int channels;
+	// frames mixed per callback
+	int chunksize;
+} AudioSpec;
+
+// callbacks faster than this go in the first bucket of the histogram, in microseconds
+// each next bucket is twice as wide, the last one holds everything slower
+#define AUDIO_HISTOGRAM_BASE 32.0
+#define AUDIO_HISTOGRAM_BUCKETS 10
+
+typedef struct AudioStats
+{
+	Uint64 callbacks;
+	// average and longest time spent in the post mix callback, and the time a callback has
+	// before the device runs out, in microseconds
+	double callbackTime, maxCallbackTime, budget;
+	// callbacks by time spent
+	Uint64 histogram[AUDIO_HISTOGRAM_BUCKETS];
+	// callbacks more than half a buffer after the previous one, jitter the device may have absorbed
+	Uint64 late;
+	// callbacks where a playing stream ran dry
+	Uint64 underruns;
+	// callbacks that took longer than their budget
+	Uint64 overruns;
+	// frames queued in the emptiest playing stream at the last callback, -1 if none plays
+	int fill;
+} AudioStats;
+
+typedef struct AudioLatency
+{
+	// time the mixer buffer holds, in milliseconds
+	double buffer;
+	// estimated output latency, in milliseconds : the buffer being mixed and the one SDL plays,
+	// the system adds its own on top, which SDL doesn't report
+	double estimate;
+	// average and longest time between two mixer callbacks, in milliseconds, how regular the
+	// device calls back rather than how late the sound is heard
+	double interval, maxInterval;
+	Uint64 callbacks;
+} AudioLatency;
+
+// longest a game thread waits for the callback, in case the device stopped calling it
+#define AUDIO_WAIT_TIMEOUT 250
+
+// frees what the audio callback may have been reading, once it let go of it
+typedef void (*AudioFree)(void* data);
+
+// open the device, closing it first if it was open, the obtained spec may differ
+// the device may change the frequency, formats and channels are converted by SDL
+bool Audio_Open(const AudioSpec* spec);
+void Audio_Close();
+bool Audio_IsOpen();
+// get the spec the device was opened with, chunksize is known after the first callback
+const AudioSpec* Audio_GetSpec();
+// get the latency estimated from the spec, and the callback intervals
+AudioLatency Audio_GetLatency();
+// get the callback instrumentation, and start it over
+AudioStats Audio_GetStats();
+void Audio_ResetStats();
+
+// wait for done(data) to return true while the callback runs, up to AUDIO_WAIT_TIMEOUT
+// return false if it didn't in time or the device is closed
+bool Audio_Wait(bool (*done)(void* data), void* data);
+// the callback marks each pass, everything it reads from the game thread is held until the pass ends
+void Audio_BeginPass();
+void Audio_EndPass();
+// free data once no pass can hold it anymore, data must be out of the callback's reach already
+// it is freed right away when no pass is running, after the pass when it ends in time,
+// and otherwise by Audio_Reclaim, never while a pass may still hold it
+void Audio_Retire(AudioFree free, void* data);
+// free what was retired and is no longer held, once per frame
+void Audio_Reclaim();
+#endif
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <include/SDL.h>
+
+#include <include/lua.hpp>
+
+#include "Bundle.hpp"
+#include "Pak.hpp"
+
+static Pak bundle = {};
+
+static int dumpWriter(lua_State*, const void* p, size_t size, void* ud)
+{
+    ((std::string*)ud)->append((const char*)p, size);
+    return 0;
+}
+
+bool Bundle_Build(const char* out, const char* root)
+{
+    std::vector<PakInput> inputs;
+    if (!Pak_List(root, ".lua", inputs)) return false;
+
+    lua_State* L = luaL_newstate();
+    for (PakInput& input : inputs)
+    {
+        if (luaL_loadfile(L, input.path.c_str()) != LUA_OK)
+        {
+            std::cout << "Can't compile script :\n" << lua_tostring(L, -1) << std::endl;
+            lua_close(L);
+            return false;
+        }
+        // stripped : no debug information, smaller and faster to load
+        lua_dump(L, dumpWriter, &input.data, 1);
+        lua_pop(L, 1);
+        input.path.clear();
+    }
+    lua_close(L);
+
+    return Pak_Write(out, inputs);
+}
+
+bool Bundle_Open(const char* path)
+{
+    Bundle_Close();
+    return Pak_Open(&bundle, path);
+}
+void Bundle_Close()
+{
+    Pak_Close(&bundle);
+}
+
+// status of loadBundled when fn has to be loaded from source
+#define BUNDLE_NOTFOUND (-1)
+
+// load the bundled chunk of fn on the stack
+// return the luaL_loadbuffer status, or BUNDLE_NOTFOUND with the reason on the stack
+static int loadBundled(lua_State* L, const char* fn)
+{
+    const PakEntry* e = Pak_Find(&bundle, fn);
+    if (e == NULL)
+    {
+        lua_pushfstring(L, "no bundled file '%s'", fn);
+        return BUNDLE_NOTFOUND;
+    }
+    // sources shipped next to the bundle win when they were edited since
+    Sint64 mtime = FileModTime(fn);
+    if (mtime >= 0 && mtime != e->mtime)
+    {
+        lua_pushfstring(L, "bundled file '%s' is stale", fn);
+        return BUNDLE_NOTFOUND;
+    }
+
+    std::string chunkname = std::string("@") + fn;
+    return luaL_loadbufferx(L, (const char*)Pak_EntryData(&bundle, e), (size_t)e->size, chunkname.c_str(), "b");
+}
+
+static int bundleSearcher(lua_State* L)
+{
+    const char* name = luaL_checkstring(L, 1);
+
+    std::string base = name;
+    for (char& c : base)
+        if (c == '.') c = '/';
+
+    const char* candidates[2] = { ".lua", "/init.lua" };
+    for (const char* suffix : candidates)
+    {
+        std::string fn = base + suffix;
+        int status = loadBundled(L, fn.c_str());
+        if (status == LUA_OK)
+        {
+            lua_pushstring(L, fn.c_str());
+            return 2;
+        }
+        if (status != BUNDLE_NOTFOUND)
+            lua_error(L);
+        lua_pop(L, 1);
+    }
+
+    lua_pushfstring(L, "no bundled module '%s'", name);
+    return 1;
+}
+
+void Bundle_Install(lua_State* L)
+{
+    if (bundle.header == NULL) return;
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchers");
+
+    // shift every searcher after the preload one
+    lua_Integer n = (lua_Integer)luaL_len(L, -1);
+    for (lua_Integer i = n; i >= 2; i--)
+    {
+        lua_geti(L, -1, i);
+        lua_seti(L, -2, i + 1);
+    }
+    lua_pushcfunction(L, bundleSearcher);
+    lua_seti(L, -2, 2);
+
+    lua_pop(L, 2);
+}
+
+int Bundle_DoFile(lua_State* L, const char* fn)
+{
+    if (bundle.header == NULL)
+        return luaL_dofile(L, fn);
+
+    int status = loadBundled(L, fn);
+    if (status == BUNDLE_NOTFOUND)
+    {
+        lua_pop(L, 1);
+        return luaL_dofile(L, fn);
+    }
+    if (status != LUA_OK) return status;
+    return lua_pcall(L, 0, LUA_MULTRET, 0);
+}
@@ -0,0 +1,25 @@
+#ifndef BUNDLE_HPP
+#define BUNDLE_HPP
+
+#include <include/lua.hpp>
+
+// default bundle, loaded at startup when present
+#define BUNDLE_DEFAULT_PATH "scripts.luab"
+
+// script bundles are .pak archives of stripped bytecode, named by the
+// script path relative to the game directory and stamped with its mtime
+
+// compile every .lua file under root into out
+// return false on failure
+bool Bundle_Build(const char* out, const char* root);
+
+// map a bundle, return false if it can't be opened
+bool Bundle_Open(const char* path);
+void Bundle_Close();
+
+// add the bundle searcher to package.searchers, right after the preload one
+void Bundle_Install(lua_State* L);
+// run a script from the bundle, or from source if it isn't bundled or is stale
+// return the same as luaL_dofile
+int Bundle_DoFile(lua_State* L, const char* fn);
+#endif
@@ -0,0 +1,644 @@
+#include <new>
+#include <atomic>
+#include <cmath>
+
+// the kernels work on the stereo pair, or the four combs of the reverb, as one vector
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DSP_SSE
+#include <emmintrin.h>
+#endif
+
+#include <include/SDL.h>
+
+#include "Dsp.hpp"
+
+#define DSP_COMBS 4
+#define DSP_ALLPASSES 2
+// a send that was fed nothing and rang below this for a whole span stops running
+#define DSP_SILENCE 1e-5f
+
+const char* const dspTypes[] = { "lowpass", "highpass", "delay", "reverb", NULL };
+
+// freeverb tunings at 44100 Hz, scaled to the device frequency
+static const int combTuning[DSP_COMBS] = { 1116, 1188, 1277, 1356 };
+static const int allpassTuning[DSP_ALLPASSES] = { 556, 441 };
+static const int stereoSpread = 23;
+
+struct DspEffect
+{
+    DspParams params;
+    SDL_AudioFormat format;
+    int channels;
+
+    // biquad, direct form 1, one lane per channel
+    float b0, b1, b2, a1, a2;
+    float x1[4], x2[4], y1[4], y2[4];
+
+    // delay line of interleaved samples
+    float* line;
+    int length, pos;
+
+    // reverb, one set of combs and allpasses per channel
+    float* combs[2][DSP_COMBS];
+    int combLength[2][DSP_COMBS], combPos[2][DSP_COMBS];
+    float combStore[2][DSP_COMBS];
+    float* allpasses[2][DSP_ALLPASSES];
+    int allpassLength[2][DSP_ALLPASSES], allpassPos[2][DSP_ALLPASSES];
+};
+
+// effects run one after another on the audio thread, so they share the conversion buffer
+static float scratch[DSP_BLOCK * 2];
+
+void Dsp_Defaults(DspType type, DspParams* params)
+{
+    params->type = type;
+    params->cutoff = (type == DSP_HIGHPASS) ? 200.0f : 1000.0f;
+    params->q = 0.7071f;
+    params->time = 0.25f;
+    params->feedback = 0.4f;
+    params->room = 0.5f;
+    params->damping = 0.5f;
+    params->mix = (type == DSP_REVERB) ? 0.3f : 0.5f;
+}
+
+static void setBiquad(DspEffect* e, int frequency)
+{
+    // rbj cookbook coefficients
+    float cutoff = SDL_clamp(e->params.cutoff, 10.0f, frequency * 0.49f);
+    float q = SDL_max(e->params.q, 0.01f);
+    float w0 = 2.0f * (float)M_PI * cutoff / (float)frequency;
+    float cosw = cosf(w0), alpha = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+
+    if (e->params.type == DSP_LOWPASS)
+    {
+        e->b0 = e->b2 = (1.0f - cosw) * 0.5f / a0;
+        e->b1 = (1.0f - cosw) / a0;
+    }
+    else
+    {
+        e->b0 = e->b2 = (1.0f + cosw) * 0.5f / a0;
+        e->b1 = -(1.0f + cosw) / a0;
+    }
+    e->a1 = -2.0f * cosw / a0;
+    e->a2 = (1.0f - alpha) / a0;
+}
+
+static float* allocLine(int length)
+{
+    return new (std::nothrow) float[length]();
+}
+
+DspEffect* Dsp_Create(const DspParams* params, const AudioSpec* spec)
+{
+    if ((spec->format != AUDIO_S16SYS && spec->format != AUDIO_F32SYS) || spec->channels < 1 || spec->channels > 2)
+    {
+        SDL_SetError("Effects need a s16 or f32, mono or stereo device");
+        return NULL;
+    }
+
+    DspEffect* e = new (std::nothrow) DspEffect();
+    if (e == NULL)
+    {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    e->params = *params;
+    e->params.feedback = SDL_clamp(e->params.feedback, 0.0f, 0.95f);
+    e->params.room = SDL_clamp(e->params.room, 0.0f, 1.0f);
+    e->params.damping = SDL_clamp(e->params.damping, 0.0f, 1.0f);
+    e->params.mix = SDL_clamp(e->params.mix, 0.0f, 1.0f);
+    e->format = spec->format;
+    e->channels = spec->channels;
+
+    bool ok = true;
+    switch (params->type)
+    {
+    case DSP_LOWPASS:
+    case DSP_HIGHPASS:
+        setBiquad(e, spec->frequency);
+        break;
+    case DSP_DELAY:
+    {
+        // at least 4 frames, so 4 frames in a row never read what they write
+        int frames = SDL_max((int)(SDL_clamp(params->time, 0.0f, 5.0f) * spec->frequency), 4);
+        e->length = frames * spec->channels;
+        e->line = allocLine(e->length);
+        ok = e->line != NULL;
+        break;
+    }
+    case DSP_REVERB:
+    {
+        float scale = spec->frequency / 44100.0f;
+        for (int c = 0; c < spec->channels; c++)
+        {
+            for (int i = 0; i < DSP_COMBS; i++)
+            {
+                e->combLength[c][i] = SDL_max((int)((combTuning[i] + c * stereoSpread) * scale), 1);
+                e->combs[c][i] = allocLine(e->combLength[c][i]);
+                ok = ok && e->combs[c][i] != NULL;
+            }
+            for (int i = 0; i < DSP_ALLPASSES; i++)
+            {
+                e->allpassLength[c][i] = SDL_max((int)((allpassTuning[i] + c * stereoSpread) * scale), 1);
+                e->allpasses[c][i] = allocLine(e->allpassLength[c][i]);
+                ok = ok && e->allpasses[c][i] != NULL;
+            }
+        }
+        break;
+    }
+    }
+
+    if (!ok)
+    {
+        Dsp_Destroy(e);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    return e;
+}
+void Dsp_Destroy(DspEffect* e)
+{
+    if (e == NULL) return;
+    delete[] e->line;
+    for (int c = 0; c < 2; c++)
+    {
+        for (int i = 0; i < DSP_COMBS; i++) delete[] e->combs[c][i];
+        for (int i = 0; i < DSP_ALLPASSES; i++) delete[] e->allpasses[c][i];
+    }
+    delete e;
+}
+
+// the filter is recursive in time, so the channels of a frame are the lanes
+static void biquad(DspEffect* e, float* s, int frames)
+{
+    int channels = e->channels;
+#ifdef DSP_SSE
+    __m128 b0 = _mm_set1_ps(e->b0), b1 = _mm_set1_ps(e->b1), b2 = _mm_set1_ps(e->b2);
+    __m128 a1 = _mm_set1_ps(e->a1), a2 = _mm_set1_ps(e->a2);
+    __m128 x1 = _mm_loadu_ps(e->x1), x2 = _mm_loadu_ps(e->x2);
+    __m128 y1 = _mm_loadu_ps(e->y1), y2 = _mm_loadu_ps(e->y2);
+    for (int f = 0; f < frames; f++, s += channels)
+    {
+        __m128 x = (channels == 2) ? _mm_castpd_ps(_mm_load_sd((const double*)s)) : _mm_load_ss(s);
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, x), _mm_mul_ps(b1, x1)), _mm_mul_ps(b2, x2));
+        y = _mm_sub_ps(y, _mm_add_ps(_mm_mul_ps(a1, y1), _mm_mul_ps(a2, y2)));
+        if (channels == 2) _mm_store_sd((double*)s, _mm_castps_pd(y));
+        else _mm_store_ss(s, y);
+        x2 = x1; x1 = x;
+        y2 = y1; y1 = y;
+    }
+    _mm_storeu_ps(e->x1, x1); _mm_storeu_ps(e->x2, x2);
+    _mm_storeu_ps(e->y1, y1); _mm_storeu_ps(e->y2, y2);
+#else
+    for (int f = 0; f < frames; f++, s += channels)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            float x = s[c];
+            float y = e->b0 * x + e->b1 * e->x1[c] + e->b2 * e->x2[c] - e->a1 * e->y1[c] - e->a2 * e->y2[c];
+            s[c] = y;
+            e->x2[c] = e->x1[c]; e->x1[c] = x;
+            e->y2[c] = e->y1[c]; e->y1[c] = y;
+        }
+    }
+#endif
+}
+
+// every sample reads and writes its own slot of the line, which is a whole delay long,
+// so runs up to the wrap point are independent and go four samples at a time
+static void delay(DspEffect* e, float* s, int samples)
+{
+    float mix = e->params.mix, feedback = e->params.feedback;
+    while (samples > 0)
+    {
+        int run = SDL_min(samples, e->length - e->pos);
+        float* line = e->line + e->pos;
+        int i = 0;
+#ifdef DSP_SSE
+        __m128 vmix = _mm_set1_ps(mix), vfeedback = _mm_set1_ps(feedback);
+        for (; i + 4 <= run; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(s + i), d = _mm_loadu_ps(line + i);
+            _mm_storeu_ps(s + i, _mm_add_ps(x, _mm_mul_ps(vmix, d)));
+            _mm_storeu_ps(line + i, _mm_add_ps(x, _mm_mul_ps(vfeedback, d)));
+        }
+#endif
+        for (; i < run; i++)
+        {
+            float x = s[i], d = line[i];
+            s[i] = x + mix * d;
+            line[i] = x + feedback * d;
+        }
+        s += run;
+        samples -= run;
+        e->pos = (e->pos + run == e->length) ? 0 : e->pos + run;
+    }
+}
+
+// the combs are recursive in time but independent of each other, so they are the lanes
+static void reverb(DspEffect* e, float* s, int frames)
+{
+    int channels = e->channels;
+    float feedback = e->params.room * 0.28f + 0.7f;
+    float damp = e->params.damping * 0.4f;
+    float wet = e->params.mix * 3.0f, dry = 1.0f - e->params.mix;
+
+    for (int c = 0; c < channels; c++)
+    {
+        float* const* combs = e->combs[c];
+        const int* lengths = e->combLength[c];
+        int* pos = e->combPos[c];
+#ifdef DSP_SSE
+        __m128 store = _mm_loadu_ps(e->combStore[c]);
+        __m128 vdamp = _mm_set1_ps(damp), vundamp = _mm_set1_ps(1.0f - damp), vfeedback = _mm_set1_ps(feedback);
+#endif
+        for (int f = 0; f < frames; f++)
+        {
+            float* sample = s + f * channels + c;
+            float in = *sample * 0.015f;
+            float out;
+#ifdef DSP_SSE
+            __m128 read = _mm_setr_ps(combs[0][pos[0]], combs[1][pos[1]], combs[2][pos[2]], combs[3][pos[3]]);
+            store = _mm_add_ps(_mm_mul_ps(read, vundamp), _mm_mul_ps(store, vdamp));
+            float written[4];
+            _mm_storeu_ps(written, _mm_add_ps(_mm_set1_ps(in), _mm_mul_ps(store, vfeedback)));
+            __m128 sum = _mm_add_ps(read, _mm_movehl_ps(read, read));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+            out = _mm_cvtss_f32(sum);
+            for (int i = 0; i < DSP_COMBS; i++)
+            {
+                combs[i][pos[i]] = written[i];
+                if (++pos[i] == lengths[i]) pos[i] = 0;
+            }
+#else
+            out = 0.0f;
+            for (int i = 0; i < DSP_COMBS; i++)
+            {
+                float read = combs[i][pos[i]];
+                out += read;
+                e->combStore[c][i] = read * (1.0f - damp) + e->combStore[c][i] * damp;
+                combs[i][pos[i]] = in + e->combStore[c][i] * feedback;
+                if (++pos[i] == lengths[i]) pos[i] = 0;
+            }
+#endif
+            for (int i = 0; i < DSP_ALLPASSES; i++)
+            {
+                float* line = e->allpasses[c][i];
+                int* p = &e->allpassPos[c][i];
+                float read = line[*p];
+                line[*p] = out + read * 0.5f;
+                out = read - out;
+                if (++*p == e->allpassLength[c][i]) *p = 0;
+            }
+            *sample = *sample * dry + out * wet;
+        }
+#ifdef DSP_SSE
+        _mm_storeu_ps(e->combStore[c], store);
+#endif
+    }
+}
+
+static void processFloat(DspEffect* e, float* s, int frames)
+{
+    switch (e->params.type)
+    {
+    case DSP_LOWPASS:
+    case DSP_HIGHPASS:
+        biquad(e, s, frames);
+        break;
+    case DSP_DELAY:
+        delay(e, s, frames * e->channels);
+        break;
+    case DSP_REVERB:
+        reverb(e, s, frames);
+        break;
+    }
+}
+
+static void processChain(DspEffect* const* chain, int count, void* samples, int len)
+{
+    if (count <= 0) return;
+    int channels = chain[0]->channels;
+
+    if (chain[0]->format == AUDIO_F32SYS)
+    {
+        int frames = len / (int)sizeof(float) / channels;
+        for (int i = 0; i < count; i++)
+            processFloat(chain[i], (float*)samples, frames);
+        return;
+    }
+
+    Sint16* s16 = (Sint16*)samples;
+    int total = len / (int)sizeof(Sint16) / channels;
+    while (total > 0)
+    {
+        int frames = SDL_min(total, DSP_BLOCK), count16 = frames * channels;
+        for (int i = 0; i < count16; i++)
+            scratch[i] = s16[i] * (1.0f / 32768.0f);
+        for (int i = 0; i < count; i++)
+            processFloat(chain[i], scratch, frames);
+        for (int i = 0; i < count16; i++)
+            s16[i] = (Sint16)lrintf(SDL_clamp(scratch[i] * 32768.0f, -32768.0f, 32767.0f));
+        s16 += count16;
+        total -= frames;
+    }
+}
+
+void Dsp_Process(DspEffect* e, void* samples, int len)
+{
+    processChain(&e, 1, samples, len);
+}
+bool Dsp_IsTail(DspType type)
+{
+    return type == DSP_DELAY || type == DSP_REVERB;
+}
+
+typedef struct DspChain
+{
+    int count;
+    DspEffect* effects[DSP_MAX_CHAIN];
+} DspChain;
+
+static std::atomic<DspChain*> bus(NULL);
+static SDL_SpinLock timeLock = 0;
+static double busTime = 0.0;
+static Uint64 busCalls = 0;
+
+static void destroyChain(void* data)
+{
+    DspChain* chain = (DspChain*)data;
+    if (chain == NULL) return;
+    for (int i = 0; i < chain->count; i++)
+        Dsp_Destroy(chain->effects[i]);
+    delete chain;
+}
+
+bool Dsp_SetBus(const DspParams* params, int count, const AudioSpec* spec)
+{
+    DspChain* chain = NULL;
+    if (count > 0)
+    {
+        chain = new (std::nothrow) DspChain();
+        if (chain == NULL)
+        {
+            SDL_OutOfMemory();
+            return false;
+        }
+        for (int i = 0; i < SDL_min(count, DSP_MAX_CHAIN); i++)
+        {
+            chain->effects[i] = Dsp_Create(&params[i], spec);
+            if (chain->effects[i] == NULL)
+            {
+                destroyChain(chain);
+                return false;
+            }
+            chain->count++;
+        }
+    }
+
+    // the callback running the bus may still hold the previous chain
+    DspChain* old = bus.exchange(chain);
+    if (old != NULL)
+        Audio_Retire(destroyChain, old);
+
+    SDL_AtomicLock(&timeLock);
+    busTime = 0.0;
+    busCalls = 0;
+    SDL_AtomicUnlock(&timeLock);
+    return true;
+}
+
+void Dsp_ProcessBus(Uint8* stream, int len)
+{
+    DspChain* chain = bus.load();
+    if (chain != NULL)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        processChain(chain->effects, chain->count, stream, len);
+        double time = (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+
+        SDL_AtomicLock(&timeLock);
+        busTime += time;
+        busCalls++;
+        SDL_AtomicUnlock(&timeLock);
+    }
+}
+
+double Dsp_GetBusTime()
+{
+    SDL_AtomicLock(&timeLock);
+    double time = (busCalls > 0) ? busTime / (double)busCalls : 0.0;
+    SDL_AtomicUnlock(&timeLock);
+    return time;
+}
+
+struct DspSend
+{
+    const void* owner;
+    SDL_AudioFormat format;
+    int channels;
+    int count;
+    DspEffect* effects[DSP_MAX_CHAIN];
+
+    // the rest is only touched by the audio thread
+    // what the voices fed this callback, and how far each channel got in it
+    float* input;
+    int capacity, fed;
+    int feeders;
+    int chans[DSP_SEND_FEEDERS], offsets[DSP_SEND_FEEDERS];
+    // frames a sample takes to die out in the lines, and frames rung silent so far
+    int span, idle;
+};
+
+// written by the game thread only
+static std::atomic<DspSend*> sends[DSP_SENDS];
+
+// the longest a sample stays in the lines of e
+static int tailSpan(const DspEffect* e)
+{
+    int span = 0;
+    if (e->params.type == DSP_DELAY) span = e->length / e->channels;
+    if (e->params.type == DSP_REVERB)
+    {
+        for (int c = 0; c < e->channels; c++)
+        {
+            int longest = 0;
+            for (int i = 0; i < DSP_COMBS; i++) longest = SDL_max(longest, e->combLength[c][i]);
+            for (int i = 0; i < DSP_ALLPASSES; i++) longest += e->allpassLength[c][i];
+            span = SDL_max(span, longest);
+        }
+    }
+    return span;
+}
+
+static void destroySend(void* data)
+{
+    DspSend* send = (DspSend*)data;
+    for (int i = 0; i < send->count; i++)
+        Dsp_Destroy(send->effects[i]);
+    delete[] send->input;
+    delete send;
+}
+
+DspSend* Dsp_GetSend(const void* owner, const DspParams* params, int count, const AudioSpec* spec)
+{
+    int slot = -1;
+    for (int i = 0; i < DSP_SENDS; i++)
+    {
+        DspSend* send = sends[i].load();
+        if (send != NULL && send->owner == owner) return send;
+        if (send == NULL && slot < 0) slot = i;
+    }
+    if (slot < 0)
+    {
+        SDL_SetError("Too many sounds with a delay or reverb playing");
+        return NULL;
+    }
+
+    DspSend* send = new (std::nothrow) DspSend();
+    if (send == NULL)
+    {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    send->owner = owner;
+    send->format = spec->format;
+    send->channels = spec->channels;
+    for (int i = 0; i < SDL_min(count, DSP_MAX_CHAIN); i++)
+    {
+        if (!Dsp_IsTail(params[i].type)) continue;
+        DspEffect* effect = Dsp_Create(&params[i], spec);
+        if (effect == NULL)
+        {
+            destroySend(send);
+            return NULL;
+        }
+        send->effects[send->count++] = effect;
+        send->span += tailSpan(effect);
+    }
+    send->capacity = SDL_max(spec->chunksize, DSP_SEND_FRAMES);
+    send->input = allocLine(send->capacity * send->channels);
+    if (send->input == NULL)
+    {
+        destroySend(send);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    // quiet until a voice feeds it
+    send->idle = send->span;
+
+    sends[slot].store(send);
+    return send;
+}
+
+void Dsp_ReleaseSend(const void* owner)
+{
+    for (int i = 0; i < DSP_SENDS; i++)
+    {
+        DspSend* send = sends[i].load();
+        if (send == NULL || send->owner != owner) continue;
+        // the callback running the sends may still hold it
+        sends[i].store(NULL);
+        Audio_Retire(destroySend, send);
+        return;
+    }
+}
+void Dsp_CloseSends()
+{
+    for (int i = 0; i < DSP_SENDS; i++)
+    {
+        DspSend* send = sends[i].exchange(NULL);
+        if (send != NULL) Audio_Retire(destroySend, send);
+    }
+}
+
+void Dsp_Feed(DspSend* send, int chan, const void* samples, int len, float gain)
+{
+    // a looping voice feeds the rest of its chunk, then the start of the next loop
+    int offset = 0, feeder = 0;
+    while (feeder < send->feeders && send->chans[feeder] != chan) feeder++;
+    if (feeder == send->feeders && feeder < DSP_SEND_FEEDERS)
+    {
+        send->chans[feeder] = chan;
+        send->offsets[feeder] = 0;
+        send->feeders++;
+    }
+    if (feeder < send->feeders) offset = send->offsets[feeder];
+
+    int sampleSize = (send->format == AUDIO_F32SYS) ? (int)sizeof(float) : (int)sizeof(Sint16);
+    int frames = SDL_min(len / sampleSize / send->channels, send->capacity - offset);
+    if (frames <= 0) return;
+
+    float* input = send->input + offset * send->channels;
+    int count = frames * send->channels;
+    if (send->format == AUDIO_F32SYS)
+    {
+        const float* f32 = (const float*)samples;
+        for (int i = 0; i < count; i++) input[i] += f32[i] * gain;
+    }
+    else
+    {
+        const Sint16* s16 = (const Sint16*)samples;
+        gain *= 1.0f / 32768.0f;
+        for (int i = 0; i < count; i++) input[i] += s16[i] * gain;
+    }
+    if (feeder < send->feeders) send->offsets[feeder] = offset + frames;
+    send->fed = SDL_max(send->fed, offset + frames);
+}
+
+// the effects run on the dry input and only what they add is mixed, the voices play the dry part
+static void processSend(DspSend* send, Uint8* stream, int len)
+{
+    int channels = send->channels;
+    int sampleSize = (send->format == AUDIO_F32SYS) ? (int)sizeof(float) : (int)sizeof(Sint16);
+    int total = SDL_min(len / sampleSize / channels, send->capacity);
+    bool fed = send->fed > 0;
+    if (!fed && send->idle >= send->span) return;
+
+    float peak = 0.0f;
+    for (int done = 0; done < total; )
+    {
+        int frames = SDL_min(total - done, DSP_BLOCK), count = frames * channels;
+        const float* input = send->input + done * channels;
+        SDL_memcpy(scratch, input, count * sizeof(float));
+        for (int i = 0; i < send->count; i++)
+            processFloat(send->effects[i], scratch, frames);
+
+        if (send->format == AUDIO_F32SYS)
+        {
+            float* f32 = (float*)stream + done * channels;
+            for (int i = 0; i < count; i++)
+            {
+                float wet = scratch[i] - input[i];
+                peak = SDL_max(peak, fabsf(wet));
+                f32[i] += wet;
+            }
+        }
+        else
+        {
+            Sint16* s16 = (Sint16*)stream + done * channels;
+            for (int i = 0; i < count; i++)
+            {
+                float wet = scratch[i] - input[i];
+                peak = SDL_max(peak, fabsf(wet));
+                s16[i] = (Sint16)lrintf(SDL_clamp(s16[i] + wet * 32768.0f, -32768.0f, 32767.0f));
+            }
+        }
+        done += frames;
+    }
+
+    send->idle = (fed || peak >= DSP_SILENCE) ? 0 : send->idle + total;
+    if (fed) SDL_memset(send->input, 0, send->fed * channels * sizeof(float));
+    send->fed = 0;
+    send->feeders = 0;
+}
+
+void Dsp_ProcessSends(Uint8* stream, int len)
+{
+    for (int i = 0; i < DSP_SENDS; i++)
+    {
+        DspSend* send = sends[i].load();
+        if (send != NULL) processSend(send, stream, len);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef DSP_HPP
+#define DSP_HPP
+
+#include <include/SDL.h>
+
+#include "Audio.hpp"
+
+// effects in a chain, on a sound or on the bus
+#define DSP_MAX_CHAIN 4
+// frames processed at a time, longer buffers are split
+#define DSP_BLOCK 1024
+// sounds with a delay or reverb at once, past it their voices run them and lose the tail
+#define DSP_SENDS 64
+// voices of one sound kept apart within a callback, past it they overlap
+#define DSP_SEND_FEEDERS 16
+// frames a send takes per callback, at least, the rest of a longer callback is dropped
+#define DSP_SEND_FRAMES 4096
+
+typedef enum DspType
+{
+	DSP_LOWPASS,
+	DSP_HIGHPASS,
+	DSP_DELAY,
+	DSP_REVERB
+} DspType;
+
+typedef struct DspParams
+{
+	DspType type;
+	// filters : cutoff frequency in Hz, and resonance
+	float cutoff, q;
+	// delay : time in seconds, and how much of each echo comes back
+	float time, feedback;
+	// reverb : size of the room and damping of the high frequencies, from 0 to 1
+	float room, damping;
+	// delay and reverb : how much of the effect is heard, from 0 to 1
+	float mix;
+} DspParams;
+
+typedef struct DspEffect DspEffect;
+// the delay and reverb of one sound, shared by its voices
+typedef struct DspSend DspSend;
+
+// names of the effect types, for luaL_checkoption
+extern const char* const dspTypes[];
+
+// fill params with the defaults of type
+void Dsp_Defaults(DspType type, DspParams* params);
+// create an effect for the device spec, the device must be s16 or f32, mono or stereo
+// return NULL if it isn't
+DspEffect* Dsp_Create(const DspParams* params, const AudioSpec* spec);
+void Dsp_Destroy(DspEffect* effect);
+// process samples in the device format in place
+void Dsp_Process(DspEffect* effect, void* samples, int len);
+// return wether effects of type ring on once their input stops
+bool Dsp_IsTail(DspType type);
+
+// get the send running the delay and reverb in params for owner, creating it the first time
+// its voices feed it and it keeps running after they end, so the tail is heard
+// return NULL if it can't be created, or every send is taken
+DspSend* Dsp_GetSend(const void* owner, const DspParams* params, int count, const AudioSpec* spec);
+// forget the send of owner, which no voice may feed anymore, see Audio_Retire
+void Dsp_ReleaseSend(const void* owner);
+// release every send, once the device is closed
+void Dsp_CloseSends();
+// called from a voice's effect, add the samples of chan scaled by gain to what the send runs next
+void Dsp_Feed(DspSend* send, int chan, const void* samples, int len, float gain);
+// called from the audio callback, during a pass, add what every send rings to the output
+void Dsp_ProcessSends(Uint8* stream, int len);
+
+// replace the effects applied to the whole output, count may be 0 to remove them
+// the previous ones are freed once the callback let go of them, see Audio_Retire
+bool Dsp_SetBus(const DspParams* params, int count, const AudioSpec* spec);
+// called from the audio callback, during a pass, once everything is mixed
+void Dsp_ProcessBus(Uint8* stream, int len);
+// average time the bus took per callback, in microseconds
+double Dsp_GetBusTime();
+#endif
@@ -0,0 +1,115 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <include/SDL.h>
+
+#include "FileMap.hpp"
+
+bool MapFile(MappedFile* map, const char* path)
+{
+    map->data = NULL;
+    map->size = 0;
+    map->file = NULL;
+    map->mapping = NULL;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        SDL_SetError("Can't open %s", path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        SDL_SetError("Can't get size of %s", path);
+        return false;
+    }
+    map->file = file;
+    map->size = (size_t)size.QuadPart;
+    // empty files can't be mapped, but they are still valid
+    if (map->size == 0) return true;
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        UnmapFile(map);
+        SDL_SetError("Can't map %s", path);
+        return false;
+    }
+    map->mapping = mapping;
+    map->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (map->data == NULL)
+    {
+        UnmapFile(map);
+        SDL_SetError("Can't map %s", path);
+        return false;
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        SDL_SetError("Can't open %s", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        SDL_SetError("Can't get size of %s", path);
+        return false;
+    }
+    map->size = (size_t)st.st_size;
+    if (map->size > 0)
+    {
+        void* data = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            map->size = 0;
+            SDL_SetError("Can't map %s", path);
+            return false;
+        }
+        map->data = data;
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+#endif
+
+    return true;
+}
+void UnmapFile(MappedFile* map)
+{
+#ifdef _WIN32
+    if (map->data != NULL)
+        UnmapViewOfFile(map->data);
+    if (map->mapping != NULL)
+        CloseHandle((HANDLE)map->mapping);
+    if (map->file != NULL)
+        CloseHandle((HANDLE)map->file);
+#else
+    if (map->data != NULL)
+        munmap((void*)map->data, map->size);
+#endif
+    map->data = NULL;
+    map->size = 0;
+    map->file = NULL;
+    map->mapping = NULL;
+}
+
+long long FileModTime(const char* path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+    return (long long)st.st_mtime;
+}
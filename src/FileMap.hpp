@@ -0,0 +1,24 @@
+#ifndef FILEMAP_HPP
+#define FILEMAP_HPP
+
+#include <cstddef>
+
+// a read-only view of a whole file mapped in memory
+typedef struct MappedFile
+{
+	const void* data;
+	size_t size;
+	// platform handles (file and mapping on windows)
+	void* file;
+	void* mapping;
+} MappedFile;
+
+// map the whole file in memory (read-only)
+// return false and set the SDL error on failure
+bool MapFile(MappedFile* map, const char* path);
+// unmap a file mapped with MapFile, safe to call on a zeroed MappedFile
+void UnmapFile(MappedFile* map);
+
+// return the last modification time of a file, or -1 if it doesn't exist
+long long FileModTime(const char* path);
+#endif
@@ -0,0 +1,200 @@
+#include <include/SDL.h>
+
+#include <include/lua.hpp>
+
+#include "Gc.hpp"
+
+// the frame loop called Gc_Start
+static bool framed = false;
+// the collector is stopped and only runs from Gc_Frame
+static bool managed = false;
+
+static double budget = GC_DEFAULT_BUDGET;
+static GcMode mode = GC_AUTO;
+static GcStats stats = { 0.0, 0, 0, 0, GC_INCREMENTAL };
+
+// heap left by the last cycle (or minor collection), in KB
+static double baseHeap = 0.0;
+static bool inCycle = false;
+// running average of a step, in microseconds
+static double stepTime = 0.0;
+
+// auto mode : frames in the current window, where the collector fell behind the
+// allocations (incremental) or went past the budget (generational)
+#define GC_AUTO_WINDOW 120
+static int windowFrames = 0, behindFrames = 0, spikeFrames = 0;
+
+// lua's own parameters, given back with the collector
+#define GC_LUA_PAUSE 200
+#define GC_LUA_STEPMUL 100
+#define GC_LUA_MINORMUL 20
+#define GC_LUA_MAJORMUL 100
+
+static double heapKB(lua_State* L)
+{
+    return (double)lua_gc(L, LUA_GCCOUNT) + (double)lua_gc(L, LUA_GCCOUNTB) / 1024.0;
+}
+
+// while managed, lua still collects on its own once the heap passes GC_LIMIT, so a frame
+// that never ends (a long load, a script stuck in a loop) can't grow it unbounded,
+// the minor multiplier is a byte in lua
+static void applyMode(lua_State* L, GcMode m)
+{
+    if (m == GC_GENERATIONAL)
+        lua_gc(L, LUA_GCGEN, SDL_min(GC_LIMIT - 100, 255), GC_LIMIT);
+    else
+        lua_gc(L, LUA_GCINC, GC_LIMIT, GC_LUA_STEPMUL, 0);
+
+    stats.active = m;
+    inCycle = false;
+    stepTime = 0.0;
+    windowFrames = behindFrames = spikeFrames = 0;
+    baseHeap = heapKB(L);
+}
+
+static void takeOver(lua_State* L)
+{
+    applyMode(L, (mode == GC_GENERATIONAL) ? GC_GENERATIONAL : GC_INCREMENTAL);
+    managed = true;
+}
+static void handBack(lua_State* L)
+{
+    if (stats.active == GC_GENERATIONAL)
+        lua_gc(L, LUA_GCGEN, GC_LUA_MINORMUL, GC_LUA_MAJORMUL);
+    else
+        lua_gc(L, LUA_GCINC, GC_LUA_PAUSE, GC_LUA_STEPMUL, 0);
+    managed = false;
+}
+
+void Gc_Start(lua_State* L)
+{
+    framed = true;
+    if (budget > 0.0 && !managed)
+        takeOver(L);
+}
+void Gc_Stop(lua_State* L)
+{
+    framed = false;
+    if (managed)
+        handBack(L);
+}
+
+static void autoSwitch(lua_State* L, bool behind, bool spike)
+{
+    if (mode != GC_AUTO) return;
+
+    windowFrames++;
+    if (behind) behindFrames++;
+    if (spike) spikeFrames++;
+    if (windowFrames < GC_AUTO_WINDOW) return;
+
+    // garbage outpaces incremental steps : young collections are cheaper
+    if (stats.active == GC_INCREMENTAL && behindFrames > windowFrames / 4)
+        applyMode(L, GC_GENERATIONAL);
+    // major collections show up as hitches : spread the work again
+    else if (stats.active == GC_GENERATIONAL && spikeFrames > windowFrames / 20)
+        applyMode(L, GC_INCREMENTAL);
+    else
+        windowFrames = behindFrames = spikeFrames = 0;
+}
+
+void Gc_Frame(lua_State* L, Uint64 frameStart, double framePeriod)
+{
+    stats.frameTime = 0.0;
+    stats.frameSteps = 0;
+    if (!managed) return;
+
+    double freq = (double)SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    double elapsed = (double)(start - frameStart) * 1000000.0 / freq;
+    double left = SDL_min(framePeriod * 1000000.0 - elapsed, budget);
+
+    bool generational = stats.active == GC_GENERATIONAL;
+    double heap = heapKB(L);
+    // past the limit, collect even without time left, or memory would grow unbounded
+    bool behind = heap > baseHeap * GC_LIMIT / 100.0;
+    bool pending = generational
+        ? heap > baseHeap * 1.2
+        : inCycle || heap > baseHeap * GC_PAUSE / 100.0;
+
+    if (!pending || (left <= 0.0 && !behind))
+    {
+        autoSwitch(L, behind, false);
+        return;
+    }
+
+    Uint64 deadline = start + (Uint64)(SDL_max(left, 0.0) * freq / 1000000.0);
+    Uint64 now;
+    do
+    {
+        Uint64 stepStart = SDL_GetPerformanceCounter();
+        int done = lua_gc(L, LUA_GCSTEP, generational ? 0 : GC_STEP_KB);
+        now = SDL_GetPerformanceCounter();
+
+        double t = (double)(now - stepStart) * 1000000.0 / freq;
+        stepTime = (stepTime == 0.0) ? t : stepTime * 0.9 + t * 0.1;
+        stats.frameSteps++;
+
+        // a generational step is a whole young collection, one per frame is enough
+        if (generational)
+        {
+            stats.cycles++;
+            baseHeap = heapKB(L);
+            break;
+        }
+        inCycle = true;
+        if (done)
+        {
+            inCycle = false;
+            stats.cycles++;
+            baseHeap = heapKB(L);
+            break;
+        }
+    } while ((double)now + stepTime * freq / 1000000.0 < (double)deadline);
+
+    stats.frameTime = (double)(now - start) * 1000000.0 / freq;
+    bool spike = stats.frameTime > SDL_max(left, 0.0) + stepTime;
+    if (spike) stats.overruns++;
+
+    autoSwitch(L, behind, spike);
+}
+
+void Gc_SetBudget(lua_State* L, double us)
+{
+    budget = SDL_max(us, 0.0);
+    if (!framed) return;
+
+    if (budget > 0.0 && !managed)
+        takeOver(L);
+    else if (budget == 0.0 && managed)
+        handBack(L);
+}
+double Gc_GetBudget()
+{
+    return budget;
+}
+void Gc_SetMode(lua_State* L, GcMode m)
+{
+    mode = m;
+    if (managed)
+    {
+        if (m != GC_AUTO)
+            applyMode(L, m);
+        return;
+    }
+    // lua keeps the collector, only switch its mode
+    if (m == GC_GENERATIONAL)
+        lua_gc(L, LUA_GCGEN, 0, 0);
+    else if (m == GC_INCREMENTAL)
+        lua_gc(L, LUA_GCINC, 0, 0, 0);
+    if (m != GC_AUTO)
+        stats.active = m;
+}
+GcMode Gc_GetMode()
+{
+    return mode;
+}
+const GcStats* Gc_GetStats()
+{
+    return &stats;
+}
@@ -0,0 +1,51 @@
+#ifndef GC_HPP
+#define GC_HPP
+
+#include <include/SDL.h>
+
+#include <include/lua.hpp>
+
+// default time the collector may take at the end of each frame, in microseconds
+#define GC_DEFAULT_BUDGET 2000
+// heap size, in percent of the heap left by the last cycle, that starts a new cycle
+#define GC_PAUSE 200
+// heap size, in percent of that same heap, past which the collector runs even with no time left,
+// and past which lua collects on its own between two frames
+#define GC_LIMIT 400
+// work of each incremental step, in KB
+#define GC_STEP_KB 16
+
+typedef enum GcMode
+{
+	GC_AUTO,
+	GC_INCREMENTAL,
+	GC_GENERATIONAL
+} GcMode;
+
+typedef struct GcStats
+{
+	// time spent in the collector during the last frame, in microseconds
+	double frameTime;
+	// steps done during the last frame
+	int frameSteps;
+	// cycles completed, and steps taken past the frame budget
+	Uint64 cycles, overruns;
+	// mode the collector is running in (never GC_AUTO)
+	GcMode active;
+} GcStats;
+
+// take the collector over, it then runs from Gc_Frame, and from lua only past GC_LIMIT
+void Gc_Start(lua_State* L);
+// hand the collector back to lua
+void Gc_Stop(lua_State* L);
+// spend the time left before the end of the frame collecting
+// frameStart is the performance counter at the start of the frame
+void Gc_Frame(lua_State* L, Uint64 frameStart, double framePeriod);
+
+// a budget of 0 leaves the collector to lua
+void Gc_SetBudget(lua_State* L, double us);
+double Gc_GetBudget();
+void Gc_SetMode(lua_State* L, GcMode mode);
+GcMode Gc_GetMode();
+const GcStats* Gc_GetStats();
+#endif
@@ -0,0 +1,126 @@
+#include <atomic>
+
+#include <include/SDL.h>
+
+#include "Group.hpp"
+
+typedef struct Group
+{
+    bool used, muted;
+    float volume;
+    // fading from fadeFrom at fadeStart to fadeTo fadeTime later
+    bool fading;
+    float fadeFrom, fadeTo;
+    Uint32 fadeStart, fadeTime;
+} Group;
+
+// only touched by the game thread
+static Group groups[GROUP_MAX];
+// what the audio callback reads, the defaults let voices of group 0 play untouched
+static std::atomic<float> gains[GROUP_MAX];
+static std::atomic<bool> paused[GROUP_MAX];
+
+static bool isValid(int group)
+{
+    return group > 0 && group < GROUP_MAX && groups[group].used;
+}
+static void publish(int group)
+{
+    const Group* g = &groups[group];
+    gains[group].store(g->muted ? 0.0f : g->volume, std::memory_order_relaxed);
+}
+
+int Group_Create()
+{
+    for (int i = 1; i < GROUP_MAX; i++)
+    {
+        if (groups[i].used) continue;
+        Group g = { true, false, 1.0f, false, 0.0f, 0.0f, 0, 0 };
+        groups[i] = g;
+        publish(i);
+        paused[i].store(false, std::memory_order_relaxed);
+        return i;
+    }
+    SDL_SetError("Too many audio groups");
+    return -1;
+}
+void Group_Destroy(int group)
+{
+    if (!isValid(group)) return;
+    groups[group].used = false;
+    gains[group].store(1.0f, std::memory_order_relaxed);
+    paused[group].store(false, std::memory_order_relaxed);
+}
+
+void Group_SetVolume(int group, float volume)
+{
+    if (!isValid(group)) return;
+    groups[group].volume = SDL_clamp(volume, 0.0f, 1.0f);
+    groups[group].fading = false;
+    publish(group);
+}
+float Group_GetVolume(int group)
+{
+    return isValid(group) ? groups[group].volume : 1.0f;
+}
+void Group_SetMuted(int group, bool muted)
+{
+    if (!isValid(group)) return;
+    groups[group].muted = muted;
+    publish(group);
+}
+bool Group_IsMuted(int group)
+{
+    return isValid(group) && groups[group].muted;
+}
+void Group_SetPaused(int group, bool p)
+{
+    if (!isValid(group)) return;
+    paused[group].store(p, std::memory_order_relaxed);
+}
+bool Group_IsPaused(int group)
+{
+    return group > 0 && group < GROUP_MAX && paused[group].load(std::memory_order_relaxed);
+}
+void Group_Fade(int group, float volume, Uint32 ms)
+{
+    if (!isValid(group)) return;
+    Group* g = &groups[group];
+    g->fadeFrom = g->volume;
+    g->fadeTo = SDL_clamp(volume, 0.0f, 1.0f);
+    g->fadeStart = SDL_GetTicks();
+    g->fadeTime = ms;
+    g->fading = true;
+}
+bool Group_IsFading(int group)
+{
+    return isValid(group) && groups[group].fading;
+}
+
+float Group_GetGain(int group)
+{
+    if (group <= 0 || group >= GROUP_MAX) return 1.0f;
+    return gains[group].load(std::memory_order_relaxed);
+}
+Uint32 Group_Update()
+{
+    Uint32 changed = 0;
+    Uint32 now = SDL_GetTicks();
+    for (int i = 1; i < GROUP_MAX; i++)
+    {
+        Group* g = &groups[i];
+        if (!g->used || !g->fading) continue;
+
+        Uint32 elapsed = now - g->fadeStart;
+        if (elapsed >= g->fadeTime)
+        {
+            g->volume = g->fadeTo;
+            g->fading = false;
+        }
+        else
+            g->volume = g->fadeFrom + (g->fadeTo - g->fadeFrom) * ((float)elapsed / (float)g->fadeTime);
+        publish(i);
+        changed |= (Uint32)1 << i;
+    }
+    return changed;
+}
@@ -0,0 +1,32 @@
+#ifndef GROUP_HPP
+#define GROUP_HPP
+
+#include <include/SDL.h>
+
+// groups that can exist at once, group 0 is every sound that isn't in one
+#define GROUP_MAX 32
+
+// create a group at full volume, return its id or -1 if there are too many
+int Group_Create();
+// the group plays at full volume again and its id may be reused,
+// its voices must be ungrouped first, see Voice_Ungroup and Mixer_Ungroup
+void Group_Destroy(int group);
+
+// volume is from 0 to 1, setting it stops the fade
+void Group_SetVolume(int group, float volume);
+float Group_GetVolume(int group);
+void Group_SetMuted(int group, bool muted);
+bool Group_IsMuted(int group);
+void Group_SetPaused(int group, bool paused);
+bool Group_IsPaused(int group);
+// move the volume to volume over ms milliseconds, see Group_Update
+void Group_Fade(int group, float volume, Uint32 ms);
+bool Group_IsFading(int group);
+
+// gain the voices of group are multiplied by, 0 when muted
+// safe to call from the audio callback
+float Group_GetGain(int group);
+// advance the fades, once per frame
+// return a mask of the groups whose gain changed
+Uint32 Group_Update();
+#endif
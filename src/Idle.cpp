@@ -0,0 +1,82 @@
+#include <include/SDL.h>
+
+#include "Idle.hpp"
+
+static bool enabled = false;
+static Uint32 timeout = IDLE_DEFAULT_TIMEOUT;
+static bool redraw = false;
+
+static Uint64 since = 0;
+static Uint64 waited = 0;
+static double latencySum = 0.0;
+static Uint64 latencyCount = 0;
+static IdleStats stats = { false, 0, 0, 0, 0.0, 0.0, 0.0 };
+
+void Idle_Enable(bool enable, Uint32 ms)
+{
+    enabled = enable;
+    timeout = ms;
+    redraw = true;
+
+    since = SDL_GetPerformanceCounter();
+    waited = 0;
+    latencySum = 0.0;
+    latencyCount = 0;
+    stats = { enable, 0, 0, 0, 0.0, 0.0, 0.0 };
+}
+bool Idle_IsEnabled()
+{
+    return enabled;
+}
+Uint32 Idle_GetTimeout()
+{
+    return timeout;
+}
+void Idle_Redraw()
+{
+    redraw = true;
+}
+
+bool Idle_Wait(SDL_Event* event, Uint32 ms)
+{
+    if (redraw)
+    {
+        redraw = false;
+        return false;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    int got = (ms == 0) ? SDL_WaitEvent(event) : SDL_WaitEventTimeout(event, (int)ms);
+    waited += SDL_GetPerformanceCounter() - start;
+    if (since == 0) since = start;
+
+    if (!got) return false;
+    stats.wakeups++;
+    // events carry the ticks they were queued at
+    if (event->common.timestamp != 0)
+    {
+        double latency = (double)(SDL_GetTicks() - event->common.timestamp);
+        latencySum += latency;
+        latencyCount++;
+        if (latency > stats.maxWakeLatency) stats.maxWakeLatency = latency;
+    }
+    return true;
+}
+bool Idle_IsSuspended(SDL_Window* window)
+{
+    return window != NULL && (SDL_GetWindowFlags(window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN)) != 0;
+}
+void Idle_Frame(bool drawn)
+{
+    if (since == 0) since = SDL_GetPerformanceCounter();
+    stats.frames++;
+    if (!drawn) stats.suspended++;
+}
+
+const IdleStats* Idle_GetStats()
+{
+    Uint64 wall = (since != 0) ? SDL_GetPerformanceCounter() - since : 0;
+    stats.cpu = (wall > 0) ? 1.0 - (double)waited / (double)wall : 0.0;
+    stats.wakeLatency = (latencyCount > 0) ? latencySum / (double)latencyCount : 0.0;
+    return &stats;
+}
@@ -0,0 +1,39 @@
+#ifndef IDLE_HPP
+#define IDLE_HPP
+
+#include <include/SDL.h>
+
+// longest wait for an event in idle mode, in milliseconds, when the script doesn't choose
+#define IDLE_DEFAULT_TIMEOUT 1000
+
+typedef struct IdleStats
+{
+	bool enabled;
+	// frames run, waits that ended with an event and frames not drawn because the window was hidden
+	Uint64 frames, wakeups, suspended;
+	// share of the time the main loop didn't spend waiting, from 0 to 1
+	double cpu;
+	// average and longest time from an event to the loop waking up for it, in milliseconds
+	double wakeLatency, maxWakeLatency;
+} IdleStats;
+
+// in idle mode the loop waits for an event, a redraw or timeout milliseconds
+// before each frame, 0 waits for an event or a redraw only
+// the statistics start over
+void Idle_Enable(bool enabled, Uint32 timeout);
+bool Idle_IsEnabled();
+Uint32 Idle_GetTimeout();
+// run the next frame without waiting
+void Idle_Redraw();
+
+// wait at most timeout milliseconds for an event, 0 waits as long as it takes,
+// unless a redraw was requested
+// return true and fill event when an event came
+bool Idle_Wait(SDL_Event* event, Uint32 timeout);
+// whether there is nothing to draw to, the window is minimized or hidden
+bool Idle_IsSuspended(SDL_Window* window);
+// count a frame, drawn or not
+void Idle_Frame(bool drawn);
+
+const IdleStats* Idle_GetStats();
+#endif
@@ -2,6 +2,11 @@
 #include <ctime>
 #include <fstream>
 #include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <climits>
 
 #include <signal.h>
 
@@ -12,6 +17,26 @@
 #include <include/lua.hpp>
 
 #include "LuaSDL.hpp"
+#include "Pak.hpp"
+#include "TexCache.hpp"
+#include "Bundle.hpp"
+#include "Watcher.hpp"
+#include "Pool.hpp"
+#include "Gc.hpp"
+#include "Memory.hpp"
+#include "Voice.hpp"
+#include "Audio.hpp"
+#include "Mixer.hpp"
+#include "Spatial.hpp"
+#include "Stream.hpp"
+#include "Dsp.hpp"
+#include "Group.hpp"
+#include "Spectrum.hpp"
+#include "Pipeline.hpp"
+#include "Idle.hpp"
+#include "Subsystem.hpp"
+#include "Startup.hpp"
+#include "Vector.hpp"
 
 #pragma region Main
 // the window
@@ -21,7 +46,7 @@ SDL_Renderer* renderer = NULL;
 // the lua state (for lua host)
 lua_State* L = NULL;
 
-bool SDLInited = false, IMGInited = false, MIXInited = false;
+bool SDLInited = false;
 bool running = false;
 
 const Uint8* keys;
@@ -30,27 +55,148 @@ double dt = 0.0, lt = 0.0;
 
 Color bgColor = { 0,0,0,255 };
 
+// image loading statistics, to compare cold (decode) and warm (cache) loads
+struct
+{
+    Uint32 hits, misses;
+    double hitTime, missTime;
+} imageCacheStats = { 0, 0, 0.0, 0.0 };
+
+// residency of new images
+int imageResidency = IMAGE_RESIDENCY_CPU;
+static const char* const imageResidencies[] = { "cpu", "gpu", NULL };
+
+// every live image and sound, to find them back from their path
+std::vector<Image*> images;
+std::vector<Sound*> sounds;
+std::vector<Music*> musics;
+std::vector<AudioStream*> audioStreams;
+// the music playing, there is only ever one
+Music* currentMusic = NULL;
+// paused by Music:Pause, its group may pause it too
+bool musicPaused = false;
+// modules already handed to the watcher
+std::vector<std::string> watchedModules;
+
+static int panic(lua_State* L)
+{
+    const char* msg = lua_tostring(L, -1);
+    std::cout << "PANIC: unprotected error in call to Lua API (" << (msg ? msg : "error object is not a string") << ")" << std::endl;
+    return 0;
+}
+
+// the warning functions luaL_newstate installs : off until the "@on" control message,
+// a message may come in pieces, printed as they come
+static void warnOff(void* ud, const char* msg, int tocont);
+static void warnOn(void* ud, const char* msg, int tocont);
+static void warnCont(void* ud, const char* msg, int tocont);
+static bool warnControl(lua_State* L, const char* msg, int tocont)
+{
+    if (tocont || *(msg++) != '@') return false;
+    if (strcmp(msg, "off") == 0)
+        lua_setwarnf(L, warnOff, L);
+    else if (strcmp(msg, "on") == 0)
+        lua_setwarnf(L, warnOn, L);
+    return true;
+}
+static void warnOff(void* ud, const char* msg, int tocont)
+{
+    warnControl((lua_State*)ud, msg, tocont);
+}
+static void warnCont(void* ud, const char* msg, int tocont)
+{
+    lua_State* L = (lua_State*)ud;
+    std::cout << msg;
+    if (tocont)
+        lua_setwarnf(L, warnCont, L);
+    else
+    {
+        std::cout << std::endl;
+        lua_setwarnf(L, warnOn, L);
+    }
+}
+static void warnOn(void* ud, const char* msg, int tocont)
+{
+    if (warnControl((lua_State*)ud, msg, tocont)) return;
+    std::cout << "Lua warning: ";
+    warnCont(ud, msg, tocont);
+}
+
 int pmain(lua_State* L)
 {
     int argc = lua_tointeger(L, 1);
     char** argv = (char**)lua_touserdata(L, 2);
 
-    lua_gc(L, LUA_GCGEN, 0, 0);
-
+    Startup_Begin("LoadEngine", NULL);
     LoadEngine(L);
+    Startup_End();
+
+    // precompiled scripts, when shipped
+    Startup_Begin("Bundle_Open", NULL);
+    if (Bundle_Open(BUNDLE_DEFAULT_PATH))
+        Bundle_Install(L);
+    Startup_End();
 
-    luaL_dofile(L, "main.lua");
+    Startup_Begin("luaL_dofile", "main.lua");
+    Bundle_DoFile(L, "main.lua");
+    Startup_End();
 
     if (SDLInited)
     {
         loop();
     }
+    // scripts that never start SDL end their startup here
+    Startup_Finish();
 
     return 0;
 }
 int main(int argc, char** argv) {
-    L = luaL_newstate();
+    // asset packer : LuaSDL --pack <out.pak> <directory>
+    if (argc > 1 && strcmp(argv[1], "--pack") == 0)
+    {
+        if (argc != 4)
+        {
+            std::cout << "usage : " << argv[0] << " --pack <out.pak> <directory>" << std::endl;
+            return 1;
+        }
+        return Pak_Build(argv[2], argv[3]) ? 0 : 1;
+    }
+    // script compiler : LuaSDL --compile <out.luab> <directory>
+    if (argc > 1 && strcmp(argv[1], "--compile") == 0)
+    {
+        if (argc != 4)
+        {
+            std::cout << "usage : " << argv[0] << " --compile <out.luab> <directory>" << std::endl;
+            return 1;
+        }
+        return Bundle_Build(argv[2], argv[3]) ? 0 : 1;
+    }
+    // startup profiler : LuaSDL --startup, or LuaSDL --startup-trace <trace.json>
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--startup") == 0)
+            Startup_Enable(NULL);
+        else if (strcmp(argv[i], "--startup-trace") == 0 && i + 1 < argc)
+            Startup_Enable(argv[++i]);
+    }
+
+    Startup_Begin("lua_newstate", NULL);
+#ifdef LUASDL_SYSTEM_ALLOC
+    // every block from malloc, as luaL_newstate does, still counted
+    L = lua_newstate(Pool_SystemAlloc, NULL);
+#else
+    // small blocks come from size-class pools instead of malloc
+    L = lua_newstate(Pool_Alloc, NULL);
+#endif
+    if (L != NULL)
+    {
+        lua_atpanic(L, panic);
+        lua_setwarnf(L, warnOff, L);
+    }
+    Startup_End();
+    Startup_Begin("luaL_openlibs", NULL);
     luaL_openlibs(L);
+    Startup_End();
 
     lua_pushcfunction(L, pmain);
     lua_pushinteger(L, (lua_Integer)argc);
@@ -65,47 +211,136 @@ void loop()
 {
     running = true;
 
+    // the collector runs in the time left at the end of each frame
+    double framePeriod = 1.0 / 60.0;
+    SDL_DisplayMode mode;
+    if (SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0)
+        framePeriod = 1.0 / (double)mode.refresh_rate;
+    Gc_Start(L);
+
+    Uint32 frameMs = (Uint32)(framePeriod * 1000.0) + 1;
+    // fades and streams being played need frames even when nothing else happens
+    bool animating = false;
+    Startup_Begin("first frame", NULL);
     while (running)
     {
         SDL_Event event;
 
-        while (SDL_PollEvent(&event))
+        // tools sleep until something happens, a hidden window only waits for its next frame
+        bool suspended = Idle_IsSuspended(window);
+        if (Idle_IsEnabled() || suspended)
         {
-            if (event.type == SDL_QUIT) running = false;
-
-            keys = SDL_GetKeyboardState(NULL);
+            Uint32 timeout = Idle_IsEnabled() ? Idle_GetTimeout() : frameMs;
+            if (animating || suspended) timeout = (timeout == 0) ? frameMs : SDL_min(timeout, frameMs);
+            if (Idle_Wait(&event, timeout))
+                HandleEvent(&event);
         }
 
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        Pipeline_BeginFrame();
+
+        while (SDL_PollEvent(&event))
+            HandleEvent(&event);
+
+        // reload what changed on disk
+        if (Watcher_IsRunning())
+            HotReload();
+
         // call the "update(dt)" function from lua code
         Update();
 
-        // draw background
-        SDL_SetRenderDrawColor(renderer, bgColor.r, bgColor.g, bgColor.b, bgColor.a);
-        SDL_RenderClear(renderer);
+        // follow the listener and emitters scripts moved
+        SpatialFrame();
+        // free what the audio callback held past the wait
+        Audio_Reclaim();
+        animating = GroupFrame() || StreamFrame();
+
+        // nothing is drawn while the window is minimized or hidden
+        suspended = Idle_IsSuspended(window);
+        if (!suspended)
+        {
+            // draw background
+            PipeCommand background = {};
+            background.type = PIPE_COLOR;
+            background.r = bgColor.r;
+            background.g = bgColor.g;
+            background.b = bgColor.b;
+            background.a = bgColor.a;
+            Pipeline_Draw(renderer, &background);
+            background.type = PIPE_CLEAR;
+            Pipeline_Draw(renderer, &background);
+
+            // call the "render()" function from lua code
+            Render();
+        }
 
-        // call the "render()" function from lua code
-        Render();
+        // collect garbage before presenting, which may wait for the display
+        Gc_Frame(L, frameStart, framePeriod);
+        Mem_Frame(L);
 
-        // make changements visible
-        SDL_RenderPresent(renderer);
+        // make changements visible, or hand them to the render thread and record the next frame meanwhile
+        if (!suspended)
+        {
+            Pipeline_Present(renderer);
+            // the render thread presents the first frame on its own
+            if (Startup_IsEnabled())
+            {
+                Pipeline_Wait();
+                Startup_Finish();
+            }
+        }
+        Idle_Frame(!suspended);
     }
+
+    Gc_Stop(L);
+}
+
+void HandleEvent(SDL_Event* event)
+{
+    if (event->type == SDL_QUIT) running = false;
+    if (event->type == SDL_RENDER_DEVICE_RESET) ResetImageTextures();
+
+    keys = SDL_GetKeyboardState(NULL);
 }
 
 void QuitSDL()
 {
-    if (renderer != NULL)
+    // the render thread destroys the renderer it owns
+    if (Pipeline_IsRunning())
+        Pipeline_Stop();
+    else if (renderer != NULL)
         SDL_DestroyRenderer(renderer);
+    renderer = NULL;
     if (window != NULL)
         SDL_DestroyWindow(window);
-    if (SDLInited)
-        SDL_Quit();
-    if (IMGInited)
-        IMG_Quit();
+    Subsystem_QuitAll();
 }
 void QuitAll()
 {
-    QuitSDL();
+    for (Image* img : images)
+        Mem_ReportAlive(IMAGE_TYPE_NAME, img->path, Mem_SurfaceBytes(img->surf) + Mem_TextureBytes(img->tex));
+    for (Sound* snd : sounds)
+        Mem_ReportAlive(SOUND_TYPE_NAME, snd->path, snd->snd ? snd->snd->alen : 0);
+    for (Music* mus : musics)
+        Mem_ReportAlive(MUSIC_TYPE_NAME, mus->path, mus->size);
+    for (AudioStream* as : audioStreams)
+        Mem_ReportAlive(AUDIOSTREAM_TYPE_NAME, NULL, Stream_GetCapacity(as->stream) * as->stream->ring.elementSize);
+
+    // collects what scripts didn't release, while the renderer still owns their textures
     if (L != NULL) lua_close(L);
+    L = NULL;
+    Mixer_Stop();
+    Audio_Close();
+    Mixer_Shutdown();
+    Spectrum_Shutdown();
+    Dsp_SetBus(NULL, 0, NULL);
+    Voice_Reset();
+    QuitSDL();
+    Pool_Release();
+    Watcher_Stop();
+    Bundle_Close();
+    Pak_UnmountAll();
+    Mem_ReportLeaks();
 }
 
 void Update()
@@ -128,6 +363,114 @@ void Render()
         lua_pcall(L, 0, 0, 0);
     }
 }
+
+static void watchModules()
+{
+    // new entries of package.loaded that come from a source file
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "loaded");
+    lua_pushnil(L);
+    while (lua_next(L, -2) != 0)
+    {
+        lua_pop(L, 1);
+        if (lua_type(L, -1) != LUA_TSTRING) continue;
+        std::string name = lua_tostring(L, -1);
+        if (std::find(watchedModules.begin(), watchedModules.end(), name) != watchedModules.end()) continue;
+        watchedModules.push_back(name);
+
+        // package.searchpath(name, package.path)
+        lua_getfield(L, -3, "searchpath");
+        lua_pushstring(L, name.c_str());
+        lua_getfield(L, -5, "path");
+        if (lua_pcall(L, 2, 1, 0) == LUA_OK && lua_isstring(L, -1))
+            Watcher_Add(lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 2);
+}
+static bool reloadModule(const char* fn)
+{
+    if (strcmp(fn, "main.lua") == 0)
+    {
+        int top = lua_gettop(L);
+        if (Bundle_DoFile(L, fn) != LUA_OK)
+            std::cout << "Can't reload " << fn << " :\n" << lua_tostring(L, -1) << std::endl;
+        lua_settop(L, top);
+        return true;
+    }
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "loaded");
+    for (const std::string& name : watchedModules)
+    {
+        lua_getfield(L, -2, "searchpath");
+        lua_pushstring(L, name.c_str());
+        lua_getfield(L, -4, "path");
+        bool match = lua_pcall(L, 2, 1, 0) == LUA_OK && lua_isstring(L, -1) && strcmp(lua_tostring(L, -1), fn) == 0;
+        lua_pop(L, 1);
+        if (!match) continue;
+
+        // require it again, keeping the previous module if it fails
+        lua_getfield(L, -1, name.c_str());
+        lua_pushnil(L);
+        lua_setfield(L, -3, name.c_str());
+        lua_getglobal(L, "require");
+        lua_pushstring(L, name.c_str());
+        if (lua_pcall(L, 1, 0, 0) != LUA_OK)
+        {
+            std::cout << "Can't reload " << fn << " :\n" << lua_tostring(L, -1) << std::endl;
+            lua_pop(L, 1);
+            lua_setfield(L, -2, name.c_str());
+        }
+        else
+            lua_pop(L, 1);
+        lua_pop(L, 2);
+        return true;
+    }
+    lua_pop(L, 2);
+    return false;
+}
+void HotReload()
+{
+    watchModules();
+
+    std::vector<std::string> changed;
+    Watcher_Poll(changed);
+
+    for (const std::string& fn : changed)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        bool reloaded = false;
+
+        // only the objects loaded from that file are touched
+        for (Image* img : images)
+        {
+            if (strcmp(img->path, fn.c_str()) != 0) continue;
+            if (reloadImage(img, img->path)) reloaded = true;
+            else std::cout << "Can't reload " << fn << " :\n" << SDL_GetError() << std::endl;
+        }
+        for (Sound* snd : sounds)
+        {
+            if (strcmp(snd->path, fn.c_str()) != 0) continue;
+            if (reloadSound(snd, snd->path)) reloaded = true;
+            else std::cout << "Can't reload " << fn << " :\n" << SDL_GetError() << std::endl;
+        }
+        for (Music* mus : musics)
+        {
+            if (strcmp(mus->path, fn.c_str()) != 0) continue;
+            if (reloadMusic(mus, mus->path)) reloaded = true;
+            else std::cout << "Can't reload " << fn << " :\n" << SDL_GetError() << std::endl;
+        }
+        if (fn.size() > 4 && fn.compare(fn.size() - 4, 4, ".lua") == 0)
+            reloaded = reloadModule(fn.c_str()) || reloaded;
+
+        if (reloaded)
+        {
+            double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+            std::cout << "reloaded " << fn << " (" << ms << " ms)" << std::endl;
+        }
+    }
+}
 #pragma endregion
 
 #pragma region Engine
@@ -135,6 +478,7 @@ static const luaL_Reg Engine_t[] = {
     {"Start", LuaSDL_Start},
     {"Copy", LuaSDL_Copy},
     {"PollEvents", LuaSDL_PollEvents},
+    {"GetInitStats", LuaSDL_GetInitStats},
     {NULL, NULL}
 };
 static const luaL_Reg Engine_Window_t[] = {
@@ -142,6 +486,11 @@ static const luaL_Reg Engine_Window_t[] = {
     {"SetSize", LuaSDL_Window_SetSize},
     {"GetPos", LuaSDL_Window_GetPos},
     {"SetPos", LuaSDL_Window_SetPos},
+    {"GetRenderStats", LuaSDL_Window_GetRenderStats},
+    {"SetIdle", LuaSDL_Window_SetIdle},
+    {"IsIdle", LuaSDL_Window_IsIdle},
+    {"Redraw", LuaSDL_Window_Redraw},
+    {"GetIdleStats", LuaSDL_Window_GetIdleStats},
     {NULL, NULL}
 };
 static const luaL_Reg Engine_Input_t[] = {
@@ -154,6 +503,62 @@ static const luaL_Reg Engine_Input_t[] = {
     {"GetMousePos", LuaSDL_Input_GetMousePos},
     {NULL, NULL}
 };
+static const luaL_Reg Engine_Pak_t[] = {
+    {"Mount", LuaSDL_Pak_Mount},
+    {NULL, NULL}
+};
+static const luaL_Reg Engine_HotReload_t[] = {
+    {"SetEnabled", LuaSDL_HotReload_SetEnabled},
+    {"IsEnabled", LuaSDL_HotReload_IsEnabled},
+    {NULL, NULL}
+};
+static const luaL_Reg Engine_Memory_t[] = {
+    {"GetAllocStats", LuaSDL_Memory_GetAllocStats},
+    {"GetStats", LuaSDL_Memory_GetStats},
+    {"SetLogInterval", LuaSDL_Memory_SetLogInterval},
+    {"GetLogInterval", LuaSDL_Memory_GetLogInterval},
+    {"SetLeakReport", LuaSDL_Memory_SetLeakReport},
+    {"GetLeakReport", LuaSDL_Memory_GetLeakReport},
+    {NULL, NULL}
+};
+static const luaL_Reg Engine_GC_t[] = {
+    {"SetBudget", LuaSDL_GC_SetBudget},
+    {"GetBudget", LuaSDL_GC_GetBudget},
+    {"SetMode", LuaSDL_GC_SetMode},
+    {"GetMode", LuaSDL_GC_GetMode},
+    {"GetStats", LuaSDL_GC_GetStats},
+    {NULL, NULL}
+};
+static const luaL_Reg Engine_Audio_t[] = {
+    {"Open", LuaSDL_Audio_Open},
+    {"Close", LuaSDL_Audio_Close},
+    {"QuerySpec", LuaSDL_Audio_QuerySpec},
+    {"GetLatency", LuaSDL_Audio_GetLatency},
+    {"GetStats", LuaSDL_Audio_GetStats},
+    {"ResetStats", LuaSDL_Audio_ResetStats},
+    {"SetNativeMixer", LuaSDL_Audio_SetNativeMixer},
+    {"IsNativeMixer", LuaSDL_Audio_IsNativeMixer},
+    {"GetMixerStats", LuaSDL_Audio_GetMixerStats},
+    {"SetListener", LuaSDL_Audio_SetListener},
+    {"GetListener", LuaSDL_Audio_GetListener},
+    {"SetAudibleRadius", LuaSDL_Audio_SetAudibleRadius},
+    {"GetAudibleRadius", LuaSDL_Audio_GetAudibleRadius},
+    {"GetSpatialStats", LuaSDL_Audio_GetSpatialStats},
+    {"SetVoiceLimit", LuaSDL_Audio_SetVoiceLimit},
+    {"GetVoiceLimit", LuaSDL_Audio_GetVoiceLimit},
+    {"GetVoiceStats", LuaSDL_Audio_GetVoiceStats},
+    {"SetBusEffects", LuaSDL_Audio_SetBusEffects},
+    {"GetBusTime", LuaSDL_Audio_GetBusTime},
+    {"SetSpectrum", LuaSDL_Audio_SetSpectrum},
+    {"GetSpectrum", LuaSDL_Audio_GetSpectrum},
+    {NULL, NULL}
+};
+static const luaL_Reg Engine_Cache_t[] = {
+    {"SetDir", LuaSDL_Cache_SetDir},
+    {"GetDir", LuaSDL_Cache_GetDir},
+    {"GetStats", LuaSDL_Cache_GetStats},
+    {NULL, NULL}
+};
 static const luaL_Reg Engine_Background_t[] = {
     {"SetColor", LuaSDL_Background_SetColor},
     {"GetColor", LuaSDL_Background_GetColor},
@@ -169,6 +574,9 @@ static const luaL_Reg Engine_Drawing_t[] = {
     {"FillRect", LuaSDL_Drawing_FillRect},
     {"DrawPixel", LuaSDL_Drawing_DrawPixel},
     {"DrawImage", LuaSDL_Drawing_DrawImage},
+    {"DrawPixels", LuaSDL_Drawing_DrawPixels},
+    {"DrawRects", LuaSDL_Drawing_DrawRects},
+    {"FillRects", LuaSDL_Drawing_FillRects},
     {NULL, NULL}
 };
 
@@ -178,12 +586,49 @@ static const luaL_Reg Color_t[] = {
 };
 static const luaL_Reg Image_t[] = {
     {"new", Image_new},
+    {"SetResidency", Image_SetResidency},
+    {"GetResidency", Image_GetResidency},
     {NULL, NULL}
 };
 static const luaL_Reg Sound_t[] = {
     {"new", Sound_new},
     {NULL, NULL}
 };
+static const luaL_Reg Music_t[] = {
+    {"new", Music_new},
+    {NULL, NULL}
+};
+static const luaL_Reg AudioStream_t[] = {
+    {"new", AudioStream_new},
+    {NULL, NULL}
+};
+static const luaL_Reg AudioGroup_t[] = {
+    {"new", AudioGroup_new},
+    {NULL, NULL}
+};
+static const luaL_Reg Vec2_t[] = {
+    {"new", Vec2_new},
+    {"AddScaledArray", Vec2_AddScaledArray},
+    {"AddArray", Vec2_AddArray},
+    {"ScaleArray", Vec2_ScaleArray},
+    {"RotateArray", Vec2_RotateArray},
+    {"NormalizeArray", Vec2_NormalizeArray},
+    {"LengthArray", Vec2_LengthArray},
+    {"GetStats", Vec2_GetStats},
+    {NULL, NULL}
+};
+static const luaL_Reg Float32Array_t[] = {
+    {"new", Float32Array_new},
+    {NULL, NULL}
+};
+static const luaL_Reg Int32Array_t[] = {
+    {"new", Int32Array_new},
+    {NULL, NULL}
+};
+static const luaL_Reg Uint8Array_t[] = {
+    {"new", Uint8Array_new},
+    {NULL, NULL}
+};
 
 static const luaL_Reg Color_mt[] = {
     {"__index", ColorGet},
@@ -196,6 +641,9 @@ static const luaL_Reg Image_mt[] = {
     {"__newindex", ImageSet},
     {"__tostring", ImageToString},
     {"__gc", ImageGC},
+
+    {"GetPixel", Image_GetPixel},
+    {"Release", Image_Release},
     {NULL, NULL}
 };
 static const luaL_Reg Sound_mt[] = {
@@ -206,32 +654,95 @@ static const luaL_Reg Sound_mt[] = {
 
     {"Play", Sound_PlaySound},
     {"Pause", Sound_PauseSound},
+    {"Resume", Sound_ResumeSound},
     {"Stop", Sound_StopSound},
     {"IsPlaying", Sound_IsSoundPlaying},
     {"IsPaused", Sound_IsSoundPaused},
+    {"SetEffects", Sound_SetEffects},
+    {"Release", Sound_Release},
+    {NULL, NULL}
+};
+static const luaL_Reg Music_mt[] = {
+    {"__index", MusicGet},
+    {"__newindex", MusicSet},
+    {"__tostring", MusicToString},
+    {"__gc", MusicGC},
+
+    {"Play", Music_Play},
+    {"Pause", Music_Pause},
+    {"Resume", Music_Resume},
+    {"Stop", Music_Stop},
+    {"Seek", Music_Seek},
+    {"FadeIn", Music_FadeIn},
+    {"FadeOut", Music_FadeOut},
+    {"IsPlaying", Music_IsPlaying},
+    {"IsPaused", Music_IsPaused},
+    {"GetPosition", Music_GetPosition},
+    {"Release", Music_Release},
+    {NULL, NULL}
+};
+static const luaL_Reg AudioStream_mt[] = {
+    {"__index", AudioStreamGet},
+    {"__newindex", AudioStreamSet},
+    {"__tostring", AudioStreamToString},
+    {"__gc", AudioStreamGC},
+
+    {"Write", AudioStream_Write},
+    {"Play", AudioStream_Play},
+    {"Pause", AudioStream_Pause},
+    {"IsPlaying", AudioStream_IsPlaying},
+    {"GetFill", AudioStream_GetFill},
+    {"GetUnderruns", AudioStream_GetUnderruns},
+    {"Release", AudioStream_Release},
+    {NULL, NULL}
+};
+static const luaL_Reg AudioGroup_mt[] = {
+    {"__index", AudioGroupGet},
+    {"__newindex", AudioGroupSet},
+    {"__tostring", AudioGroupToString},
+    {"__gc", AudioGroupGC},
+
+    {"FadeTo", AudioGroup_FadeTo},
+    {"IsFading", AudioGroup_IsFading},
+    {"Pause", AudioGroup_Pause},
+    {"Resume", AudioGroup_Resume},
+    {"Stop", AudioGroup_Stop},
+    {"Release", AudioGroup_Release},
+    {NULL, NULL}
+};
+static const luaL_Reg Vec2_mt[] = {
+    {"__index", Vec2Get},
+    {"__newindex", Vec2Set},
+    {"__add", Vec2Add},
+    {"__sub", Vec2Sub},
+    {"__mul", Vec2Mul},
+    {"__div", Vec2Div},
+    {"__unm", Vec2Unm},
+    {"__eq", Vec2Eq},
+    {"__tostring", Vec2ToString},
+
+    {"Length", Vec2_Length},
+    {"Normalize", Vec2_Normalize},
+    {"Rotate", Vec2_Rotate},
+    {"Dot", Vec2_Dot},
+    {NULL, NULL}
+};
+// shared by the three typed arrays
+static const luaL_Reg TypedArray_mt[] = {
+    {"__index", TypedArrayGet},
+    {"__newindex", TypedArraySet},
+    {"__len", TypedArrayLen},
+    {"__tostring", TypedArrayToString},
+
+    {"Slice", TypedArray_Slice},
+    {"Fill", TypedArray_Fill},
+    {"Set", TypedArray_Set},
+    {"ToTable", TypedArray_ToTable},
     {NULL, NULL}
 };
 
 void LoadEngine(lua_State* L)
 {
-    Uint32 imgFlags = IMG_INIT_JPG | IMG_INIT_PNG;
-    if (IMG_Init(imgFlags) != imgFlags)
-    {
-        std::cout << "Can't initialize SDL_image :\n" << SDL_GetError() << std::endl;
-        QuitAll();
-        exit(1);
-    }
-    IMGInited = true;
-    Uint32 mixFlags = MIX_INIT_MP3 | MIX_INIT_OGG;
-    if (Mix_Init(mixFlags) != mixFlags)
-    {
-        std::cout << "Can't initialize SDL_mixer :\n" << SDL_GetError() << std::endl;
-        QuitAll();
-        exit(1);
-    }
-    MIXInited = true;
-
-
     // datatypes metatables
     luaL_newmetatable(L, COLOR_TYPE_NAME);
     lua_pushvalue(L, -1);
@@ -248,6 +759,41 @@ void LoadEngine(lua_State* L)
     lua_setfield(L, -2, "__index");
     luaL_setfuncs(L, Sound_mt, 0);
 
+    luaL_newmetatable(L, MUSIC_TYPE_NAME);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, Music_mt, 0);
+
+    luaL_newmetatable(L, AUDIOSTREAM_TYPE_NAME);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, AudioStream_mt, 0);
+
+    luaL_newmetatable(L, AUDIOGROUP_TYPE_NAME);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, AudioGroup_mt, 0);
+
+    luaL_newmetatable(L, VEC2_TYPE_NAME);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, Vec2_mt, 0);
+
+    luaL_newmetatable(L, FLOAT32ARRAY_TYPE_NAME);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, TypedArray_mt, 0);
+
+    luaL_newmetatable(L, INT32ARRAY_TYPE_NAME);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, TypedArray_mt, 0);
+
+    luaL_newmetatable(L, UINT8ARRAY_TYPE_NAME);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, TypedArray_mt, 0);
+
 
     // [ENGINENAME]
     lua_createtable(L, 0, 0);
@@ -269,6 +815,30 @@ void LoadEngine(lua_State* L)
     lua_createtable(L, 0, 0);
     luaL_setfuncs(L, Engine_Drawing_t, 0);
     lua_setfield(L, -2, "Drawing");
+    // [ENGINENAME].Pak
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Engine_Pak_t, 0);
+    lua_setfield(L, -2, "Pak");
+    // [ENGINENAME].Cache
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Engine_Cache_t, 0);
+    lua_setfield(L, -2, "Cache");
+    // [ENGINENAME].HotReload
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Engine_HotReload_t, 0);
+    lua_setfield(L, -2, "HotReload");
+    // [ENGINENAME].Memory
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Engine_Memory_t, 0);
+    lua_setfield(L, -2, "Memory");
+    // [ENGINENAME].GC
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Engine_GC_t, 0);
+    lua_setfield(L, -2, "GC");
+    // [ENGINENAME].Audio
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Engine_Audio_t, 0);
+    lua_setfield(L, -2, "Audio");
 
     lua_setglobal(L, ENGINENAME);
 
@@ -284,6 +854,34 @@ void LoadEngine(lua_State* L)
     lua_createtable(L, 0, 0);
     luaL_setfuncs(L, Sound_t, 0);
     lua_setglobal(L, SOUND_TYPE_NAME);
+    // [MUSIC_TYPE_NAME]
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Music_t, 0);
+    lua_setglobal(L, MUSIC_TYPE_NAME);
+    // [AUDIOSTREAM_TYPE_NAME]
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, AudioStream_t, 0);
+    lua_setglobal(L, AUDIOSTREAM_TYPE_NAME);
+    // [AUDIOGROUP_TYPE_NAME]
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, AudioGroup_t, 0);
+    lua_setglobal(L, AUDIOGROUP_TYPE_NAME);
+    // [VEC2_TYPE_NAME]
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Vec2_t, 0);
+    lua_setglobal(L, VEC2_TYPE_NAME);
+    // [FLOAT32ARRAY_TYPE_NAME]
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Float32Array_t, 0);
+    lua_setglobal(L, FLOAT32ARRAY_TYPE_NAME);
+    // [INT32ARRAY_TYPE_NAME]
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Int32Array_t, 0);
+    lua_setglobal(L, INT32ARRAY_TYPE_NAME);
+    // [UINT8ARRAY_TYPE_NAME]
+    lua_createtable(L, 0, 0);
+    luaL_setfuncs(L, Uint8Array_t, 0);
+    lua_setglobal(L, UINT8ARRAY_TYPE_NAME);
 }
 
 static int LuaSDL_Start(lua_State* L)
@@ -295,21 +893,29 @@ static int LuaSDL_Start(lua_State* L)
     int height = (argc > 2 && !lua_isnoneornil(L, 3)) ? (int)lua_tonumber(L, 3) : 600;
     int x = (argc > 3 && !lua_isnoneornil(L, 4)) ? (int)lua_tonumber(L, 4) : SDL_WINDOWPOS_CENTERED;
     int y = (argc > 4 && !lua_isnoneornil(L, 5)) ? (int)lua_tonumber(L, 5) : SDL_WINDOWPOS_CENTERED;
-    if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
+    bool pipelined = argc > 5 && lua_toboolean(L, 6);
+    if (!Subsystem_Init(SDL_INIT_VIDEO))
     {
         std::cout << "Can't initialize SDL :\n" << SDL_GetError() << std::endl;
         QuitAll();
         exit(1);
     }
     SDLInited = true;
+    Startup_Begin("SDL_CreateWindow", NULL);
     window = SDL_CreateWindow(title, x, y, width, height, SDL_WINDOW_SHOWN);
+    Startup_End();
     if (window == NULL)
     {
         std::cout << "Can't create window : \n" << SDL_GetError() << std::endl;
         QuitAll();
         exit(1);
     }
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    Startup_Begin("SDL_CreateRenderer", pipelined ? "pipelined" : NULL);
+    if (pipelined)
+        renderer = Pipeline_Start(window, SDL_RENDERER_ACCELERATED);
+    else
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    Startup_End();
     if (renderer == NULL)
     {
         std::cout << "Can't create renderer : \n" << SDL_GetError() << std::endl;
@@ -319,17 +925,27 @@ static int LuaSDL_Start(lua_State* L)
 
     return 0;
 }
+static int LuaSDL_GetInitStats(lua_State* L)
+{
+    const SubsystemStats* stats;
+    int count = Subsystem_GetStats(&stats);
+
+    lua_createtable(L, 0, count);
+    for (int i = 0; i < count; i++)
+    {
+        lua_pushnumber(L, stats[i].time);
+        lua_setfield(L, -2, stats[i].name);
+    }
+
+    return 1;
+}
 static int LuaSDL_PollEvents(lua_State* L)
 {
     int argc = lua_gettop(L);
 
     SDL_Event event;
     while (SDL_PollEvent(&event))
-    {
-        if (event.type == SDL_QUIT) running = false;
-
-        keys = SDL_GetKeyboardState(NULL);
-    }
+        HandleEvent(&event);
 
     return 0;
 }
@@ -381,6 +997,69 @@ static int LuaSDL_Window_SetPos(lua_State* L)
     SDL_SetWindowPosition(window, x, y);
     return 0;
 }
+static int LuaSDL_Window_GetRenderStats(lua_State* L)
+{
+    const PipelineStats* stats = Pipeline_GetStats();
+
+    lua_createtable(L, 0, 6);
+    lua_pushboolean(L, stats->pipelined);
+    lua_setfield(L, -2, "pipelined");
+    lua_pushinteger(L, (lua_Integer)stats->frames);
+    lua_setfield(L, -2, "frames");
+    lua_pushnumber(L, stats->frameTime);
+    lua_setfield(L, -2, "frameTime");
+    lua_pushnumber(L, stats->renderTime);
+    lua_setfield(L, -2, "renderTime");
+    lua_pushnumber(L, stats->waitTime);
+    lua_setfield(L, -2, "waitTime");
+    lua_pushnumber(L, stats->latency);
+    lua_setfield(L, -2, "latency");
+
+    return 1;
+}
+static int LuaSDL_Window_SetIdle(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, boolean, 1);
+
+    lua_Integer timeout = (argc > 1 && !lua_isnoneornil(L, 2)) ? luaL_checkinteger(L, 2) : IDLE_DEFAULT_TIMEOUT;
+    luaL_argcheck(L, timeout >= 0, 2, "timeout must be positive");
+
+    Idle_Enable(lua_toboolean(L, 1), (Uint32)timeout);
+    return 0;
+}
+static int LuaSDL_Window_IsIdle(lua_State* L)
+{
+    lua_pushboolean(L, Idle_IsEnabled());
+    return 1;
+}
+static int LuaSDL_Window_Redraw(lua_State*)
+{
+    Idle_Redraw();
+    return 0;
+}
+static int LuaSDL_Window_GetIdleStats(lua_State* L)
+{
+    const IdleStats* stats = Idle_GetStats();
+
+    lua_createtable(L, 0, 7);
+    lua_pushboolean(L, stats->enabled);
+    lua_setfield(L, -2, "idle");
+    lua_pushinteger(L, (lua_Integer)stats->frames);
+    lua_setfield(L, -2, "frames");
+    lua_pushinteger(L, (lua_Integer)stats->wakeups);
+    lua_setfield(L, -2, "wakeups");
+    lua_pushinteger(L, (lua_Integer)stats->suspended);
+    lua_setfield(L, -2, "suspended");
+    lua_pushnumber(L, stats->cpu);
+    lua_setfield(L, -2, "cpu");
+    lua_pushnumber(L, stats->wakeLatency);
+    lua_setfield(L, -2, "wakeLatency");
+    lua_pushnumber(L, stats->maxWakeLatency);
+    lua_setfield(L, -2, "maxWakeLatency");
+
+    return 1;
+}
 
 // user inputs
 static int LuaSDL_Input_IsKeyDown(lua_State* L)
@@ -456,368 +1135,2701 @@ static int LuaSDL_Input_GetMousePos(lua_State* L)
     return 2;
 }
 
-// data types
-static int Image_new(lua_State* L)
+// asset archives
+static int LuaSDL_Pak_Mount(lua_State* L)
 {
-    if (!IMGInited) return 0;
     int argc = lua_gettop(L);
     luaL_checkArgType(L, string, 1);
-    const char* fn = lua_tostring(L, 1);
 
-    Image* img = (Image*)lua_newuserdata(L, sizeof(Image));
-    if (img == NULL)
+    const char* path = lua_tostring(L, 1);
+
+    if (!Pak_Mount(path))
     {
-        std::cout << "Can't create image : \n" << SDL_GetError() << std::endl;
-        QuitAll();
-        exit(1);
+        std::cout << "Can't mount archive :\n" << SDL_GetError() << std::endl;
+        lua_pushboolean(L, 0);
+        return 1;
     }
-    reloadImage(img, fn);
-
-    luaL_getmetatable(L, IMAGE_TYPE_NAME);
-    lua_setmetatable(L, -2);
 
+    lua_pushboolean(L, 1);
     return 1;
 }
-static int ImageSet(lua_State* L)
+
+// texture cache
+static int LuaSDL_Cache_SetDir(lua_State* L)
 {
     int argc = lua_gettop(L);
-    Image* img = (Image*)lua_touserdata(L, 1);
-    const char* k = lua_tostring(L, 2);
-    const char* v = lua_tostring(L, 3);
-
-    lua_pushstring(L, "path");
+    luaL_argcheck(L,
+        lua_isstring(L, 1) || lua_isnoneornil(L, 1),
+        1,
+        (std::string("string expected, got ") + luaL_typename(L, 1)).c_str()
+    );
 
-    if (lua_compare(L, 3, 4, LUA_OPEQ)) {
-        reloadImage(img, v);
-    }
+    TexCache_SetDir(lua_isnoneornil(L, 1) ? NULL : lua_tostring(L, 1));
 
     return 0;
 }
-static int ImageGet(lua_State* L)
+static int LuaSDL_Cache_GetDir(lua_State* L)
 {
-    int argc = lua_gettop(L);
-    Image* img = (Image*)lua_touserdata(L, 1);
-
-    lua_pushstring(L, "path");      //3
-    lua_pushstring(L, "width");     //4
-    lua_pushstring(L, "height");    //5
+    const char* dir = TexCache_GetDir();
+    if (dir == NULL)
+        lua_pushnil(L);
+    else
+        lua_pushstring(L, dir);
 
-    lua_pushnil(L);
-
-    if (lua_compare(L, 2, 3, LUA_OPEQ))
-        lua_pushstring(L, img->path);
-    else if (lua_compare(L, 2, 4, LUA_OPEQ))
-        lua_pushnumber(L, img->surf->clip_rect.w);
-    else if (lua_compare(L, 2, 5, LUA_OPEQ))
-        lua_pushnumber(L, img->surf->clip_rect.h);
+    return 1;
+}
+static int LuaSDL_Cache_GetStats(lua_State* L)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, imageCacheStats.hits);
+    lua_setfield(L, -2, "hits");
+    lua_pushinteger(L, imageCacheStats.misses);
+    lua_setfield(L, -2, "misses");
+    lua_pushnumber(L, imageCacheStats.hitTime);
+    lua_setfield(L, -2, "hitTime");
+    lua_pushnumber(L, imageCacheStats.missTime);
+    lua_setfield(L, -2, "missTime");
 
     return 1;
 }
-static int ImageToString(lua_State* L)
+
+// hot reload
+static int LuaSDL_HotReload_SetEnabled(lua_State* L)
 {
     int argc = lua_gettop(L);
+    luaL_checkArgType(L, boolean, 1);
 
-    Image* img = (Image*)lua_touserdata(L, 1);
+    if (!lua_toboolean(L, 1))
+    {
+        Watcher_Stop();
+        watchedModules.clear();
+        return 0;
+    }
+    if (Watcher_IsRunning()) return 0;
+    if (!Watcher_Start())
+    {
+        std::cout << "Can't watch files :\n" << SDL_GetError() << std::endl;
+        return 0;
+    }
 
-    lua_pushfstring(L, IMAGE_TYPE_NAME " %s", img->path);
+    Watcher_Add("main.lua");
+    for (Image* img : images)
+        Watcher_Add(img->path);
+    for (Sound* snd : sounds)
+        Watcher_Add(snd->path);
+    for (Music* mus : musics)
+        Watcher_Add(mus->path);
+    watchModules();
 
+    return 0;
+}
+static int LuaSDL_HotReload_IsEnabled(lua_State* L)
+{
+    lua_pushboolean(L, Watcher_IsRunning());
     return 1;
 }
-static int ImageGC(lua_State* L)
+
+// memory
+static int LuaSDL_Memory_GetAllocStats(lua_State* L)
 {
-    int argc = lua_gettop(L);
-    Image* img = (Image*)lua_touserdata(L, 1);
+    const AllocStats* stats = Pool_GetStats();
+
+    lua_createtable(L, 0, 8);
+    lua_pushinteger(L, (lua_Integer)stats->allocs);
+    lua_setfield(L, -2, "allocs");
+    lua_pushinteger(L, (lua_Integer)stats->frees);
+    lua_setfield(L, -2, "frees");
+    lua_pushinteger(L, (lua_Integer)stats->reallocs);
+    lua_setfield(L, -2, "reallocs");
+    lua_pushinteger(L, (lua_Integer)stats->smallAllocs);
+    lua_setfield(L, -2, "smallAllocs");
+    lua_pushinteger(L, (lua_Integer)stats->largeAllocs);
+    lua_setfield(L, -2, "largeAllocs");
+    lua_pushinteger(L, (lua_Integer)stats->bytes);
+    lua_setfield(L, -2, "bytes");
+    lua_pushinteger(L, (lua_Integer)stats->peak);
+    lua_setfield(L, -2, "peak");
+    lua_pushinteger(L, (lua_Integer)stats->reserved);
+    lua_setfield(L, -2, "reserved");
 
-    SDL_DestroyTexture(SDL_CreateTextureFromSurface(renderer, img->surf));
-    return 0;
+    return 1;
 }
-
-static void reloadImage(Image* img, const char* fn)
+static int LuaSDL_Memory_GetStats(lua_State* L)
 {
-    img->surf = IMG_Load(fn);
-    if (img->surf == NULL)
+    lua_createtable(L, 0, MEM_CATEGORIES);
+    for (int i = 0; i < MEM_CATEGORIES; i++)
     {
-        std::cout << "Can't create image : \n" << SDL_GetError() << std::endl;
-        QuitAll();
-        exit(1);
+        const MemCounter* c = Mem_Get(L, (MemCategory)i);
+
+        lua_createtable(L, 0, 3);
+        lua_pushinteger(L, (lua_Integer)c->bytes);
+        lua_setfield(L, -2, "bytes");
+        lua_pushinteger(L, (lua_Integer)c->peak);
+        lua_setfield(L, -2, "peak");
+        lua_pushinteger(L, (lua_Integer)c->count);
+        lua_setfield(L, -2, "count");
+        lua_setfield(L, -2, Mem_Name((MemCategory)i));
     }
-    img->path = fn;
+
+    return 1;
+}
+static int LuaSDL_Memory_SetLogInterval(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, number, 1);
+
+    Mem_SetLogInterval(lua_tonumber(L, 1));
+
+    return 0;
+}
+static int LuaSDL_Memory_GetLogInterval(lua_State* L)
+{
+    lua_pushnumber(L, Mem_GetLogInterval());
+    return 1;
+}
+static int LuaSDL_Memory_SetLeakReport(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, boolean, 1);
+
+    Mem_SetLeakReport(lua_toboolean(L, 1));
+
+    return 0;
+}
+static int LuaSDL_Memory_GetLeakReport(lua_State* L)
+{
+    lua_pushboolean(L, Mem_GetLeakReport());
+    return 1;
+}
+
+// garbage collector
+static const char* const gcModes[] = { "auto", "incremental", "generational", NULL };
+
+static int LuaSDL_GC_SetBudget(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, number, 1);
+
+    Gc_SetBudget(L, lua_tonumber(L, 1));
+
+    return 0;
+}
+static int LuaSDL_GC_GetBudget(lua_State* L)
+{
+    lua_pushnumber(L, Gc_GetBudget());
+    return 1;
+}
+static int LuaSDL_GC_SetMode(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    Gc_SetMode(L, (GcMode)luaL_checkoption(L, 1, NULL, gcModes));
+
+    return 0;
+}
+static int LuaSDL_GC_GetMode(lua_State* L)
+{
+    lua_pushstring(L, gcModes[Gc_GetMode()]);
+    lua_pushstring(L, gcModes[Gc_GetStats()->active]);
+    return 2;
+}
+static int LuaSDL_GC_GetStats(lua_State* L)
+{
+    const GcStats* stats = Gc_GetStats();
+
+    lua_createtable(L, 0, 6);
+    lua_pushnumber(L, stats->frameTime);
+    lua_setfield(L, -2, "frameTime");
+    lua_pushinteger(L, stats->frameSteps);
+    lua_setfield(L, -2, "frameSteps");
+    lua_pushinteger(L, (lua_Integer)stats->cycles);
+    lua_setfield(L, -2, "cycles");
+    lua_pushinteger(L, (lua_Integer)stats->overruns);
+    lua_setfield(L, -2, "overruns");
+    lua_pushstring(L, gcModes[stats->active]);
+    lua_setfield(L, -2, "mode");
+    lua_pushinteger(L, (lua_Integer)lua_gc(L, LUA_GCCOUNT));
+    lua_setfield(L, -2, "heap");
+
+    return 1;
+}
+
+// audio
+static const char* const audioFormats[] = { "u8", "s8", "s16", "s32", "f32", NULL };
+static const SDL_AudioFormat audioFormatValues[] = { AUDIO_U8, AUDIO_S8, AUDIO_S16SYS, AUDIO_S32SYS, AUDIO_F32SYS };
+// kept to rebuild the bus for a new device
+static DspParams busEffects[DSP_MAX_CHAIN];
+static int busEffectCount = 0;
+
+static bool openAudio(const AudioSpec* spec)
+{
+    // closing the mixer halts every channel and music, and drops the extra channels
+    bool native = Mixer_IsRunning();
+    Mixer_Stop();
+    Voice_Reset();
+    currentMusic = NULL;
+    if (!Audio_Open(spec)) return false;
+
+    // chunks are converted to the device format when loaded, never while mixing,
+    // one that can't be loaded again would play in the old format, so it is dropped
+    for (Sound* snd : sounds)
+    {
+        if (reloadSound(snd, snd->path)) continue;
+        std::cout << "Can't reload " << snd->path << " :\n" << SDL_GetError() << std::endl;
+        if (snd->snd != NULL)
+            Mixer_Release(snd, freeChunk, snd->snd);
+        snd->snd = NULL;
+    }
+    // the music is decoded as it plays, the previous one still works
+    for (Music* mus : musics)
+    {
+        if (!reloadMusic(mus, mus->path))
+            std::cout << "Can't reload " << mus->path << " :\n" << SDL_GetError() << std::endl;
+    }
+    if (!Dsp_SetBus(busEffects, busEffectCount, Audio_GetSpec()))
+        std::cout << "Can't apply the bus effects :\n" << SDL_GetError() << std::endl;
+
+    if (native && !Mixer_Start(Audio_GetSpec()))
+        std::cout << "Can't start the native mixer :\n" << SDL_GetError() << std::endl;
+    return true;
+}
+static bool ensureAudio()
+{
+    if (Audio_IsOpen()) return true;
+
+    AudioSpec spec = { AUDIO_DEFAULT_FREQUENCY, AUDIO_DEFAULT_FORMAT, AUDIO_DEFAULT_CHANNELS, AUDIO_DEFAULT_CHUNKSIZE };
+    if (openAudio(&spec)) return true;
+
+    std::cout << "Can't open audio device :\n" << SDL_GetError() << std::endl;
+    return false;
+}
+
+static int LuaSDL_Audio_Open(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    AudioSpec spec = { AUDIO_DEFAULT_FREQUENCY, AUDIO_DEFAULT_FORMAT, AUDIO_DEFAULT_CHANNELS, AUDIO_DEFAULT_CHUNKSIZE };
+
+    if (argc > 0)
+    {
+        luaL_checkArgType(L, table, 1);
+        lua_getfield(L, 1, "frequency");
+        spec.frequency = (int)luaL_optinteger(L, -1, spec.frequency);
+        lua_getfield(L, 1, "format");
+        spec.format = audioFormatValues[luaL_checkoption(L, -1, "s16", audioFormats)];
+        lua_getfield(L, 1, "channels");
+        spec.channels = (int)luaL_optinteger(L, -1, spec.channels);
+        lua_getfield(L, 1, "chunksize");
+        spec.chunksize = (int)luaL_optinteger(L, -1, spec.chunksize);
+        lua_pop(L, 4);
+    }
+
+    bool opened = openAudio(&spec);
+    if (!opened)
+        std::cout << "Can't open audio device :\n" << SDL_GetError() << std::endl;
+    lua_pushboolean(L, opened);
+
+    return 1;
+}
+static int LuaSDL_Audio_Close(lua_State*)
+{
+    Mixer_Stop();
+    Voice_Reset();
+    currentMusic = NULL;
+    Audio_Close();
+
+    return 0;
+}
+static int LuaSDL_Audio_QuerySpec(lua_State* L)
+{
+    if (!Audio_IsOpen()) return 0;
+    const AudioSpec* spec = Audio_GetSpec();
+
+    const char* format = NULL;
+    for (int i = 0; audioFormats[i] != NULL; i++)
+        if (audioFormatValues[i] == spec->format) format = audioFormats[i];
+
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, spec->frequency);
+    lua_setfield(L, -2, "frequency");
+    lua_pushstring(L, format);
+    lua_setfield(L, -2, "format");
+    lua_pushinteger(L, spec->channels);
+    lua_setfield(L, -2, "channels");
+    lua_pushinteger(L, spec->chunksize);
+    lua_setfield(L, -2, "chunksize");
+
+    return 1;
+}
+static int LuaSDL_Audio_GetLatency(lua_State* L)
+{
+    AudioLatency latency = Audio_GetLatency();
+
+    lua_createtable(L, 0, 5);
+    lua_pushnumber(L, latency.buffer);
+    lua_setfield(L, -2, "buffer");
+    lua_pushnumber(L, latency.estimate);
+    lua_setfield(L, -2, "estimate");
+    lua_pushnumber(L, latency.interval);
+    lua_setfield(L, -2, "interval");
+    lua_pushnumber(L, latency.maxInterval);
+    lua_setfield(L, -2, "maxInterval");
+    lua_pushinteger(L, (lua_Integer)latency.callbacks);
+    lua_setfield(L, -2, "callbacks");
+
+    return 1;
+}
+static int LuaSDL_Audio_GetStats(lua_State* L)
+{
+    AudioStats stats = Audio_GetStats();
+
+    lua_createtable(L, 0, 9);
+    lua_pushinteger(L, (lua_Integer)stats.callbacks);
+    lua_setfield(L, -2, "callbacks");
+    lua_pushnumber(L, stats.callbackTime);
+    lua_setfield(L, -2, "callbackTime");
+    lua_pushnumber(L, stats.maxCallbackTime);
+    lua_setfield(L, -2, "maxCallbackTime");
+    lua_pushnumber(L, stats.budget);
+    lua_setfield(L, -2, "budget");
+    lua_pushnumber(L, (stats.budget > 0.0) ? stats.callbackTime / stats.budget : 0.0);
+    lua_setfield(L, -2, "load");
+    lua_createtable(L, AUDIO_HISTOGRAM_BUCKETS, 0);
+    for (int i = 0; i < AUDIO_HISTOGRAM_BUCKETS; i++)
+    {
+        lua_pushinteger(L, (lua_Integer)stats.histogram[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "histogram");
+    lua_pushinteger(L, (lua_Integer)stats.late);
+    lua_setfield(L, -2, "late");
+    lua_pushinteger(L, (lua_Integer)stats.underruns);
+    lua_setfield(L, -2, "underruns");
+    lua_pushinteger(L, (lua_Integer)stats.overruns);
+    lua_setfield(L, -2, "overruns");
+    lua_pushinteger(L, stats.fill);
+    lua_setfield(L, -2, "fill");
+
+    return 1;
+}
+static int LuaSDL_Audio_ResetStats(lua_State*)
+{
+    Audio_ResetStats();
+    return 0;
+}
+static int LuaSDL_Audio_SetNativeMixer(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, boolean, 1);
+
+    if (!lua_toboolean(L, 1))
+    {
+        Mixer_Stop();
+        lua_pushboolean(L, true);
+        return 1;
+    }
+    if (!ensureAudio())
+    {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+
+    bool started = Mixer_Start(Audio_GetSpec());
+    if (!started)
+        std::cout << "Can't start the native mixer :\n" << SDL_GetError() << std::endl;
+    lua_pushboolean(L, started);
+
+    return 1;
+}
+static int LuaSDL_Audio_IsNativeMixer(lua_State* L)
+{
+    lua_pushboolean(L, Mixer_IsRunning());
+    return 1;
+}
+static int LuaSDL_Audio_GetMixerStats(lua_State* L)
+{
+    const MixerStats* stats = Mixer_GetStats();
+
+    lua_createtable(L, 0, 8);
+    lua_pushinteger(L, stats->voices);
+    lua_setfield(L, -2, "voices");
+    lua_pushinteger(L, (lua_Integer)stats->commands);
+    lua_setfield(L, -2, "commands");
+    lua_pushinteger(L, (lua_Integer)stats->dropped);
+    lua_setfield(L, -2, "dropped");
+    lua_pushinteger(L, (lua_Integer)stats->steals);
+    lua_setfield(L, -2, "steals");
+    lua_pushinteger(L, (lua_Integer)stats->drops);
+    lua_setfield(L, -2, "drops");
+    lua_pushnumber(L, stats->callbackTime);
+    lua_setfield(L, -2, "callbackTime");
+    lua_pushnumber(L, stats->maxCallbackTime);
+    lua_setfield(L, -2, "maxCallbackTime");
+    lua_pushstring(L, stats->kernel);
+    lua_setfield(L, -2, "kernel");
+
+    return 1;
+}
+static int LuaSDL_Audio_SetListener(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, number, 1);
+    luaL_checkArgType(L, number, 2);
+
+    Spatial_SetListener((float)lua_tonumber(L, 1), (float)lua_tonumber(L, 2));
+
+    return 0;
+}
+static int LuaSDL_Audio_GetListener(lua_State* L)
+{
+    float x, y;
+    Spatial_GetListener(&x, &y);
+
+    lua_pushnumber(L, x);
+    lua_pushnumber(L, y);
+
+    return 2;
+}
+static int LuaSDL_Audio_SetAudibleRadius(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, number, 1);
+
+    Spatial_SetRadius((float)lua_tonumber(L, 1));
+
+    return 0;
+}
+static int LuaSDL_Audio_GetAudibleRadius(lua_State* L)
+{
+    lua_pushnumber(L, Spatial_GetRadius());
+    return 1;
+}
+static int LuaSDL_Audio_GetSpatialStats(lua_State* L)
+{
+    const SpatialStats* stats = Spatial_GetStats();
+
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, stats->emitters);
+    lua_setfield(L, -2, "emitters");
+    lua_pushinteger(L, stats->culled);
+    lua_setfield(L, -2, "culled");
+    lua_pushnumber(L, stats->time);
+    lua_setfield(L, -2, "time");
+
+    return 1;
+}
+static int LuaSDL_Audio_SetVoiceLimit(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, integer, 1);
+
+    Voice_SetLimit((int)lua_tointeger(L, 1));
+
+    return 0;
+}
+static int LuaSDL_Audio_GetVoiceLimit(lua_State* L)
+{
+    lua_pushinteger(L, Voice_GetLimit());
+    return 1;
+}
+static int LuaSDL_Audio_GetVoiceStats(lua_State* L)
+{
+    const VoiceStats* stats = Voice_GetStats();
+
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, stats->allocated);
+    lua_setfield(L, -2, "allocated");
+    lua_pushinteger(L, stats->playing);
+    lua_setfield(L, -2, "playing");
+    lua_pushinteger(L, (lua_Integer)stats->steals);
+    lua_setfield(L, -2, "steals");
+    lua_pushinteger(L, (lua_Integer)stats->drops);
+    lua_setfield(L, -2, "drops");
+
+    return 1;
+}
+static int LuaSDL_Audio_SetBusEffects(lua_State* L)
+{
+    DspParams effects[DSP_MAX_CHAIN];
+    int count = readEffects(L, 1, effects);
+
+    // checked against the device now, or when it opens
+    bool applied = !Audio_IsOpen() || Dsp_SetBus(effects, count, Audio_GetSpec());
+    if (applied)
+    {
+        SDL_memcpy(busEffects, effects, count * sizeof(DspParams));
+        busEffectCount = count;
+    }
+    lua_pushboolean(L, applied);
+
+    return 1;
+}
+static int LuaSDL_Audio_GetBusTime(lua_State* L)
+{
+    lua_pushnumber(L, Dsp_GetBusTime());
+    return 1;
+}
+
+// table GetSpectrum fills, in the registry
+static int spectrumRef = LUA_NOREF;
+static Uint32 spectrumOnsets = 0;
+
+static int LuaSDL_Audio_SetSpectrum(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, boolean, 1);
+    int bands = (int)luaL_optinteger(L, 2, SPECTRUM_DEFAULT_BANDS);
+    luaL_argcheck(L, bands >= 1 && bands <= SPECTRUM_MAX_BANDS, 2, "1 to 32 bands expected");
+
+    Spectrum_Stop();
+    bool started = true;
+    if (lua_toboolean(L, 1))
+    {
+        started = Spectrum_Start(bands);
+        if (!started)
+            std::cout << "Can't start the spectrum analysis :\n" << SDL_GetError() << std::endl;
+    }
+    spectrumOnsets = 0;
+
+    // sized for the bands once, then only refilled
+    luaL_unref(L, LUA_REGISTRYINDEX, spectrumRef);
+    lua_createtable(L, bands, 5);
+    spectrumRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_pushboolean(L, started);
+
+    return 1;
+}
+static int LuaSDL_Audio_GetSpectrum(lua_State* L)
+{
+    SpectrumFrame frame;
+    Spectrum_Get(&frame);
+
+    if (spectrumRef == LUA_NOREF)
+    {
+        lua_createtable(L, frame.bandCount, 5);
+        lua_pushvalue(L, -1);
+        spectrumRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    else
+        lua_rawgeti(L, LUA_REGISTRYINDEX, spectrumRef);
+
+    for (int b = 0; b < frame.bandCount; b++)
+    {
+        lua_pushnumber(L, frame.bands[b]);
+        lua_rawseti(L, -2, b + 1);
+    }
+    lua_pushboolean(L, frame.onsets != spectrumOnsets);
+    lua_setfield(L, -2, "onset");
+    spectrumOnsets = frame.onsets;
+    lua_pushnumber(L, frame.flux);
+    lua_setfield(L, -2, "flux");
+    lua_pushinteger(L, (lua_Integer)frame.analyses);
+    lua_setfield(L, -2, "analyses");
+    lua_pushinteger(L, (lua_Integer)frame.dropped);
+    lua_setfield(L, -2, "dropped");
+    lua_pushnumber(L, frame.time);
+    lua_setfield(L, -2, "time");
+
+    return 1;
+}
+
+// data types
+static int Image_new(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, string, 1);
+    const char* fn = lua_tostring(L, 1);
+
+    Image* img = (Image*)lua_newuserdata(L, sizeof(Image));
+    if (img == NULL)
+    {
+        std::cout << "Can't create image : \n" << SDL_GetError() << std::endl;
+        QuitAll();
+        exit(1);
+    }
+    img->surf = NULL;
+    img->tex = NULL;
+    img->path = NULL;
+    img->w = img->h = 0;
+    img->residency = imageResidency;
+    if (!reloadImage(img, fn))
+    {
+        std::cout << "Can't create image : \n" << SDL_GetError() << std::endl;
+        QuitAll();
+        exit(1);
+    }
+    images.push_back(img);
+
+    luaL_getmetatable(L, IMAGE_TYPE_NAME);
+    lua_setmetatable(L, -2);
+
+    return 1;
+}
+static int Image_SetResidency(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    imageResidency = luaL_checkoption(L, 1, NULL, imageResidencies);
+
+    return 0;
+}
+static int Image_GetResidency(lua_State* L)
+{
+    lua_pushstring(L, imageResidencies[imageResidency]);
+    return 1;
+}
+static int ImageSet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Image* img = (Image*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+    const char* v = lua_tostring(L, 3);
+
+    lua_pushstring(L, "path");          //4
+    lua_pushstring(L, "residency");     //5
+
+    if (lua_compare(L, 2, 4, LUA_OPEQ)) {
+        luaL_checkArgType(L, string, 3);
+        if (!reloadImage(checkImage(L, 1), v))
+            return luaL_error(L, "Can't load image %s : %s", v, SDL_GetError());
+    }
+    else if (lua_compare(L, 2, 5, LUA_OPEQ)) {
+        Image* img = checkImage(L, 1);
+        if (!setImageResidency(img, luaL_checkoption(L, 3, NULL, imageResidencies)))
+            return luaL_error(L, "Can't decode image %s : %s", img->path, SDL_GetError());
+    }
+
+    return 0;
+}
+static int ImageGet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Image* img = (Image*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+
+    lua_pushstring(L, "path");      //3
+    lua_pushstring(L, "width");     //4
+    lua_pushstring(L, "height");    //5
+    lua_pushstring(L, "residency"); //6
+
+    lua_pushnil(L);
+
+    if (lua_compare(L, 2, 3, LUA_OPEQ))
+        lua_pushstring(L, img->path);
+    else if (lua_compare(L, 2, 4, LUA_OPEQ))
+        lua_pushnumber(L, img->w);
+    else if (lua_compare(L, 2, 5, LUA_OPEQ))
+        lua_pushnumber(L, img->h);
+    else if (lua_compare(L, 2, 6, LUA_OPEQ))
+        lua_pushstring(L, imageResidencies[img->residency]);
+    // methods
+    else if (k != NULL)
+        luaL_getmetafield(L, 1, k);
+
+    return 1;
+}
+static int Image_GetPixel(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, image, 1);
+    luaL_checkArgType(L, number, 2);
+    luaL_checkArgType(L, number, 3);
+
+    Image* img = checkImage(L, 1);
+    int x = (int)lua_tonumber(L, 2);
+    int y = (int)lua_tonumber(L, 3);
+    if (x < 0 || y < 0 || x >= img->w || y >= img->h) return 0;
+
+    // gpu resident images are decoded again, and keep their pixels from then on
+    SDL_Surface* surf = imageSurface(img);
+    if (surf == NULL)
+        return luaL_error(L, "Can't decode image %s : %s", img->path, SDL_GetError());
+    const Uint8* p = (const Uint8*)surf->pixels + y * surf->pitch + x * surf->format->BytesPerPixel;
+    Uint32 pixel = 0;
+    switch (surf->format->BytesPerPixel)
+    {
+    case 1: pixel = *p; break;
+    case 2: pixel = *(const Uint16*)p; break;
+    case 3: pixel = SDL_BYTEORDER == SDL_BIG_ENDIAN ? (p[0] << 16 | p[1] << 8 | p[2]) : (p[0] | p[1] << 8 | p[2] << 16); break;
+    case 4: pixel = *(const Uint32*)p; break;
+    }
+
+    Color* col = (Color*)lua_newuserdata(L, sizeof(Color));
+    SDL_GetRGBA(pixel, surf->format, &col->r, &col->g, &col->b, &col->a);
+
+    luaL_getmetatable(L, COLOR_TYPE_NAME);
+    lua_setmetatable(L, -2);
+
+    return 1;
+}
+static int ImageToString(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    Image* img = (Image*)lua_touserdata(L, 1);
+
+    lua_pushfstring(L, IMAGE_TYPE_NAME " %s", img->path ? img->path : "(released)");
+
+    return 1;
+}
+static int Image_Release(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, image, 1);
+    Image* img = (Image*)lua_touserdata(L, 1);
+
+    releaseImage(img);
+
+    return 0;
+}
+static int ImageGC(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Image* img = (Image*)lua_touserdata(L, 1);
+
+    // nothing left to free if the script released it already
+    releaseImage(img);
+
+    return 0;
+}
+
+static void releaseImage(Image* img)
+{
+    if (img->path == NULL) return;
+
+    destroyImageTexture(img->tex);
+    img->tex = NULL;
+    freeImageSurface(img->surf);
+    img->surf = NULL;
+    SDL_free(img->path);
+    img->path = NULL;
+    img->w = img->h = 0;
+
+    images.erase(std::remove(images.begin(), images.end(), img), images.end());
+}
+static Image* checkImage(lua_State* L, int arg)
+{
+    Image* img = (Image*)lua_touserdata(L, arg);
+    luaL_argcheck(L, img->path != NULL, arg, "image was released");
+    return img;
+}
+
+typedef struct TextureTask
+{
+    Uint32 format;
+    int w, h;
+    const void* pixels;
+    int pitch;
+    SDL_Texture* tex;
+} TextureTask;
+
+static void queryImageFormat(void* data)
+{
+    // prefer the first texture format of the renderer that keeps the alpha channel
+    Uint32* format = (Uint32*)data;
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0)
+    {
+        for (Uint32 i = 0; i < info.num_texture_formats; i++)
+        {
+            if (SDL_ISPIXELFORMAT_ALPHA(info.texture_formats[i]))
+            {
+                *format = info.texture_formats[i];
+                return;
+            }
+        }
+    }
+}
+static Uint32 imageFormat()
+{
+    // the renderer keeps its formats, it is only asked once
+    static Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+    if (renderer == NULL) return SDL_PIXELFORMAT_ARGB8888;
+    if (format == SDL_PIXELFORMAT_UNKNOWN)
+    {
+        Uint32 found = SDL_PIXELFORMAT_ARGB8888;
+        Pipeline_Invoke(queryImageFormat, &found);
+        format = found;
+    }
+    return format;
+}
+static void uploadTexture(void* data)
+{
+    TextureTask* task = (TextureTask*)data;
+    task->tex = SDL_CreateTexture(renderer, task->format, SDL_TEXTUREACCESS_STATIC, task->w, task->h);
+    if (task->tex == NULL) return;
+
+    if (SDL_UpdateTexture(task->tex, NULL, task->pixels, task->pitch) != 0)
+    {
+        SDL_DestroyTexture(task->tex);
+        task->tex = NULL;
+        return;
+    }
+    SDL_SetTextureBlendMode(task->tex, SDL_ISPIXELFORMAT_ALPHA(task->format) ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+}
+static void destroyTexture(void* data)
+{
+    SDL_DestroyTexture((SDL_Texture*)data);
+}
+static SDL_Texture* createImageTexture(Uint32 format, int w, int h, const void* pixels, int pitch)
+{
+    // textures belong to the thread that owns the renderer
+    TextureTask task = { format, w, h, pixels, pitch, NULL };
+    Pipeline_Invoke(uploadTexture, &task);
+    if (task.tex == NULL) return NULL;
+
+    Mem_Track(MEM_TEXTURE, Mem_TextureBytes(task.tex), 1);
+    return task.tex;
+}
+static void destroyImageTexture(SDL_Texture* tex)
+{
+    if (tex == NULL) return;
+    Mem_Track(MEM_TEXTURE, -Mem_TextureBytes(tex), -1);
+    // the frame being recorded may still draw it
+    Pipeline_Forget(tex);
+    Pipeline_Invoke(destroyTexture, tex);
+}
+static void freeImageSurface(SDL_Surface* surf)
+{
+    if (surf == NULL) return;
+    Mem_Track(MEM_SURFACE, -Mem_SurfaceBytes(surf), -1);
+    SDL_FreeSurface(surf);
+}
+static SDL_Texture* imageTexture(Image* img)
+{
+    if (img->tex == NULL && renderer != NULL)
+    {
+        // the source may be gone since the surface was freed, then the image draws nothing
+        SDL_Surface* surf = imageSurface(img);
+        if (surf == NULL) return NULL;
+        img->tex = createImageTexture(surf->format->format, surf->w, surf->h, surf->pixels, surf->pitch);
+
+        // drawing only needs the texture
+        if (img->tex != NULL && img->residency == IMAGE_RESIDENCY_GPU)
+        {
+            freeImageSurface(img->surf);
+            img->surf = NULL;
+        }
+    }
+    return img->tex;
+}
+static SDL_Surface* imageSurface(Image* img)
+{
+    if (img->surf == NULL)
+        loadImage(img->path, imageFormat(), true, &img->surf, NULL, &img->w, &img->h);
+    return img->surf;
+}
+static bool setImageResidency(Image* img, int residency)
+{
+    // the image stays on the gpu if its pixels can't be decoded again
+    if (residency == IMAGE_RESIDENCY_CPU && imageSurface(img) == NULL)
+        return false;
+
+    img->residency = residency;
+    if (residency == IMAGE_RESIDENCY_GPU && img->tex != NULL)
+    {
+        freeImageSurface(img->surf);
+        img->surf = NULL;
+    }
+    return true;
+}
+void ResetImageTextures()
+{
+    // the textures are lost with the device, they are uploaded again on next draw
+    for (Image* img : images)
+    {
+        destroyImageTexture(img->tex);
+        img->tex = NULL;
+    }
+}
+
+static bool loadImage(const char* fn, Uint32 format, bool needSurface, SDL_Surface** surf, SDL_Texture** tex, int* w, int* h)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    *surf = NULL;
+    if (tex != NULL) *tex = NULL;
+
+    TexCacheEntry cached;
+    bool hit = TexCache_Open(fn, format, &cached);
+    if (hit)
+    {
+        // already decoded and converted, upload straight from the mapped cache
+        *w = cached.w;
+        *h = cached.h;
+        if (tex != NULL && renderer != NULL)
+            *tex = createImageTexture(format, cached.w, cached.h, cached.pixels, cached.pitch);
+        if (needSurface || tex == NULL || *tex == NULL)
+        {
+            *surf = SDL_CreateRGBSurfaceWithFormat(0, cached.w, cached.h, SDL_BITSPERPIXEL(format), format);
+            if (*surf != NULL)
+            {
+                int rowSize = SDL_min((*surf)->pitch, cached.pitch);
+                for (int y = 0; y < cached.h; y++)
+                    memcpy((Uint8*)(*surf)->pixels + y * (*surf)->pitch, (const Uint8*)cached.pixels + y * cached.pitch, rowSize);
+            }
+        }
+        TexCache_Close(&cached);
+    }
+    else
+    {
+        const char* ext = SDL_strrchr(fn, '.');
+        if (!Subsystem_InitImage(fn))
+            std::cout << "Can't initialize SDL_image :\n" << SDL_GetError() << std::endl;
+        SDL_Surface* loaded = IMG_LoadTyped_RW(OpenAsset(fn), 1, ext ? ext + 1 : NULL);
+        if (loaded != NULL)
+        {
+            *surf = SDL_ConvertSurfaceFormat(loaded, format, 0);
+            SDL_FreeSurface(loaded);
+        }
+        if (*surf != NULL)
+        {
+            TexCache_Store(fn, *surf);
+            *w = (*surf)->w;
+            *h = (*surf)->h;
+        }
+    }
+    if (*surf != NULL)
+        Mem_Track(MEM_SURFACE, Mem_SurfaceBytes(*surf), 1);
+
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    if (hit)
+    {
+        imageCacheStats.hits++;
+        imageCacheStats.hitTime += ms;
+    }
+    else
+    {
+        imageCacheStats.misses++;
+        imageCacheStats.missTime += ms;
+    }
+
+    return *surf != NULL || (tex != NULL && *tex != NULL);
+}
+static bool reloadImage(Image* img, const char* fn)
+{
+    // gpu resident images only keep their pixels until there is a renderer to upload them to
+    bool needSurface = img->residency == IMAGE_RESIDENCY_CPU || renderer == NULL;
+
+    SDL_Surface* surf;
+    SDL_Texture* tex;
+    int w, h;
+    if (!loadImage(fn, imageFormat(), needSurface, &surf, &tex, &w, &h))
+        return false;
+
+    destroyImageTexture(img->tex);
+    freeImageSurface(img->surf);
+    img->surf = surf;
+    img->tex = tex;
+    img->w = w;
+    img->h = h;
+    // fn may be the current path, or a lua string that won't outlive the image
+    char* path = SDL_strdup(fn);
+    SDL_free(img->path);
+    img->path = path;
+    Watcher_Add(img->path);
+
+    if (img->tex == NULL && renderer != NULL)
+        imageTexture(img);
+    return true;
+}
+
+static int Color_new(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    Color* col = (Color*)lua_newuserdata(L, sizeof(Color));
+    if (col == NULL)
+    {
+        std::cout << "Can't create color :\n" << std::endl;
+        QuitAll();
+        exit(1);
+    }
+    col->r = (argc > 0) ? (Uint8)lua_tonumber(L, 1) : 0;
+    col->g = (argc > 1) ? (Uint8)lua_tonumber(L, 2) : 0;
+    col->b = (argc > 2) ? (Uint8)lua_tonumber(L, 3) : 0;
+    col->a = (argc > 3) ? (Uint8)lua_tonumber(L, 4) : 255;
+
+    luaL_getmetatable(L, COLOR_TYPE_NAME);
+    lua_setmetatable(L, -2);
+
+    return 1;
+}
+static int ColorSet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Color* col = (Color*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+    int v = (int)lua_tonumber(L, 3);
+
+    lua_pushstring(L, "r");
+    lua_pushstring(L, "g");
+    lua_pushstring(L, "b");
+    lua_pushstring(L, "a");
+
+    if (lua_compare(L, 2, 4, LUA_OPEQ))
+        col->r = (Uint8)v;
+    else if (lua_compare(L, 2, 5, LUA_OPEQ))
+        col->g = (Uint8)v;
+    else if (lua_compare(L, 2, 6, LUA_OPEQ))
+        col->b = (Uint8)v;
+    else if (lua_compare(L, 2, 7, LUA_OPEQ))
+        col->a = (Uint8)v;
+
+    return 0;
+}
+static int ColorGet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Color* col = (Color*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+
+    lua_pushstring(L, "r");
+    lua_pushstring(L, "g");
+    lua_pushstring(L, "b");
+    lua_pushstring(L, "a");
+
+    lua_pushnil(L);
+
+    if (lua_compare(L, 2, 3, LUA_OPEQ))
+        lua_pushnumber(L, (double)col->r);
+    else if (lua_compare(L, 2, 4, LUA_OPEQ))
+        lua_pushnumber(L, (double)col->g);
+    else if (lua_compare(L, 2, 5, LUA_OPEQ))
+        lua_pushnumber(L, (double)col->b);
+    else if (lua_compare(L, 2, 6, LUA_OPEQ))
+        lua_pushnumber(L, (double)col->a);
+
+    return 1;
+}
+static int ColorMul(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Color* col = (Color*)lua_touserdata(L, 1);
+    double n = lua_tonumber(L, 2);
+
+    Color* finalcol = (Color*)lua_newuserdata(L, sizeof(Color));
+    if (col == NULL)
+    {
+        std::cout << "Can't create color :\n" << std::endl;
+        QuitAll();
+        exit(1);
+    }
+    finalcol->r = (Uint8)((double)col->r * n / 255.0);
+    finalcol->g = (Uint8)((double)col->g * n / 255.0);
+    finalcol->b = (Uint8)((double)col->b * n / 255.0);
+    finalcol->a = (Uint8)((double)col->a * n / 255.0);
+    luaL_setmetatable(L, COLOR_TYPE_NAME);
+
+    return 1;
+}
+static int ColorDiv(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Color* col = (Color*)lua_touserdata(L, 1);
+    double n = lua_tonumber(L, 2);
+
+    Color* finalcol = (Color*)lua_newuserdata(L, sizeof(Color));
+    if (col == NULL)
+    {
+        std::cout << "Can't create color :\n" << std::endl;
+        QuitAll();
+        exit(1);
+    }
+    finalcol->r = (Uint8)(((double)col->r / 255.0) / n);
+    finalcol->g = (Uint8)(((double)col->g / 255.0) / n);
+    finalcol->b = (Uint8)(((double)col->b / 255.0) / n);
+    finalcol->a = (Uint8)(((double)col->a / 255.0) / n);
+    luaL_setmetatable(L, COLOR_TYPE_NAME);
+
+    return 1;
+}
+static int ColorToString(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    Color* col = (Color*)lua_touserdata(L, 1);
+
+    lua_pushfstring(L, COLOR_TYPE_NAME " %d, %d, %d, %d", col->r, col->g, col->b, col->a);
+
+    return 1;
+}
+
+static int Sound_new(lua_State* L)
+{
+    if (!ensureAudio()) return 0;
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, string, 1);
+    const char* fn = lua_tostring(L, 1);
+
+    Sound* snd = (Sound*)lua_newuserdata(L, sizeof(Sound));
+    if (snd == NULL)
+    {
+        std::cout << "Can't create sound :\n" << std::endl;
+        QuitAll();
+        exit(1);
+    }
+    snd->snd = NULL;
+    snd->path = NULL;
+    snd->priority = 0;
+    snd->volume = 1.0f;
+    snd->pan = 0.0f;
+    snd->positional = false;
+    snd->x = snd->y = 0.0f;
+    snd->sentVolume = snd->sentPan = -2.0f;
+    snd->effects = NULL;
+    snd->effectCount = 0;
+    snd->group = 0;
+    if (!reloadSound(snd, fn))
+    {
+        std::cout << "Can't create sound :\n" << SDL_GetError() << std::endl;
+        QuitAll();
+        exit(1);
+    }
+
+    luaL_getmetatable(L, SOUND_TYPE_NAME);
+    lua_setmetatable(L, -2);
+    sounds.push_back(snd);
+
+    return 1;
+}
+static int SoundSet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Sound* snd = (Sound*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+    const char* v = lua_tostring(L, 3);
+
+    lua_pushstring(L, "path");      //4
+    lua_pushstring(L, "priority");  //5
+    lua_pushstring(L, "volume");    //6
+    lua_pushstring(L, "pan");       //7
+    lua_pushstring(L, "positional");//8
+    lua_pushstring(L, "x");         //9
+    lua_pushstring(L, "y");         //10
+    lua_pushstring(L, "group");     //11
+
+    if (lua_compare(L, 2, 4, LUA_OPEQ)) {
+        luaL_checkArgType(L, string, 3);
+        if (!reloadSound(checkSound(L, 1), v))
+            return luaL_error(L, "Can't load sound %s : %s", v, SDL_GetError());
+    }
+    // voices already playing stay in their group
+    else if (lua_compare(L, 2, 11, LUA_OPEQ))
+        checkSound(L, 1)->group = setGroup(L, 1, 3);
+    else if (lua_compare(L, 2, 5, LUA_OPEQ)) {
+        luaL_checkArgType(L, integer, 3);
+        snd->priority = (int)lua_tointeger(L, 3);
+    }
+    else if (lua_compare(L, 2, 6, LUA_OPEQ) || lua_compare(L, 2, 7, LUA_OPEQ)) {
+        luaL_checkArgType(L, number, 3);
+        if (lua_compare(L, 2, 6, LUA_OPEQ))
+            snd->volume = SDL_clamp((float)lua_tonumber(L, 3), 0.0f, 1.0f);
+        else
+            snd->pan = SDL_clamp((float)lua_tonumber(L, 3), -1.0f, 1.0f);
+        // voices already playing follow
+        float volume, pan;
+        soundGains(snd, &volume, &pan);
+        setSoundGains(snd, volume, pan);
+    }
+    else if (lua_compare(L, 2, 8, LUA_OPEQ)) {
+        luaL_checkArgType(L, boolean, 3);
+        snd->positional = lua_toboolean(L, 3);
+    }
+    // positional voices follow on next frame
+    else if (lua_compare(L, 2, 9, LUA_OPEQ)) {
+        luaL_checkArgType(L, number, 3);
+        snd->x = (float)lua_tonumber(L, 3);
+    }
+    else if (lua_compare(L, 2, 10, LUA_OPEQ)) {
+        luaL_checkArgType(L, number, 3);
+        snd->y = (float)lua_tonumber(L, 3);
+    }
+
+    return 0;
+}
+static int SoundGet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Sound* snd = (Sound*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+
+    lua_pushstring(L, "path");      //3
+    lua_pushstring(L, "priority");  //4
+    lua_pushstring(L, "volume");    //5
+    lua_pushstring(L, "pan");       //6
+    lua_pushstring(L, "positional");//7
+    lua_pushstring(L, "x");         //8
+    lua_pushstring(L, "y");         //9
+    lua_pushstring(L, "group");     //10
+
+    lua_pushnil(L);
+
+    if (lua_compare(L, 2, 3, LUA_OPEQ))
+        lua_pushstring(L, snd->path);
+    else if (lua_compare(L, 2, 4, LUA_OPEQ))
+        lua_pushinteger(L, snd->priority);
+    else if (lua_compare(L, 2, 5, LUA_OPEQ))
+        lua_pushnumber(L, snd->volume);
+    else if (lua_compare(L, 2, 6, LUA_OPEQ))
+        lua_pushnumber(L, snd->pan);
+    else if (lua_compare(L, 2, 7, LUA_OPEQ))
+        lua_pushboolean(L, snd->positional);
+    else if (lua_compare(L, 2, 8, LUA_OPEQ))
+        lua_pushnumber(L, snd->x);
+    else if (lua_compare(L, 2, 9, LUA_OPEQ))
+        lua_pushnumber(L, snd->y);
+    else if (lua_compare(L, 2, 10, LUA_OPEQ))
+    {
+        if (snd->group != 0) lua_getiuservalue(L, 1, 1);
+        else lua_pushnil(L);
+    }
+    // methods
+    else if (k != NULL)
+        luaL_getmetafield(L, 1, k);
+
+    return 1;
+}
+static int Sound_PlaySound(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, sound, 1);
+    Sound* snd = checkSound(L, 1);
+
+    // dropped when its file couldn't be loaded for a new device
+    if (snd->snd == NULL)
+    {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+    float volume, pan;
+    soundGains(snd, &volume, &pan);
+
+    // every play takes its own voice, so a sound can overlap itself
+    // the native mixer has no effects, those sounds keep to SDL_mixer channels
+    bool played = (Mixer_IsRunning() && snd->effectCount == 0)
+        ? Mixer_Play(snd->snd->abuf, snd->snd->alen, snd, snd->group, snd->priority, 0, volume, pan)
+        : Voice_Play(snd->snd, snd, snd->group, snd->priority, 0, volume, pan, snd->effects, snd->effectCount) >= 0;
+    lua_pushboolean(L, played);
+
+    return 1;
+}
+static int Sound_PauseSound(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, sound, 1);
+    Sound* snd = checkSound(L, 1);
+
+    Voice_Pause(snd);
+    Mixer_Pause(snd);
+
+    return 0;
+}
+static int Sound_ResumeSound(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, sound, 1);
+    Sound* snd = checkSound(L, 1);
+
+    Voice_Resume(snd);
+    Mixer_Resume(snd);
+
+    return 0;
+}
+static int Sound_StopSound(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, sound, 1);
+    Sound* snd = checkSound(L, 1);
+
+    Voice_Halt(snd);
+    Mixer_Halt(snd);
+
+    return 0;
+}
+static int Sound_IsSoundPlaying(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, sound, 1);
+    Sound* snd = checkSound(L, 1);
+
+    lua_pushboolean(L, Voice_IsPlaying(snd) || Mixer_IsPlaying(snd));
+
+    return 1;
+}
+static int Sound_IsSoundPaused(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, sound, 1);
+    Sound* snd = checkSound(L, 1);
+
+    lua_pushboolean(L, Voice_IsPaused(snd) || Mixer_IsPaused(snd));
+
+    return 1;
+}
+static int Sound_SetEffects(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, sound, 1);
+    Sound* snd = checkSound(L, 1);
+
+    DspParams effects[DSP_MAX_CHAIN];
+    int count = readEffects(L, 2, effects);
+
+    // the voices playing keep their filters, the tail of the old delay and reverb is cut
+    Voice_ReleaseSend(snd);
+    SDL_free(snd->effects);
+    snd->effects = NULL;
+    snd->effectCount = 0;
+    if (count > 0)
+    {
+        snd->effects = (DspParams*)SDL_malloc(count * sizeof(DspParams));
+        if (snd->effects == NULL) return luaL_error(L, "Can't set sound effects : out of memory");
+        SDL_memcpy(snd->effects, effects, count * sizeof(DspParams));
+        snd->effectCount = count;
+    }
+
+    return 0;
+}
+static int SoundToString(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    Sound* snd = (Sound*)lua_touserdata(L, 1);
+
+    lua_pushfstring(L, SOUND_TYPE_NAME " %s", snd->path ? snd->path : "(released)");
+
+    return 1;
+}
+static int Sound_Release(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, sound, 1);
+    Sound* snd = (Sound*)lua_touserdata(L, 1);
+
+    releaseSound(snd);
+
+    return 0;
+}
+static int SoundGC(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Sound* snd = (Sound*)lua_touserdata(L, 1);
+
+    // nothing left to free if the script released it already
+    releaseSound(snd);
+
+    return 0;
+}
+
+static void freeChunk(void* chunk)
+{
+    Mem_Track(MEM_CHUNK, -(Sint64)((Mix_Chunk*)chunk)->alen, -1);
+    Mix_FreeChunk((Mix_Chunk*)chunk);
+}
+static void releaseSound(Sound* snd)
+{
+    if (snd->path == NULL) return;
+
+    // the voices may outlive the sound, they must not point to it anymore
+    Voice_Release(snd);
+    if (snd->snd != NULL)
+        Mixer_Release(snd, freeChunk, snd->snd);
+    snd->snd = NULL;
+    SDL_free(snd->effects);
+    snd->effects = NULL;
+    snd->effectCount = 0;
+    SDL_free(snd->path);
+    snd->path = NULL;
+
+    sounds.erase(std::remove(sounds.begin(), sounds.end(), snd), sounds.end());
+}
+static Sound* checkSound(lua_State* L, int arg)
+{
+    Sound* snd = (Sound*)lua_touserdata(L, arg);
+    luaL_argcheck(L, snd->path != NULL, arg, "sound was released");
+    return snd;
+}
+static int readEffects(lua_State* L, int arg, DspParams* params)
+{
+    if (lua_isnoneornil(L, arg)) return 0;
+    luaL_checktype(L, arg, LUA_TTABLE);
+
+    int count = (int)luaL_len(L, arg);
+    luaL_argcheck(L, count <= DSP_MAX_CHAIN, arg, "too many effects");
+    for (int i = 0; i < count; i++)
+    {
+        lua_geti(L, arg, i + 1);
+        luaL_argcheck(L, lua_istable(L, -1), arg, "effects must be tables");
+        lua_getfield(L, -1, "type");
+        DspParams* p = &params[i];
+        Dsp_Defaults((DspType)luaL_checkoption(L, -1, NULL, dspTypes), p);
+        lua_getfield(L, -2, "cutoff");
+        p->cutoff = (float)luaL_optnumber(L, -1, p->cutoff);
+        lua_getfield(L, -3, "q");
+        p->q = (float)luaL_optnumber(L, -1, p->q);
+        lua_getfield(L, -4, "time");
+        p->time = (float)luaL_optnumber(L, -1, p->time);
+        lua_getfield(L, -5, "feedback");
+        p->feedback = (float)luaL_optnumber(L, -1, p->feedback);
+        lua_getfield(L, -6, "room");
+        p->room = (float)luaL_optnumber(L, -1, p->room);
+        lua_getfield(L, -7, "damping");
+        p->damping = (float)luaL_optnumber(L, -1, p->damping);
+        lua_getfield(L, -8, "mix");
+        p->mix = (float)luaL_optnumber(L, -1, p->mix);
+        lua_pop(L, 9);
+    }
+    return count;
+}
+
+static void soundGains(const Sound* snd, float* volume, float* pan)
+{
+    *volume = snd->volume;
+    *pan = snd->pan;
+    if (!snd->positional) return;
+
+    float attenuation, spatialPan;
+    Spatial_Compute(&snd->x, &snd->y, 1, &attenuation, &spatialPan);
+    *volume *= attenuation;
+    *pan = SDL_clamp(snd->pan + spatialPan, -1.0f, 1.0f);
+}
+static void setSoundGains(Sound* snd, float volume, float pan)
+{
+    // a sound standing still costs nothing, and the native mixer's queue doesn't fill up
+    // voices played since start with these gains already
+    if (volume == snd->sentVolume && pan == snd->sentPan) return;
+    snd->sentVolume = volume;
+    snd->sentPan = pan;
+    // sounds with effects play on SDL_mixer channels even with the native mixer
+    Voice_SetVolume(snd, volume, pan);
+    Mixer_SetVolume(snd, volume, pan);
+}
+void SpatialFrame()
+{
+    // kept between frames so the pass doesn't allocate
+    static std::vector<Sound*> emitters;
+    static std::vector<float> xs, ys, attenuations, pans;
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    emitters.clear();
+    xs.clear();
+    ys.clear();
+    for (Sound* snd : sounds)
+    {
+        if (!snd->positional) continue;
+        emitters.push_back(snd);
+        xs.push_back(snd->x);
+        ys.push_back(snd->y);
+    }
+    if (emitters.empty())
+    {
+        Spatial_Record(0, 0, 0.0);
+        return;
+    }
+
+    attenuations.resize(emitters.size());
+    pans.resize(emitters.size());
+    int culled = Spatial_Compute(xs.data(), ys.data(), (int)emitters.size(), attenuations.data(), pans.data());
+
+    // culled voices get a volume of 0, which both mixers skip
+    for (size_t i = 0; i < emitters.size(); i++)
+    {
+        Sound* snd = emitters[i];
+        float volume = snd->volume * attenuations[i];
+        float pan = SDL_clamp(snd->pan + pans[i], -1.0f, 1.0f);
+        setSoundGains(snd, volume, pan);
+    }
+
+    double us = (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    Spatial_Record((int)emitters.size(), culled, us);
+}
+
+static bool reloadSound(Sound* snd, const char* fn)
+{
+    if (!Subsystem_InitMixer(fn))
+        std::cout << "Can't initialize SDL_mixer :\n" << SDL_GetError() << std::endl;
+    Mix_Chunk* chunk = Mix_LoadWAV_RW(OpenAsset(fn), 1);
+    if (chunk == NULL)
+        return false;
+    Mem_Track(MEM_CHUNK, chunk->alen, 1);
+    // halts the channels still playing the previous chunk
+    if (snd->snd != NULL)
+        Mixer_Release(snd, freeChunk, snd->snd);
+    snd->snd = chunk;
+
+    char* path = SDL_strdup(fn);
+    SDL_free(snd->path);
+    snd->path = path;
+    Watcher_Add(snd->path);
+    return true;
+}
+
+static int Music_new(lua_State* L)
+{
+    if (!ensureAudio()) return 0;
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, string, 1);
+    const char* fn = lua_tostring(L, 1);
+
+    Music* mus = (Music*)lua_newuserdata(L, sizeof(Music));
+    if (mus == NULL)
+    {
+        std::cout << "Can't create music :\n" << std::endl;
+        QuitAll();
+        exit(1);
+    }
+    mus->mus = NULL;
+    mus->path = NULL;
+    mus->size = 0;
+    mus->group = 0;
+    if (!reloadMusic(mus, fn))
+    {
+        std::cout << "Can't create music :\n" << SDL_GetError() << std::endl;
+        QuitAll();
+        exit(1);
+    }
+    musics.push_back(mus);
+
+    luaL_getmetatable(L, MUSIC_TYPE_NAME);
+    lua_setmetatable(L, -2);
+
+    return 1;
+}
+static int MusicSet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    const char* v = lua_tostring(L, 3);
+
+    lua_pushstring(L, "path");  //4
+    lua_pushstring(L, "group"); //5
+
+    if (lua_compare(L, 2, 4, LUA_OPEQ)) {
+        luaL_checkArgType(L, string, 3);
+        if (!reloadMusic(checkMusic(L, 1), v))
+            return luaL_error(L, "Can't load music %s : %s", v, SDL_GetError());
+    }
+    else if (lua_compare(L, 2, 5, LUA_OPEQ)) {
+        Music* mus = checkMusic(L, 1);
+        int previous = mus->group;
+        mus->group = setGroup(L, 1, 3);
+        if (currentMusic == mus)
+        {
+            applyGroup(previous);
+            applyGroup(mus->group);
+        }
+    }
+
+    return 0;
+}
+static int MusicGet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Music* mus = (Music*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+
+    lua_pushstring(L, "path");  //3
+    lua_pushstring(L, "size");  //4
+    lua_pushstring(L, "group"); //5
+
+    lua_pushnil(L);
+
+    if (lua_compare(L, 2, 3, LUA_OPEQ))
+        lua_pushstring(L, mus->path);
+    else if (lua_compare(L, 2, 4, LUA_OPEQ))
+        lua_pushinteger(L, (lua_Integer)mus->size);
+    else if (lua_compare(L, 2, 5, LUA_OPEQ))
+    {
+        if (mus->group != 0) lua_getiuservalue(L, 1, 1);
+        else lua_pushnil(L);
+    }
+    // methods
+    else if (k != NULL)
+        luaL_getmetafield(L, 1, k);
+
+    return 1;
+}
+static int Music_Play(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    Music* mus = checkMusic(L, 1);
+    int loops = (int)luaL_optinteger(L, 2, 1);
+
+    if (Mix_PlayMusic(mus->mus, loops) == 0)
+    {
+        currentMusic = mus;
+        musicPaused = false;
+        applyGroup(mus->group);
+    }
+
+    return 0;
+}
+static int Music_Pause(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    Music* mus = checkMusic(L, 1);
+
+    if (currentMusic == mus)
+    {
+        musicPaused = true;
+        Mix_PauseMusic();
+    }
+
+    return 0;
+}
+static int Music_Resume(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    Music* mus = checkMusic(L, 1);
+
+    if (currentMusic == mus)
+    {
+        musicPaused = false;
+        if (!Group_IsPaused(mus->group)) Mix_ResumeMusic();
+    }
+
+    return 0;
+}
+static int Music_Stop(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    Music* mus = checkMusic(L, 1);
+
+    if (currentMusic == mus)
+        Mix_HaltMusic();
+
+    return 0;
+}
+static int Music_Seek(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    luaL_checkArgType(L, number, 2);
+    Music* mus = checkMusic(L, 1);
+
+    if (currentMusic == mus && Mix_PlayingMusic())
+        Mix_SetMusicPosition(lua_tonumber(L, 2));
+
+    return 0;
+}
+static int Music_FadeIn(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    luaL_checkArgType(L, integer, 2);
+    Music* mus = checkMusic(L, 1);
+    int loops = (int)luaL_optinteger(L, 3, 1);
+
+    if (Mix_FadeInMusic(mus->mus, loops, (int)lua_tointeger(L, 2)) == 0)
+    {
+        currentMusic = mus;
+        musicPaused = false;
+        applyGroup(mus->group);
+    }
+
+    return 0;
+}
+static int Music_FadeOut(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    luaL_checkArgType(L, integer, 2);
+    Music* mus = checkMusic(L, 1);
+
+    if (currentMusic == mus)
+        Mix_FadeOutMusic((int)lua_tointeger(L, 2));
+
+    return 0;
+}
+static int Music_IsPlaying(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    Music* mus = checkMusic(L, 1);
+
+    lua_pushboolean(L, currentMusic == mus && Mix_PlayingMusic());
+
+    return 1;
+}
+static int Music_IsPaused(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    Music* mus = checkMusic(L, 1);
+
+    lua_pushboolean(L, currentMusic == mus && Mix_PlayingMusic() && Mix_PausedMusic());
+
+    return 1;
+}
+static int Music_GetPosition(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    Music* mus = checkMusic(L, 1);
+
+    lua_pushnumber(L, Mix_GetMusicPosition(mus->mus));
+    lua_pushnumber(L, Mix_MusicDuration(mus->mus));
+
+    return 2;
+}
+static int Music_Release(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, music, 1);
+    Music* mus = (Music*)lua_touserdata(L, 1);
+
+    releaseMusic(mus);
+
+    return 0;
+}
+static int MusicToString(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    Music* mus = (Music*)lua_touserdata(L, 1);
+
+    lua_pushfstring(L, MUSIC_TYPE_NAME " %s", mus->path ? mus->path : "(released)");
+
+    return 1;
+}
+static int MusicGC(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    Music* mus = (Music*)lua_touserdata(L, 1);
+
+    // nothing left to free if the script released it already
+    releaseMusic(mus);
+
+    return 0;
+}
+
+static void releaseMusic(Music* mus)
+{
+    if (mus->path == NULL) return;
+
+    // halts the music if it is the one playing
+    if (mus->mus != NULL)
+    {
+        Mem_Track(MEM_MUSIC, -mus->size, -1);
+        Mix_FreeMusic(mus->mus);
+    }
+    if (currentMusic == mus)
+        currentMusic = NULL;
+    mus->mus = NULL;
+    mus->size = 0;
+    SDL_free(mus->path);
+    mus->path = NULL;
+
+    musics.erase(std::remove(musics.begin(), musics.end(), mus), musics.end());
+}
+static Music* checkMusic(lua_State* L, int arg)
+{
+    Music* mus = (Music*)lua_touserdata(L, arg);
+    luaL_argcheck(L, mus->path != NULL, arg, "music was released");
+    return mus;
+}
+
+static bool reloadMusic(Music* mus, const char* fn)
+{
+    if (!Subsystem_InitMixer(fn))
+        std::cout << "Can't initialize SDL_mixer :\n" << SDL_GetError() << std::endl;
+    SDL_RWops* rw = OpenAsset(fn);
+    Sint64 size = (rw != NULL) ? SDL_RWsize(rw) : 0;
+    // the decoder keeps the RWops and reads from it as the music plays
+    Mix_Music* music = Mix_LoadMUS_RW(rw, 1);
+    if (music == NULL)
+        return false;
+    Mem_Track(MEM_MUSIC, size, 1);
+    // halts the previous music if it was playing
+    if (mus->mus != NULL)
+    {
+        Mem_Track(MEM_MUSIC, -mus->size, -1);
+        Mix_FreeMusic(mus->mus);
+    }
+    if (currentMusic == mus)
+        currentMusic = NULL;
+    mus->mus = music;
+    mus->size = size;
+
+    char* path = SDL_strdup(fn);
+    SDL_free(mus->path);
+    mus->path = path;
+    Watcher_Add(mus->path);
+    return true;
+}
+
+static int AudioStream_new(lua_State* L)
+{
+    if (!ensureAudio()) return 0;
+    int argc = lua_gettop(L);
+    int channels = (int)luaL_optinteger(L, 1, 1);
+    luaL_argcheck(L, channels == 1 || channels == 2, 1, "1 or 2 channels expected");
+    int capacity = (int)luaL_optinteger(L, 2, Audio_GetSpec()->frequency / 4);
+    luaL_argcheck(L, capacity > 0, 2, "positive capacity expected");
+
+    AudioStream* as = (AudioStream*)lua_newuserdata(L, sizeof(AudioStream));
+    as->stream = Stream_Create(channels, capacity);
+    if (as->stream == NULL)
+        return luaL_error(L, "Can't create audio stream : %s", SDL_GetError());
+    audioStreams.push_back(as);
+
+    luaL_getmetatable(L, AUDIOSTREAM_TYPE_NAME);
+    lua_setmetatable(L, -2);
+
+    return 1;
+}
+static int AudioStreamSet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    lua_pushstring(L, "volume");    //4
+
+    if (lua_compare(L, 2, 4, LUA_OPEQ)) {
+        luaL_checkArgType(L, number, 3);
+        checkAudioStream(L, 1)->stream->volume.store(SDL_clamp((float)lua_tonumber(L, 3), 0.0f, 1.0f));
+    }
+
+    return 0;
+}
+static int AudioStreamGet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    AudioStream* as = (AudioStream*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+
+    lua_pushstring(L, "volume");    //3
+    lua_pushstring(L, "channels");  //4
+
+    lua_pushnil(L);
+
+    if (as->stream != NULL && lua_compare(L, 2, 3, LUA_OPEQ))
+        lua_pushnumber(L, as->stream->volume.load());
+    else if (as->stream != NULL && lua_compare(L, 2, 4, LUA_OPEQ))
+        lua_pushinteger(L, as->stream->channels);
+    // methods
+    else if (k != NULL)
+        luaL_getmetafield(L, 1, k);
+
+    return 1;
+}
+static int AudioStream_Write(lua_State* L)
+{
+    // kept between writes so feeding a stream doesn't allocate
+    static std::vector<float> samples;
+
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiostream, 1);
+    AudioStream* as = checkAudioStream(L, 1);
+    int channels = as->stream->channels;
+
+    // float arrays go to the ring as they are
+    TypedArray* arr = (TypedArray*)luaL_testudata(L, 2, FLOAT32ARRAY_TYPE_NAME);
+    if (arr != NULL)
+    {
+        lua_pushinteger(L, Stream_Write(as->stream, (float*)arr->data, arr->length / channels));
+        return 1;
+    }
+
+    luaL_checkArgType(L, table, 2);
+    int frames = (int)SDL_min(lua_rawlen(L, 2) / channels, (size_t)Ring_Space(&as->stream->ring));
+    samples.resize((size_t)frames * channels);
+    for (int i = 0; i < frames * channels; i++)
+    {
+        lua_rawgeti(L, 2, i + 1);
+        samples[i] = (float)lua_tonumber(L, -1);
+        lua_pop(L, 1);
+    }
+
+    lua_pushinteger(L, Stream_Write(as->stream, samples.data(), frames));
+
+    return 1;
+}
+static int AudioStream_Play(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiostream, 1);
+    AudioStream* as = checkAudioStream(L, 1);
+
+    as->stream->playing.store(true);
+
+    return 0;
+}
+static int AudioStream_Pause(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiostream, 1);
+    AudioStream* as = checkAudioStream(L, 1);
+
+    as->stream->playing.store(false);
+
+    return 0;
+}
+static int AudioStream_IsPlaying(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiostream, 1);
+    AudioStream* as = checkAudioStream(L, 1);
+
+    lua_pushboolean(L, as->stream->playing.load());
+
+    return 1;
+}
+static int AudioStream_GetFill(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiostream, 1);
+    AudioStream* as = checkAudioStream(L, 1);
+
+    lua_pushinteger(L, Stream_GetFill(as->stream));
+    lua_pushinteger(L, Stream_GetCapacity(as->stream));
+
+    return 2;
+}
+static int AudioStream_GetUnderruns(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiostream, 1);
+    AudioStream* as = checkAudioStream(L, 1);
+
+    lua_pushinteger(L, (lua_Integer)as->stream->underruns.load());
+    lua_pushinteger(L, (lua_Integer)as->stream->played.load());
+
+    return 2;
+}
+static int AudioStream_Release(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiostream, 1);
+    AudioStream* as = (AudioStream*)lua_touserdata(L, 1);
+
+    releaseAudioStream(as);
+
+    return 0;
+}
+static int AudioStreamToString(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    AudioStream* as = (AudioStream*)lua_touserdata(L, 1);
+
+    if (as->stream == NULL)
+        lua_pushstring(L, AUDIOSTREAM_TYPE_NAME " (released)");
+    else
+        lua_pushfstring(L, AUDIOSTREAM_TYPE_NAME " %d/%d", Stream_GetFill(as->stream), Stream_GetCapacity(as->stream));
+
+    return 1;
+}
+static int AudioStreamGC(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    AudioStream* as = (AudioStream*)lua_touserdata(L, 1);
+
+    // nothing left to free if the script released it already
+    releaseAudioStream(as);
+
+    return 0;
+}
+
+static void releaseAudioStream(AudioStream* as)
+{
+    if (as->stream == NULL) return;
+
+    // waits for the callback to let go of it
+    Stream_Destroy(as->stream);
+    as->stream = NULL;
+
+    audioStreams.erase(std::remove(audioStreams.begin(), audioStreams.end(), as), audioStreams.end());
+}
+bool StreamFrame()
+{
+    // a paused or full stream waits for the script, not for frames
+    for (AudioStream* as : audioStreams)
+        if (as->stream->playing && Stream_GetFill(as->stream) < Stream_GetCapacity(as->stream))
+            return true;
+    return false;
+}
+static AudioStream* checkAudioStream(lua_State* L, int arg)
+{
+    AudioStream* as = (AudioStream*)lua_touserdata(L, arg);
+    luaL_argcheck(L, as->stream != NULL, arg, "audio stream was released");
+    return as;
+}
+
+static int AudioGroup_new(lua_State* L)
+{
+    AudioGroup* ag = (AudioGroup*)lua_newuserdata(L, sizeof(AudioGroup));
+    ag->id = Group_Create();
+    if (ag->id < 0)
+    {
+        ag->id = 0;
+        return luaL_error(L, "Can't create audio group : %s", SDL_GetError());
+    }
+
+    luaL_getmetatable(L, AUDIOGROUP_TYPE_NAME);
+    lua_setmetatable(L, -2);
+
+    return 1;
+}
+static int AudioGroupSet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    lua_pushstring(L, "volume");    //4
+    lua_pushstring(L, "muted");     //5
+    lua_pushstring(L, "paused");    //6
+
+    if (lua_compare(L, 2, 4, LUA_OPEQ)) {
+        luaL_checkArgType(L, number, 3);
+        AudioGroup* ag = checkAudioGroup(L, 1);
+        Group_SetVolume(ag->id, (float)lua_tonumber(L, 3));
+        applyGroup(ag->id);
+    }
+    else if (lua_compare(L, 2, 5, LUA_OPEQ)) {
+        luaL_checkArgType(L, boolean, 3);
+        AudioGroup* ag = checkAudioGroup(L, 1);
+        Group_SetMuted(ag->id, lua_toboolean(L, 3));
+        applyGroup(ag->id);
+    }
+    else if (lua_compare(L, 2, 6, LUA_OPEQ)) {
+        luaL_checkArgType(L, boolean, 3);
+        AudioGroup* ag = checkAudioGroup(L, 1);
+        Group_SetPaused(ag->id, lua_toboolean(L, 3));
+        applyGroup(ag->id);
+    }
+
+    return 0;
+}
+static int AudioGroupGet(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    AudioGroup* ag = (AudioGroup*)lua_touserdata(L, 1);
+    const char* k = lua_tostring(L, 2);
+
+    lua_pushstring(L, "volume");    //3
+    lua_pushstring(L, "muted");     //4
+    lua_pushstring(L, "paused");    //5
+
+    lua_pushnil(L);
+
+    if (ag->id != 0 && lua_compare(L, 2, 3, LUA_OPEQ))
+        lua_pushnumber(L, Group_GetVolume(ag->id));
+    else if (ag->id != 0 && lua_compare(L, 2, 4, LUA_OPEQ))
+        lua_pushboolean(L, Group_IsMuted(ag->id));
+    else if (ag->id != 0 && lua_compare(L, 2, 5, LUA_OPEQ))
+        lua_pushboolean(L, Group_IsPaused(ag->id));
+    // methods
+    else if (k != NULL)
+        luaL_getmetafield(L, 1, k);
+
+    return 1;
+}
+static int AudioGroup_FadeTo(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiogroup, 1);
+    luaL_checkArgType(L, number, 2);
+    luaL_checkArgType(L, integer, 3);
+    AudioGroup* ag = checkAudioGroup(L, 1);
+
+    Group_Fade(ag->id, (float)lua_tonumber(L, 2), (Uint32)SDL_max(lua_tointeger(L, 3), 0));
+
+    return 0;
+}
+static int AudioGroup_IsFading(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiogroup, 1);
+    AudioGroup* ag = checkAudioGroup(L, 1);
+
+    lua_pushboolean(L, Group_IsFading(ag->id));
+
+    return 1;
+}
+static int AudioGroup_Pause(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiogroup, 1);
+    AudioGroup* ag = checkAudioGroup(L, 1);
+
+    Group_SetPaused(ag->id, true);
+    applyGroup(ag->id);
+
+    return 0;
+}
+static int AudioGroup_Resume(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiogroup, 1);
+    AudioGroup* ag = checkAudioGroup(L, 1);
+
+    Group_SetPaused(ag->id, false);
+    applyGroup(ag->id);
+
+    return 0;
+}
+static int AudioGroup_Stop(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiogroup, 1);
+    AudioGroup* ag = checkAudioGroup(L, 1);
+
+    Voice_HaltGroup(ag->id);
+    Mixer_HaltGroup(ag->id);
+    if (currentMusic != NULL && currentMusic->group == ag->id)
+        Mix_HaltMusic();
+
+    return 0;
+}
+static int AudioGroup_Release(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    luaL_checkArgType(L, audiogroup, 1);
+    AudioGroup* ag = (AudioGroup*)lua_touserdata(L, 1);
+
+    releaseAudioGroup(ag);
+
+    return 0;
+}
+static int AudioGroupToString(lua_State* L)
+{
+    int argc = lua_gettop(L);
+
+    AudioGroup* ag = (AudioGroup*)lua_touserdata(L, 1);
+
+    if (ag->id == 0)
+        lua_pushstring(L, AUDIOGROUP_TYPE_NAME " (released)");
+    else
+        lua_pushfstring(L, AUDIOGROUP_TYPE_NAME " %d", ag->id);
+
+    return 1;
+}
+static int AudioGroupGC(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    AudioGroup* ag = (AudioGroup*)lua_touserdata(L, 1);
+
+    // nothing left to free if the script released it already
+    releaseAudioGroup(ag);
+
+    return 0;
+}
+
+static void releaseAudioGroup(AudioGroup* ag)
+{
+    if (ag->id == 0) return;
+
+    for (Sound* snd : sounds)
+        if (snd->group == ag->id) snd->group = 0;
+    for (Music* mus : musics)
+        if (mus->group == ag->id) mus->group = 0;
+
+    // voices still playing go on as if they were in no group, none may follow the
+    // next group given the same id
+    Voice_Ungroup(ag->id);
+    Mixer_Ungroup(ag->id);
+    Group_Destroy(ag->id);
+    applyGroup(0);
+    ag->id = 0;
+}
+static AudioGroup* checkAudioGroup(lua_State* L, int arg)
+{
+    AudioGroup* ag = (AudioGroup*)lua_touserdata(L, arg);
+    luaL_argcheck(L, ag->id != 0, arg, "audio group was released");
+    return ag;
+}
+static int setGroup(lua_State* L, int idx, int arg)
+{
+    int group = 0;
+    if (!lua_isnil(L, arg))
+    {
+        luaL_checkArgType(L, audiogroup, arg);
+        group = checkAudioGroup(L, arg)->id;
+    }
+    lua_pushvalue(L, arg);
+    lua_setiuservalue(L, idx, 1);
+    return group;
 }
+static void applyGroup(int group)
+{
+    // the native mixer reads the groups in its callback
+    if (group != 0) Voice_ApplyGroup(group);
+    if (currentMusic == NULL || currentMusic->group != group) return;
 
-static int Color_new(lua_State* L)
+    Mix_VolumeMusic((int)(Group_GetGain(group) * MIX_MAX_VOLUME));
+    if (musicPaused || Group_IsPaused(group)) Mix_PauseMusic();
+    else Mix_ResumeMusic();
+}
+bool GroupFrame()
 {
-    int argc = lua_gettop(L);
+    Uint32 changed = Group_Update();
+    for (int group = 1; changed != 0 && group < GROUP_MAX; group++)
+        if (changed & ((Uint32)1 << group)) applyGroup(group);
+    return changed != 0;
+}
 
-    Color* col = (Color*)lua_newuserdata(L, sizeof(Color));
-    if (col == NULL)
-    {
-        std::cout << "Can't create color :\n" << std::endl;
-        QuitAll();
-        exit(1);
-    }
-    col->r = (argc > 0) ? (Uint8)lua_tonumber(L, 1) : 0;
-    col->g = (argc > 1) ? (Uint8)lua_tonumber(L, 2) : 0;
-    col->b = (argc > 2) ? (Uint8)lua_tonumber(L, 3) : 0;
-    col->a = (argc > 3) ? (Uint8)lua_tonumber(L, 4) : 255;
+static int Vec2_new(lua_State* L)
+{
+    int argc = lua_gettop(L);
 
-    luaL_getmetatable(L, COLOR_TYPE_NAME);
-    lua_setmetatable(L, -2);
+    double x = (argc > 0 && !lua_isnoneornil(L, 1)) ? luaL_checknumber(L, 1) : 0.0;
+    double y = (argc > 1 && !lua_isnoneornil(L, 2)) ? luaL_checknumber(L, 2) : 0.0;
+    pushVec2(L, x, y);
 
     return 1;
 }
-static int ColorSet(lua_State* L)
+static int Vec2Set(lua_State* L)
 {
     int argc = lua_gettop(L);
-    Color* col = (Color*)lua_touserdata(L, 1);
-    const char* k = lua_tostring(L, 2);
-    int v = (int)lua_tonumber(L, 3);
+    Vec2* v = (Vec2*)lua_touserdata(L, 1);
 
-    lua_pushstring(L, "r");
-    lua_pushstring(L, "g");
-    lua_pushstring(L, "b");
-    lua_pushstring(L, "a");
+    lua_pushstring(L, "x");     //4
+    lua_pushstring(L, "y");     //5
 
     if (lua_compare(L, 2, 4, LUA_OPEQ))
-        col->r = (Uint8)v;
+        v->x = luaL_checknumber(L, 3);
     else if (lua_compare(L, 2, 5, LUA_OPEQ))
-        col->g = (Uint8)v;
-    else if (lua_compare(L, 2, 6, LUA_OPEQ))
-        col->b = (Uint8)v;
-    else if (lua_compare(L, 2, 7, LUA_OPEQ))
-        col->a = (Uint8)v;
+        v->y = luaL_checknumber(L, 3);
 
     return 0;
 }
-static int ColorGet(lua_State* L)
+static int Vec2Get(lua_State* L)
 {
     int argc = lua_gettop(L);
-    Color* col = (Color*)lua_touserdata(L, 1);
+    Vec2* v = (Vec2*)lua_touserdata(L, 1);
     const char* k = lua_tostring(L, 2);
 
-    lua_pushstring(L, "r");
-    lua_pushstring(L, "g");
-    lua_pushstring(L, "b");
-    lua_pushstring(L, "a");
+    lua_pushstring(L, "x");     //3
+    lua_pushstring(L, "y");     //4
 
     lua_pushnil(L);
 
     if (lua_compare(L, 2, 3, LUA_OPEQ))
-        lua_pushnumber(L, (double)col->r);
+        lua_pushnumber(L, v->x);
     else if (lua_compare(L, 2, 4, LUA_OPEQ))
-        lua_pushnumber(L, (double)col->g);
-    else if (lua_compare(L, 2, 5, LUA_OPEQ))
-        lua_pushnumber(L, (double)col->b);
-    else if (lua_compare(L, 2, 6, LUA_OPEQ))
-        lua_pushnumber(L, (double)col->a);
+        lua_pushnumber(L, v->y);
+    // methods
+    else if (k != NULL)
+        luaL_getmetafield(L, 1, k);
 
     return 1;
 }
-static int ColorMul(lua_State* L)
+static int Vec2Add(lua_State* L)
+{
+    Vec2* a = checkVec2(L, 1);
+    Vec2* b = checkVec2(L, 2);
+    pushVec2(L, a->x + b->x, a->y + b->y);
+    return 1;
+}
+static int Vec2Sub(lua_State* L)
+{
+    Vec2* a = checkVec2(L, 1);
+    Vec2* b = checkVec2(L, 2);
+    pushVec2(L, a->x - b->x, a->y - b->y);
+    return 1;
+}
+static int Vec2Mul(lua_State* L)
+{
+    // the number may come first : 2 * v
+    int vec = lua_isnumber(L, 1) ? 2 : 1;
+    Vec2* v = checkVec2(L, vec);
+    double n = luaL_checknumber(L, 3 - vec);
+    pushVec2(L, v->x * n, v->y * n);
+    return 1;
+}
+static int Vec2Div(lua_State* L)
+{
+    Vec2* v = checkVec2(L, 1);
+    double n = luaL_checknumber(L, 2);
+    pushVec2(L, v->x / n, v->y / n);
+    return 1;
+}
+static int Vec2Unm(lua_State* L)
+{
+    Vec2* v = checkVec2(L, 1);
+    pushVec2(L, -v->x, -v->y);
+    return 1;
+}
+static int Vec2Eq(lua_State* L)
+{
+    Vec2* a = (Vec2*)luaL_testudata(L, 1, VEC2_TYPE_NAME);
+    Vec2* b = (Vec2*)luaL_testudata(L, 2, VEC2_TYPE_NAME);
+    lua_pushboolean(L, a != NULL && b != NULL && a->x == b->x && a->y == b->y);
+    return 1;
+}
+static int Vec2ToString(lua_State* L)
+{
+    Vec2* v = (Vec2*)lua_touserdata(L, 1);
+    lua_pushfstring(L, VEC2_TYPE_NAME " (%f, %f)", v->x, v->y);
+    return 1;
+}
+static int Vec2_Length(lua_State* L)
 {
     int argc = lua_gettop(L);
-    Color* col = (Color*)lua_touserdata(L, 1);
-    double n = lua_tonumber(L, 2);
+    luaL_checkArgType(L, vec2, 1);
+    Vec2* v = checkVec2(L, 1);
 
-    Color* finalcol = (Color*)lua_newuserdata(L, sizeof(Color));
-    if (col == NULL)
-    {
-        std::cout << "Can't create color :\n" << std::endl;
-        QuitAll();
-        exit(1);
-    }
-    finalcol->r = (Uint8)((double)col->r * n / 255.0);
-    finalcol->g = (Uint8)((double)col->g * n / 255.0);
-    finalcol->b = (Uint8)((double)col->b * n / 255.0);
-    finalcol->a = (Uint8)((double)col->a * n / 255.0);
-    luaL_setmetatable(L, COLOR_TYPE_NAME);
+    lua_pushnumber(L, sqrt(v->x * v->x + v->y * v->y));
 
     return 1;
 }
-static int ColorDiv(lua_State* L)
+static int Vec2_Normalize(lua_State* L)
 {
     int argc = lua_gettop(L);
-    Color* col = (Color*)lua_touserdata(L, 1);
-    double n = lua_tonumber(L, 2);
+    luaL_checkArgType(L, vec2, 1);
+    Vec2* v = checkVec2(L, 1);
 
-    Color* finalcol = (Color*)lua_newuserdata(L, sizeof(Color));
-    if (col == NULL)
-    {
-        std::cout << "Can't create color :\n" << std::endl;
-        QuitAll();
-        exit(1);
-    }
-    finalcol->r = (Uint8)(((double)col->r / 255.0) / n);
-    finalcol->g = (Uint8)(((double)col->g / 255.0) / n);
-    finalcol->b = (Uint8)(((double)col->b / 255.0) / n);
-    finalcol->a = (Uint8)(((double)col->a / 255.0) / n);
-    luaL_setmetatable(L, COLOR_TYPE_NAME);
+    double len = sqrt(v->x * v->x + v->y * v->y);
+    if (len > 0.0)
+        pushVec2(L, v->x / len, v->y / len);
+    else
+        pushVec2(L, 0.0, 0.0);
 
     return 1;
 }
-static int ColorToString(lua_State* L)
+static int Vec2_Rotate(lua_State* L)
 {
     int argc = lua_gettop(L);
+    luaL_checkArgType(L, vec2, 1);
+    luaL_checkArgType(L, number, 2);
+    Vec2* v = checkVec2(L, 1);
 
-    Color* col = (Color*)lua_touserdata(L, 1);
-
-    lua_pushfstring(L, COLOR_TYPE_NAME " %d, %d, %d, %d", col->r, col->g, col->b, col->a);
+    double angle = lua_tonumber(L, 2);
+    double c = cos(angle), s = sin(angle);
+    pushVec2(L, v->x * c - v->y * s, v->x * s + v->y * c);
 
     return 1;
 }
-
-static int Sound_new(lua_State* L)
+static int Vec2_Dot(lua_State* L)
 {
-    if (!MIXInited) return 0;
     int argc = lua_gettop(L);
-    luaL_checkArgType(L, string, 1);
-    const char* fn = lua_tostring(L, 1);
-
-    Sound* snd = (Sound*)lua_newuserdata(L, sizeof(Sound));
-    if (snd == NULL)
-    {
-        std::cout << "Can't create sound :\n" << std::endl;
-        QuitAll();
-        exit(1);
-    }
-    reloadSound(snd, fn);
-
-    snd->channel = -1;
-
-    for (int i = 0; i < maxChannels; i++)
-    {
-        if (channels[i] == false)
-        {
-            snd->channel = i;
-            channels[i] = true;
-        }
-    }
+    luaL_checkArgType(L, vec2, 1);
+    luaL_checkArgType(L, vec2, 2);
+    Vec2* a = checkVec2(L, 1);
+    Vec2* b = checkVec2(L, 2);
 
-    if (snd->channel == -1)
-    {
-        std::cout << "trying to make a new sound be all channels are taken\ntip:10 playing sounds max" << std::endl;
-        QuitAll();
-        exit(1);
-    }
-
-    luaL_getmetatable(L, SOUND_TYPE_NAME);
-    lua_setmetatable(L, -2);
+    lua_pushnumber(L, a->x * b->x + a->y * b->y);
 
     return 1;
 }
-static int SoundSet(lua_State* L)
+static int Vec2_AddScaledArray(lua_State* L)
 {
     int argc = lua_gettop(L);
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
-    const char* k = lua_tostring(L, 2);
-    const char* v = lua_tostring(L, 3);
-
-    lua_pushstring(L, "path");
+    TypedArray* dst = checkVec2Array(L, 1);
+    TypedArray* src = checkVec2Array(L, 2);
+    luaL_argcheck(L, src->length == dst->length, 2, "arrays of different lengths");
+    float scale = (float)luaL_checknumber(L, 3);
 
-    if (lua_compare(L, 2, 3, LUA_OPEQ))
-        reloadSound(snd, v);
+    Uint64 start = SDL_GetPerformanceCounter();
+    Vector_AddScaled((float*)dst->data, (float*)src->data, scale, dst->length / 2);
+    Vector_Record(dst->length / 2, start);
 
     return 0;
 }
-static int SoundGet(lua_State* L)
+static int Vec2_AddArray(lua_State* L)
 {
     int argc = lua_gettop(L);
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
-    const char* k = lua_tostring(L, 2);
+    TypedArray* dst = checkVec2Array(L, 1);
+    TypedArray* src = checkVec2Array(L, 2);
+    luaL_argcheck(L, src->length == dst->length, 2, "arrays of different lengths");
 
-    lua_pushstring(L, "path");
+    Uint64 start = SDL_GetPerformanceCounter();
+    Vector_AddScaled((float*)dst->data, (float*)src->data, 1.0f, dst->length / 2);
+    Vector_Record(dst->length / 2, start);
 
-    lua_pushnil(L);
+    return 0;
+}
+static int Vec2_ScaleArray(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    TypedArray* arr = checkVec2Array(L, 1);
+    float scale = (float)luaL_checknumber(L, 2);
 
-    if (lua_compare(L, 2, 3, LUA_OPEQ))
-        lua_pushstring(L, snd->path);
+    Uint64 start = SDL_GetPerformanceCounter();
+    Vector_Scale((float*)arr->data, scale, arr->length / 2);
+    Vector_Record(arr->length / 2, start);
 
-    return 1;
+    return 0;
 }
-static int Sound_PlaySound(lua_State* L)
+static int Vec2_RotateArray(lua_State* L)
 {
-    if (!MIXInited) return 0;
     int argc = lua_gettop(L);
-    luaL_checkArgType(L, sound, 1);
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
-    int ch = snd->channel;
+    TypedArray* arr = checkVec2Array(L, 1);
+    float angle = (float)luaL_checknumber(L, 2);
 
-    Mix_PlayChannel(ch, snd->snd, 0);
+    Uint64 start = SDL_GetPerformanceCounter();
+    Vector_Rotate((float*)arr->data, angle, arr->length / 2);
+    Vector_Record(arr->length / 2, start);
 
     return 0;
 }
-static int Sound_PauseSound(lua_State* L)
+static int Vec2_NormalizeArray(lua_State* L)
 {
     int argc = lua_gettop(L);
-    luaL_checkArgType(L, sound, 1);
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
-    int ch = snd->channel;
+    TypedArray* arr = checkVec2Array(L, 1);
 
-    Mix_Pause(ch);
+    Uint64 start = SDL_GetPerformanceCounter();
+    Vector_Normalize((float*)arr->data, arr->length / 2);
+    Vector_Record(arr->length / 2, start);
 
     return 0;
 }
-static int Sound_StopSound(lua_State* L)
+static int Vec2_LengthArray(lua_State* L)
 {
     int argc = lua_gettop(L);
-    luaL_checkArgType(L, sound, 1);
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
-    int ch = snd->channel;
+    TypedArray* arr = checkVec2Array(L, 1);
+    luaL_checkArgType(L, float32array, 2);
+    TypedArray* out = checkFloat32Array(L, 2);
+    luaL_argcheck(L, out->length >= arr->length / 2, 2, "array too short");
 
-    Mix_Resume(ch);
+    Uint64 start = SDL_GetPerformanceCounter();
+    Vector_Length((float*)out->data, (float*)arr->data, arr->length / 2);
+    Vector_Record(arr->length / 2, start);
 
     return 0;
 }
-static int Sound_IsSoundPlaying(lua_State* L)
+static int Vec2_GetStats(lua_State* L)
 {
-    int argc = lua_gettop(L);
-    luaL_checkArgType(L, sound, 1);
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
-    int ch = snd->channel;
+    const VectorStats* stats = Vector_GetStats();
 
-    lua_pushboolean(L, Mix_Playing(ch));
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, (lua_Integer)stats->calls);
+    lua_setfield(L, -2, "calls");
+    lua_pushinteger(L, (lua_Integer)stats->vectors);
+    lua_setfield(L, -2, "vectors");
+    lua_pushnumber(L, stats->time);
+    lua_setfield(L, -2, "time");
 
     return 1;
 }
-static int Sound_IsSoundPaused(lua_State* L)
+static Vec2* checkVec2(lua_State* L, int arg)
+{
+    return (Vec2*)luaL_checkudata(L, arg, VEC2_TYPE_NAME);
+}
+static Vec2* pushVec2(lua_State* L, double x, double y)
+{
+    Vec2* v = (Vec2*)lua_newuserdatauv(L, sizeof(Vec2), 0);
+    v->x = x;
+    v->y = y;
+    luaL_setmetatable(L, VEC2_TYPE_NAME);
+    return v;
+}
+
+static const char* const typedArrayNames[] = { FLOAT32ARRAY_TYPE_NAME, INT32ARRAY_TYPE_NAME, UINT8ARRAY_TYPE_NAME };
+static const size_t typedArraySizes[] = { sizeof(float), sizeof(Sint32), sizeof(Uint8) };
+
+static lua_Number typedArrayGet(const TypedArray* arr, int i)
+{
+    switch (arr->type)
+    {
+    case TYPEDARRAY_FLOAT32: return ((float*)arr->data)[i];
+    case TYPEDARRAY_INT32: return ((Sint32*)arr->data)[i];
+    default: return ((Uint8*)arr->data)[i];
+    }
+}
+static void typedArraySet(TypedArray* arr, int i, lua_Number v)
+{
+    switch (arr->type)
+    {
+    case TYPEDARRAY_FLOAT32: ((float*)arr->data)[i] = (float)v; break;
+    case TYPEDARRAY_INT32: ((Sint32*)arr->data)[i] = (Sint32)(Sint64)v; break;
+    default: ((Uint8*)arr->data)[i] = (Uint8)(Sint64)v; break;
+    }
+}
+static int newTypedArray(lua_State* L, int type)
 {
     int argc = lua_gettop(L);
-    luaL_checkArgType(L, sound, 1);
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
-    int ch = snd->channel;
+    bool fromTable = lua_istable(L, 1);
+    lua_Integer length = fromTable ? luaL_len(L, 1) : luaL_checkinteger(L, 1);
+    luaL_argcheck(L, length >= 0 && length <= INT_MAX / (lua_Integer)sizeof(float), 1, "invalid length");
 
-    lua_pushboolean(L, Mix_Paused(ch));
+    TypedArray* arr = pushTypedArray(L, type, (int)length);
+    if (fromTable)
+    {
+        for (int i = 0; i < arr->length; i++)
+        {
+            lua_geti(L, 1, i + 1);
+            typedArraySet(arr, i, lua_tonumber(L, -1));
+            lua_pop(L, 1);
+        }
+    }
 
     return 1;
 }
-static int SoundToString(lua_State* L)
+static int Float32Array_new(lua_State* L)
 {
-    int argc = lua_gettop(L);
+    return newTypedArray(L, TYPEDARRAY_FLOAT32);
+}
+static int Int32Array_new(lua_State* L)
+{
+    return newTypedArray(L, TYPEDARRAY_INT32);
+}
+static int Uint8Array_new(lua_State* L)
+{
+    return newTypedArray(L, TYPEDARRAY_UINT8);
+}
+static int TypedArrayGet(lua_State* L)
+{
+    TypedArray* arr = (TypedArray*)lua_touserdata(L, 1);
 
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
+    // indexes first, they are what scripts read in loops
+    int isnum;
+    lua_Integer i = lua_tointegerx(L, 2, &isnum);
+    if (isnum)
+    {
+        if (i < 1 || i > arr->length)
+            lua_pushnil(L);
+        else if (arr->type == TYPEDARRAY_FLOAT32)
+            lua_pushnumber(L, ((float*)arr->data)[i - 1]);
+        else
+            lua_pushinteger(L, (lua_Integer)typedArrayGet(arr, (int)i - 1));
+        return 1;
+    }
+
+    const char* k = lua_tostring(L, 2);
+    lua_pushnil(L);
+    // methods
+    if (k != NULL)
+        luaL_getmetafield(L, 1, k);
+
+    return 1;
+}
+static int TypedArraySet(lua_State* L)
+{
+    TypedArray* arr = (TypedArray*)lua_touserdata(L, 1);
+    lua_Integer i = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, i >= 1 && i <= arr->length, 2, "index out of range");
 
-    lua_pushfstring(L, SOUND_TYPE_NAME " %s", snd->path);
+    typedArraySet(arr, (int)i - 1, luaL_checknumber(L, 3));
 
+    return 0;
+}
+static int TypedArrayLen(lua_State* L)
+{
+    TypedArray* arr = (TypedArray*)lua_touserdata(L, 1);
+    lua_pushinteger(L, arr->length);
     return 1;
 }
-static int SoundGC(lua_State* L)
+static int TypedArrayToString(lua_State* L)
+{
+    TypedArray* arr = (TypedArray*)lua_touserdata(L, 1);
+    lua_pushfstring(L, "%s (%d)", typedArrayNames[arr->type], arr->length);
+    return 1;
+}
+static int TypedArray_Slice(lua_State* L)
 {
     int argc = lua_gettop(L);
-    Sound* snd = (Sound*)lua_touserdata(L, 1);
+    TypedArray* arr = checkTypedArray(L, 1);
+    lua_Integer first = luaL_checkinteger(L, 2);
+    lua_Integer last = luaL_optinteger(L, 3, arr->length);
+    luaL_argcheck(L, first >= 1 && first <= (lua_Integer)arr->length + 1, 2, "index out of range");
+    luaL_argcheck(L, last >= first - 1 && last <= arr->length, 3, "index out of range");
+
+    TypedArray* view = (TypedArray*)lua_newuserdatauv(L, sizeof(TypedArray), 1);
+    view->data = (Uint8*)arr->data + (size_t)(first - 1) * typedArraySizes[arr->type];
+    view->length = (int)(last - first + 1);
+    view->type = arr->type;
+    // the elements belong to arr, which lives as long as its views
+    lua_pushvalue(L, 1);
+    lua_setiuservalue(L, -2, 1);
+    luaL_setmetatable(L, typedArrayNames[arr->type]);
+
+    return 1;
+}
+static int TypedArray_Fill(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    TypedArray* arr = checkTypedArray(L, 1);
+    lua_Number value = luaL_checknumber(L, 2);
+    lua_Integer first = luaL_optinteger(L, 3, 1);
+    lua_Integer last = luaL_optinteger(L, 4, arr->length);
+    luaL_argcheck(L, first >= 1, 3, "index out of range");
+    luaL_argcheck(L, last <= arr->length, 4, "index out of range");
+    if (last < first) return 0;
+
+    int count = (int)(last - first + 1);
+    if (arr->type == TYPEDARRAY_UINT8)
+        memset((Uint8*)arr->data + first - 1, (Uint8)(Sint64)value, (size_t)count);
+    else
+    {
+        // one conversion, then doubling copies of what is already filled
+        typedArraySet(arr, (int)first - 1, value);
+        size_t size = typedArraySizes[arr->type];
+        Uint8* start = (Uint8*)arr->data + (size_t)(first - 1) * size;
+        for (size_t done = 1; done < (size_t)count; done *= 2)
+            memcpy(start + done * size, start, SDL_min(done, (size_t)count - done) * size);
+    }
 
-    channels[snd->channel] = false;
     return 0;
 }
+static int TypedArray_Set(lua_State* L)
+{
+    int argc = lua_gettop(L);
+    TypedArray* arr = checkTypedArray(L, 1);
+    TypedArray* src = checkTypedArray(L, 2);
+    lua_Integer offset = luaL_optinteger(L, 3, 1);
+    luaL_argcheck(L, offset >= 1 && offset - 1 + src->length <= arr->length, 3, "source doesn't fit");
+
+    if (src->type == arr->type)
+    {
+        // views of the same array may overlap
+        size_t size = typedArraySizes[arr->type];
+        memmove((Uint8*)arr->data + (size_t)(offset - 1) * size, src->data, (size_t)src->length * size);
+    }
+    else
+    {
+        for (int i = 0; i < src->length; i++)
+            typedArraySet(arr, (int)offset - 1 + i, typedArrayGet(src, i));
+    }
 
-static void reloadSound(Sound* snd, const char* fn)
+    return 0;
+}
+static int TypedArray_ToTable(lua_State* L)
 {
-    snd->snd = Mix_LoadWAV(fn);
-    if (snd->snd == NULL)
+    int argc = lua_gettop(L);
+    TypedArray* arr = checkTypedArray(L, 1);
+
+    lua_createtable(L, arr->length, 0);
+    for (int i = 0; i < arr->length; i++)
     {
-        std::cout << "Can't create sound :\n" << SDL_GetError() << std::endl;
-        QuitAll();
-        exit(1);
+        if (arr->type == TYPEDARRAY_FLOAT32)
+            lua_pushnumber(L, ((float*)arr->data)[i]);
+        else
+            lua_pushinteger(L, (lua_Integer)typedArrayGet(arr, i));
+        lua_rawseti(L, -2, i + 1);
     }
-    snd->path = fn;
+
+    return 1;
+}
+static TypedArray* pushTypedArray(lua_State* L, int type, int length)
+{
+    size_t bytes = (size_t)length * typedArraySizes[type];
+    TypedArray* arr = (TypedArray*)lua_newuserdatauv(L, sizeof(TypedArray) + bytes, 0);
+    arr->data = arr + 1;
+    arr->length = length;
+    arr->type = type;
+    memset(arr->data, 0, bytes);
+    luaL_setmetatable(L, typedArrayNames[type]);
+    return arr;
+}
+static TypedArray* checkTypedArray(lua_State* L, int arg)
+{
+    TypedArray* arr = NULL;
+    for (int type = 0; arr == NULL && type <= TYPEDARRAY_UINT8; type++)
+        arr = (TypedArray*)luaL_testudata(L, arg, typedArrayNames[type]);
+    if (arr == NULL) luaL_typeerror(L, arg, "typed array");
+    return arr;
+}
+static TypedArray* checkFloat32Array(lua_State* L, int arg)
+{
+    return (TypedArray*)luaL_checkudata(L, arg, FLOAT32ARRAY_TYPE_NAME);
+}
+static TypedArray* checkVec2Array(lua_State* L, int arg)
+{
+    TypedArray* arr = checkFloat32Array(L, arg);
+    luaL_argcheck(L, arr->length % 2 == 0, arg, "x, y pairs expected, length is odd");
+    return arr;
 }
 
 static int LuaSDL_Copy(lua_State* L)
@@ -899,14 +3911,20 @@ static int LuaSDL_Drawing_SetColor(lua_State* L)
 
     Color* col = (Color*)lua_touserdata(L, 1);
 
-    SDL_SetRenderDrawColor(renderer, col->r, col->g, col->b, col->a);
+    PipeCommand cmd = {};
+    cmd.type = PIPE_COLOR;
+    cmd.r = col->r;
+    cmd.g = col->g;
+    cmd.b = col->b;
+    cmd.a = col->a;
+    Pipeline_Draw(renderer, &cmd);
     return 0;
 }
 static int LuaSDL_Drawing_GetColor(lua_State* L)
 {
     if (!SDLInited) return 0;
     Color* col = (Color*)lua_newuserdata(L, sizeof(Color));
-    SDL_GetRenderDrawColor(renderer, &col->r, &col->g, &col->b, &col->a);
+    Pipeline_GetColor(renderer, &col->r, &col->g, &col->b, &col->a);
 
     luaL_getmetatable(L, COLOR_TYPE_NAME);
     lua_setmetatable(L, -2);
@@ -915,6 +3933,13 @@ static int LuaSDL_Drawing_GetColor(lua_State* L)
 }
 
 // drawing
+static void drawPoint(int x, int y)
+{
+    PipeCommand cmd = {};
+    cmd.type = PIPE_POINT;
+    cmd.rect = { x, y, 1, 1 };
+    Pipeline_Draw(renderer, &cmd);
+}
 static int LuaSDL_Drawing_DrawRect(lua_State* L)
 {
     if (!SDLInited) return 0;
@@ -931,16 +3956,18 @@ static int LuaSDL_Drawing_DrawRect(lua_State* L)
     int y = (argc > 1) ? (int)lua_tonumber(L, 2) : 0;
     // if no more arguments
     if (argc <= 2) {
-        SDL_RenderDrawPoint(renderer, x, y);
+        drawPoint(x, y);
         return 0;
     }
 
     int w = (argc > 2) ? (int)lua_tonumber(L, 3) : 0;
     int h = (argc > 3) ? (int)lua_tonumber(L, 4) : 0;
 
-    SDL_Rect rect = { x,y,w,h };
+    PipeCommand cmd = {};
+    cmd.type = PIPE_RECT;
+    cmd.rect = { x,y,w,h };
 
-    SDL_RenderDrawRect(renderer, &rect);
+    Pipeline_Draw(renderer, &cmd);
 
     return 0;
 }
@@ -960,16 +3987,18 @@ static int LuaSDL_Drawing_FillRect(lua_State* L)
     int y = (argc > 1) ? (int)lua_tonumber(L, 2) : 0;
     // if no more arguments
     if (argc <= 2) {
-        SDL_RenderDrawPoint(renderer, x, y);
+        drawPoint(x, y);
         return 0;
     }
 
     int w = (argc > 2) ? (int)lua_tonumber(L, 3) : 0;
     int h = (argc > 3) ? (int)lua_tonumber(L, 4) : 0;
 
-    SDL_Rect rect = { x,y,w,h };
+    PipeCommand cmd = {};
+    cmd.type = PIPE_FILL;
+    cmd.rect = { x,y,w,h };
 
-    SDL_RenderFillRect(renderer, &rect);
+    Pipeline_Draw(renderer, &cmd);
 
     return 0;
 }
@@ -983,10 +4012,34 @@ static int LuaSDL_Drawing_DrawPixel(lua_State* L)
     int x = (argc > 0) ? (int)lua_tonumber(L, 1) : 0;
     int y = (argc > 0) ? (int)lua_tonumber(L, 2) : 0;
 
-    SDL_RenderDrawPoint(renderer, x, y);
+    drawPoint(x, y);
+
+    return 0;
+}
+static int drawMany(lua_State* L, PipeCommandType type)
+{
+    if (!SDLInited) return 0;
+    int argc = lua_gettop(L);
+    TypedArray* arr = checkTypedArray(L, 1);
+    luaL_argcheck(L, arr->type != TYPEDARRAY_UINT8, 1, "Int32Array or Float32Array expected");
+
+    int stride = (type == PIPE_POINT) ? 2 : 4;
+    Pipeline_DrawMany(renderer, type, arr->data, arr->type == TYPEDARRAY_FLOAT32, arr->length / stride);
 
     return 0;
 }
+static int LuaSDL_Drawing_DrawPixels(lua_State* L)
+{
+    return drawMany(L, PIPE_POINT);
+}
+static int LuaSDL_Drawing_DrawRects(lua_State* L)
+{
+    return drawMany(L, PIPE_RECT);
+}
+static int LuaSDL_Drawing_FillRects(lua_State* L)
+{
+    return drawMany(L, PIPE_FILL);
+}
 static int LuaSDL_Drawing_DrawImage(lua_State* L)
 {
     if (!SDLInited) return 0;
@@ -995,20 +4048,19 @@ static int LuaSDL_Drawing_DrawImage(lua_State* L)
     luaL_checkArgType(L, number, 2);
     luaL_checkArgType(L, number, 3);
 
-    Image* img = (Image*)lua_touserdata(L, 1);
-    SDL_Surface* image = img->surf;
+    Image* img = checkImage(L, 1);
     int x = (argc > 1) ? (int)lua_tonumber(L, 2) : 0;
     int y = (argc > 2) ? (int)lua_tonumber(L, 3) : 0;
 
-    SDL_Rect* drawRect = &image->clip_rect;
-    drawRect->x = x;
-    drawRect->y = y;
-
-    SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, image);
+    PipeCommand cmd = {};
+    cmd.type = PIPE_COPY;
+    cmd.rect = { x, y, img->w, img->h };
 
-    SDL_RenderCopy(renderer, tex, NULL, drawRect);
+    // the texture is uploaded once and kept with the image
+    cmd.tex = imageTexture(img);
+    if (cmd.tex == NULL) return 0;
 
-    SDL_DestroyTexture(tex);
+    Pipeline_Draw(renderer, &cmd);
 
     return 0;
 }
@@ -6,12 +6,31 @@
 #define COLOR_TYPE_NAME "Color"
 #define IMAGE_TYPE_NAME "Image"
 #define SOUND_TYPE_NAME "Sound"
+#define MUSIC_TYPE_NAME "Music"
+#define AUDIOSTREAM_TYPE_NAME "AudioStream"
+#define AUDIOGROUP_TYPE_NAME "AudioGroup"
+#define VEC2_TYPE_NAME "Vec2"
+#define FLOAT32ARRAY_TYPE_NAME "Float32Array"
+#define INT32ARRAY_TYPE_NAME "Int32Array"
+#define UINT8ARRAY_TYPE_NAME "Uint8Array"
+
+#define TYPEDARRAY_FLOAT32 0
+#define TYPEDARRAY_INT32 1
+#define TYPEDARRAY_UINT8 2
+
+#define IMAGE_RESIDENCY_CPU 0
+#define IMAGE_RESIDENCY_GPU 1
 
 // engine types
 typedef struct Image
 {
 	SDL_Surface* surf;
-	const char* path;
+	// uploaded on first draw, or straight from the texture cache
+	SDL_Texture* tex;
+	char* path;
+	int w, h;
+	// IMAGE_RESIDENCY_GPU frees the surface once the texture is uploaded
+	int residency;
 } Image;
 typedef struct Color
 {
@@ -20,26 +39,70 @@ typedef struct Color
 typedef struct Sound
 {
 	Mix_Chunk* snd;
-	const char* path;
-	int channel;
+	char* path;
+	// voices of higher priority are never stolen to play this one
+	int priority;
+	// from 0 to 1, and from -1 (left) to 1 (right)
+	float volume, pan;
+	// positional sounds are attenuated and panned from the listener each frame
+	bool positional;
+	float x, y;
+	// the volume and pan its voices were last given, only changes are sent to them
+	float sentVolume, sentPan;
+	// applied to each voice played afterwards, see Sound:SetEffects
+	struct DspParams* effects;
+	int effectCount;
+	// id of its AudioGroup, 0 when in none
+	int group;
 } Sound;
+typedef struct Music
+{
+	// decoded as it plays, from the file or a pak archive
+	Mix_Music* mus;
+	char* path;
+	// size of the encoded source
+	Sint64 size;
+	// id of its AudioGroup, 0 when in none
+	int group;
+} Music;
+typedef struct AudioStream
+{
+	// NULL once released
+	struct Stream* stream;
+} AudioStream;
+typedef struct AudioGroup
+{
+	// 0 once released
+	int id;
+} AudioGroup;
+typedef struct Vec2
+{
+	double x, y;
+} Vec2;
+typedef struct TypedArray
+{
+	// the elements follow the struct in the same userdata,
+	// or belong to the array it is a view of
+	void* data;
+	int length;
+	// TYPEDARRAY_FLOAT32, TYPEDARRAY_INT32 or TYPEDARRAY_UINT8
+	int type;
+} TypedArray;
 
 void loop();
 
+void HandleEvent(SDL_Event* event);
 void QuitSDL(), QuitAll();
 void Update(), Render();
-
-static const int maxChannels = MIX_CHANNELS;
-static bool channels[maxChannels] = {
-	false,
-	false,
-	false,
-	false,
-	false,
-	false,
-	false,
-	0
-};
+// reload the images, sounds and modules whose file changed
+void HotReload();
+// attenuate and pan every positional sound at once
+void SpatialFrame();
+// advance the fades of the audio groups
+// return whether a group changed, then the fade goes on
+bool GroupFrame();
+// return whether a playing stream has room, then the script feeding it needs the next frame
+bool StreamFrame();
 
 // engine macros
 #define luaL_checkArgType(L, type, arg) \
@@ -49,9 +112,14 @@ static bool channels[maxChannels] = {
 void LoadEngine(lua_State* L);
 
 // start SDL
-// args : name(string), width(number), height(number), (optional) x(number), (optional) y(number)
+// args : name(string), width(number), height(number), (optional) x(number), (optional) y(number), (optional) pipelined(boolean)
+// pipelined frames are replayed by a render thread while the next one is recorded
 // return (nil)
 static int LuaSDL_Start(lua_State* L);
+// get the time each subsystem, image codec and audio decoder took to initialise, in milliseconds
+// args :
+// return { [name] = time }(table)
+static int LuaSDL_GetInitStats(lua_State* L);
 // poll events
 // args :
 // return (nil)
@@ -73,6 +141,27 @@ static int LuaSDL_Window_GetPos(lua_State* L);
 // args : x(number), y(number)
 // return (nil)
 static int LuaSDL_Window_SetPos(lua_State* L);
+// get the average frame time, render (replay and present) time, time waited for the render thread
+// and latency from the start of a frame to its present, in milliseconds
+// args :
+// return { pipelined, frames, frameTime, renderTime, waitTime, latency }(table)
+static int LuaSDL_Window_GetRenderStats(lua_State* L);
+// in idle mode each frame waits for an input, a redraw or the timeout, 0 waits without timeout
+// args : enabled(boolean), (optional) timeout(integer, milliseconds)
+// return (nil)
+static int LuaSDL_Window_SetIdle(lua_State* L);
+// args :
+// return boolean
+static int LuaSDL_Window_IsIdle(lua_State* L);
+// run the next frame without waiting, in idle mode
+// args :
+// return (nil)
+static int LuaSDL_Window_Redraw(lua_State* L);
+// get the frames run, the waits ended by an event, the frames not drawn while the window was hidden,
+// the share of time the loop didn't wait and the time to wake up for an event, in milliseconds
+// args :
+// return { idle, frames, wakeups, suspended, cpu, wakeLatency, maxWakeLatency }(table)
+static int LuaSDL_Window_GetIdleStats(lua_State* L);
 
 // get wether given mouse button is down
 // args : button(integer)
@@ -97,14 +186,203 @@ static int LuaSDL_Input_IsKeyReleased(lua_State* L);
 // return number, number
 static int LuaSDL_Input_GetMousePos(lua_State* L);
 
-// create a new image
+// mount a .pak archive, its entries are then loadable as "pak://<name>"
 // args : path(string)
+// return boolean
+static int LuaSDL_Pak_Mount(lua_State* L);
+
+// watch loaded files and reload them in place when they change
+// args : enabled(boolean)
+// return (nil)
+static int LuaSDL_HotReload_SetEnabled(lua_State* L);
+// return wether hot reload is enabled
+// args :
+// return boolean
+static int LuaSDL_HotReload_IsEnabled(lua_State* L);
+
+// get the lua allocator statistics, every block is a large one when built with LUASDL_SYSTEM_ALLOC
+// args :
+// return { allocs, frees, reallocs, smallAllocs, largeAllocs, bytes, peak, reserved }(table)
+static int LuaSDL_Memory_GetAllocStats(lua_State* L);
+// get the memory used by each category : lua, surfaces, textures, chunks, music and archives
+// args :
+// return { [category] = { bytes, peak, count } }(table)
+static int LuaSDL_Memory_GetStats(lua_State* L);
+// print the memory used by each category every given seconds, 0 disables it
+// args : seconds(number)
+// return (nil)
+static int LuaSDL_Memory_SetLogInterval(lua_State* L);
+// get the memory log interval
+// args :
+// return seconds(number)
+static int LuaSDL_Memory_GetLogInterval(lua_State* L);
+// list the images and sounds never released when quitting
+// args : enabled(boolean)
+// return (nil)
+static int LuaSDL_Memory_SetLeakReport(lua_State* L);
+// return wether the leak report is enabled
+// args :
+// return boolean
+static int LuaSDL_Memory_GetLeakReport(lua_State* L);
+
+// set the time the garbage collector may take at the end of each frame
+// 0 leaves the collector to lua
+// args : microseconds(number)
+// return (nil)
+static int LuaSDL_GC_SetBudget(lua_State* L);
+// get the garbage collector frame budget
+// args :
+// return microseconds(number)
+static int LuaSDL_GC_GetBudget(lua_State* L);
+// set the garbage collector mode, "auto" switches between the two others
+// args : mode("auto", "incremental" or "generational")
+// return (nil)
+static int LuaSDL_GC_SetMode(lua_State* L);
+// get the garbage collector mode
+// args :
+// return mode(string), active mode(string)
+static int LuaSDL_GC_GetMode(lua_State* L);
+// get the garbage collector statistics, frameTime is in microseconds and heap in KB
+// args :
+// return { frameTime, frameSteps, cycles, overruns, mode, heap }(table)
+static int LuaSDL_GC_GetStats(lua_State* L);
+
+// open the audio device, reloading the sounds and musics if it was open already
+// it is opened with the defaults when the first sound or music is created
+// args : (optional) { frequency(integer), format("u8", "s8", "s16", "s32" or "f32"), channels(integer), chunksize(integer) }
+// defaults to { 48000, "s16", 2, 512 }
+// return boolean
+static int LuaSDL_Audio_Open(lua_State* L);
+// close the audio device, sounds and musics don't play until it is opened again
+// args :
+// return (nil)
+static int LuaSDL_Audio_Close(lua_State* L);
+// get the spec the audio device was opened with, chunksize is the one measured once playing
+// args :
+// return { frequency, format, channels, chunksize }(table) or nil when closed
+static int LuaSDL_Audio_QuerySpec(lua_State* L);
+// get the audio latency in milliseconds : the mixer buffer, an estimate of the output latency
+// without the system's share, and the average and longest time between two mixer callbacks,
+// which show jitter rather than latency
+// args :
+// return { buffer, estimate, interval, maxInterval, callbacks }(table)
+static int LuaSDL_Audio_GetLatency(lua_State* L);
+// get the audio callback instrumentation, times are in microseconds
+// budget is the time a callback has before the device runs out, load the average time over it
+// histogram counts callbacks by time spent, the first bucket below 32 us then each twice as wide
+// late counts callbacks more than half a buffer after the previous one, underruns callbacks where
+// a playing stream ran dry, overruns callbacks slower than their budget
+// fill is the frames queued in the emptiest playing stream, -1 if none plays
+// args :
+// return { callbacks, callbackTime, maxCallbackTime, budget, load, histogram, late, underruns, overruns, fill }(table)
+static int LuaSDL_Audio_GetStats(lua_State* L);
+// start the audio callback instrumentation over
+// args :
+// return (nil)
+static int LuaSDL_Audio_ResetStats(lua_State* L);
+// mix sounds in the audio callback with simd kernels instead of through SDL_mixer channels,
+// the device must be opened with format "s16" or "f32", and 1 or 2 channels
+// args : enabled(boolean)
+// return boolean, false if the native mixer can't run
+static int LuaSDL_Audio_SetNativeMixer(lua_State* L);
+// return wether sounds play through the native mixer
+// args :
+// return boolean
+static int LuaSDL_Audio_IsNativeMixer(lua_State* L);
+// get the native mixer statistics, times are in microseconds
+// args :
+// return { voices, commands, dropped, steals, drops, callbackTime, maxCallbackTime, kernel }(table)
+static int LuaSDL_Audio_GetMixerStats(lua_State* L);
+// set the position positional sounds are heard from
+// args : x(number), y(number)
+// return (nil)
+static int LuaSDL_Audio_SetListener(lua_State* L);
+// get the listener position
+// args :
+// return x(number), y(number)
+static int LuaSDL_Audio_GetListener(lua_State* L);
+// set the distance past which positional sounds are silent and cost no mixing
+// args : radius(number)
+// return (nil)
+static int LuaSDL_Audio_SetAudibleRadius(lua_State* L);
+// get the audible radius
+// args :
+// return radius(number)
+static int LuaSDL_Audio_GetAudibleRadius(lua_State* L);
+// get the positional pass statistics of the last frame, time is in microseconds
+// args :
+// return { emitters, culled, time }(table)
+static int LuaSDL_Audio_GetSpatialStats(lua_State* L);
+// set how many sounds may play at once, past it the lowest priority then the oldest voice is stolen
+// args : voices(integer)
+// return (nil)
+static int LuaSDL_Audio_SetVoiceLimit(lua_State* L);
+// get the voice limit
+// args :
+// return voices(integer)
+static int LuaSDL_Audio_GetVoiceLimit(lua_State* L);
+// get the voice statistics
+// args :
+// return { allocated, playing, steals, drops }(table)
+static int LuaSDL_Audio_GetVoiceStats(lua_State* L);
+// set the effects applied to the whole output, after every sound, music and stream is mixed
+// args : (optional) effects, see Sound:SetEffects, nil removes them
+// return boolean, false if the device isn't s16 or f32, mono or stereo
+static int LuaSDL_Audio_SetBusEffects(lua_State* L);
+// get the average time the bus effects take per mixer callback, in microseconds
+// args :
+// return time(number)
+static int LuaSDL_Audio_GetBusTime(lua_State* L);
+// analyse the output on a worker thread, see LuaSDL.Audio.GetSpectrum
+// args : enabled(boolean), (optional, default : 16) bands(integer) from 1 to 32
+// return boolean, false if the worker can't start
+static int LuaSDL_Audio_SetSpectrum(lua_State* L);
+// get the last analysis of the output, in the same table every call so reading it each frame doesn't allocate
+// bands go from low to high frequencies, each the rms magnitude of its bins where a full scale sine is 1
+// onset is true if one was detected since the previous call, time is in microseconds
+// args :
+// return { [1..bands](number), onset(boolean), flux(number), analyses(integer), dropped(integer), time(number) }(table)
+static int LuaSDL_Audio_GetSpectrum(lua_State* L);
+
+// set the directory decoded images are cached in, relative to the working directory, nil disables
+// the cache, which is off until a directory is set
+// args : (optional) dir(string)
+// return (nil)
+static int LuaSDL_Cache_SetDir(lua_State* L);
+// get the cache directory
+// args :
+// return dir(string) or nil when disabled
+static int LuaSDL_Cache_GetDir(lua_State* L);
+// get the image loading statistics, times are in milliseconds
+// args :
+// return { hits, misses, hitTime, missTime }(table)
+static int LuaSDL_Cache_GetStats(lua_State* L);
+
+// create a new image
+// args : path(string), can be a "pak://" path
 // return Image
 static int Image_new(lua_State* L);
+// set the residency of new images : "cpu" keeps the decoded pixels,
+// "gpu" frees them once the texture is uploaded
+// args : residency(string)
+// return (nil)
+static int Image_SetResidency(lua_State* L);
+// get the residency of new images
+// args :
+// return residency(string)
+static int Image_GetResidency(lua_State* L);
 // the __newindex metamethod for Image datatype
 static int ImageSet(lua_State* L);
 // the __index metamethod for Image datatype
 static int ImageGet(lua_State* L);
+// get the color of a pixel, decoding gpu resident images again, an error if their source is gone
+// args : x(integer), y(integer)
+// return Color
+static int Image_GetPixel(lua_State* L);
+// free the image now instead of when it is collected, it can't be used afterwards
+// args :
+// return (nil)
+static int Image_Release(lua_State* L);
 static int ImageToString(lua_State* L);
 static int ImageGC(lua_State* L);
 static inline int lua_isimage(lua_State* L, int idx)
@@ -112,8 +390,35 @@ static inline int lua_isimage(lua_State* L, int idx)
 	return lua_isuserdata(L, idx) & (luaL_checkudata(L, idx, IMAGE_TYPE_NAME) != NULL);
 }
 
-// reload given image with filename
-static void reloadImage(Image* img, const char* fn);
+// reload given image with filename, keeping the previous pixels if it can't be loaded
+// return false if it couldn't, see SDL_GetError
+static bool reloadImage(Image* img, const char* fn);
+// load fn in given format, setting its texture if tex isn't NULL and there is a renderer,
+// and its surface if needed or if there is no texture
+// decoded images are converted to the renderer's format and cached on disk,
+// later loads map that cache instead of decoding again
+static bool loadImage(const char* fn, Uint32 format, bool needSurface, SDL_Surface** surf, SDL_Texture** tex, int* w, int* h);
+// the pixel format images are converted to
+static Uint32 imageFormat();
+// create a static texture from pixels in given format
+static SDL_Texture* createImageTexture(Uint32 format, int w, int h, const void* pixels, int pitch);
+// get the image texture, uploading it if needed
+// return NULL without a renderer or when a gpu resident image can't be decoded again
+static SDL_Texture* imageTexture(Image* img);
+// get the image surface, decoding it again if it was freed
+// return NULL and set the SDL error if the source can't be decoded anymore
+static SDL_Surface* imageSurface(Image* img);
+// return false if the image can't be decoded again to move it to the cpu
+static bool setImageResidency(Image* img, int residency);
+// free everything the image holds, does nothing once released
+static void releaseImage(Image* img);
+// get the image at arg, raising an error if it was released
+static Image* checkImage(lua_State* L, int arg);
+// drop every image texture after the render device was reset
+void ResetImageTextures();
+// free image resources, keeping the memory accounting right
+static void destroyImageTexture(SDL_Texture* tex);
+static void freeImageSurface(SDL_Surface* surf);
 
 // create a new image
 // args : r(number),g(number),b(number),(optional, default : 255) a(number)
@@ -134,26 +439,30 @@ static inline int lua_iscolor(lua_State* L, int idx)
 }
 
 // create a new sound
-// args : path (string)
+// args : path (string), can be a "pak://" path
 // return Sound
 static int Sound_new(lua_State* L);
 // the __newindex metamethod for Sound datatype
 static int SoundSet(lua_State* L);
 // the __index metamethod for Sound datatype
 static int SoundGet(lua_State* L);
-// play the given sound
+// play the given sound on a new voice, sounds of equal or lower priority may be stolen
 // args :
-// return nil
+// return boolean, false if every voice has a higher priority
 static int Sound_PlaySound(lua_State* L);
-// pause the given sound
+// pause every voice of the given sound
 // args :
 // return nil
 static int Sound_PauseSound(lua_State* L);
-// stop the given sound
+// resume every voice of the given sound
+// args :
+// return nil
+static int Sound_ResumeSound(lua_State* L);
+// stop every voice of the given sound
 // args :
 // return nil
 static int Sound_StopSound(lua_State* L);
-// return wether given sound is playing or not
+// return wether given sound is playing or not, paused voices count as playing
 // args :
 // return boolean
 static int Sound_IsSoundPlaying(lua_State* L);
@@ -161,6 +470,18 @@ static int Sound_IsSoundPlaying(lua_State* L);
 // args :
 // return boolean
 static int Sound_IsSoundPaused(lua_State* L);
+// set the effects of the voices played afterwards, at most 4, applied in order
+// filters run on each voice, the delay and reverb are shared by the voices of the sound
+// and ring on after they end, changing the effects cuts them off
+// sounds with effects play through SDL_mixer channels even when the native mixer runs
+// args : (optional) { { type("lowpass", "highpass", "delay" or "reverb"), cutoff(number), q(number),
+// time(number), feedback(number), room(number), damping(number), mix(number) }, ... }, nil removes them
+// return nil
+static int Sound_SetEffects(lua_State* L);
+// free the sound now instead of when it is collected, it can't be used afterwards
+// args :
+// return (nil)
+static int Sound_Release(lua_State* L);
 static int SoundToString(lua_State* L);
 static int SoundGC(lua_State* L);
 static int lua_issound(lua_State* L, int idx)
@@ -168,7 +489,291 @@ static int lua_issound(lua_State* L, int idx)
 	return lua_isuserdata(L, idx) & (luaL_checkudata(L, idx, SOUND_TYPE_NAME) != NULL);
 }
 
-static void reloadSound(Sound* snd, const char* fn);
+// load the chunk of given sound from filename, keeping the previous one if it can't be loaded
+// return false if it couldn't, see SDL_GetError
+static bool reloadSound(Sound* snd, const char* fn);
+// get the volume and pan a sound plays with, from the listener if it is positional
+static void soundGains(const Sound* snd, float* volume, float* pan);
+// give the voices of a sound that volume and pan, unless they have them already
+static void setSoundGains(Sound* snd, float volume, float pan);
+// free a chunk, once the native mixer let go of it
+static void freeChunk(void* chunk);
+// free everything the sound holds, does nothing once released
+static void releaseSound(Sound* snd);
+// get the sound at arg, raising an error if it was released
+static Sound* checkSound(lua_State* L, int arg);
+// read a table of effects at arg into params, return how many were read
+static int readEffects(lua_State* L, int arg, struct DspParams* params);
+
+// create a new music, streamed instead of decoded whole like sounds
+// args : path(string), can be a "pak://" path
+// return Music
+static int Music_new(lua_State* L);
+// the __newindex metamethod for Music datatype
+static int MusicSet(lua_State* L);
+// the __index metamethod for Music datatype
+static int MusicGet(lua_State* L);
+// play the given music, stopping the one playing
+// args : (optional, default : 1) loops(integer), -1 loops forever
+// return nil
+static int Music_Play(lua_State* L);
+// pause the given music if it is playing
+// args :
+// return nil
+static int Music_Pause(lua_State* L);
+// resume the given music if it is paused
+// args :
+// return nil
+static int Music_Resume(lua_State* L);
+// stop the given music if it is playing
+// args :
+// return nil
+static int Music_Stop(lua_State* L);
+// set the position of the given music if it is playing
+// args : seconds(number)
+// return nil
+static int Music_Seek(lua_State* L);
+// play the given music, fading in from silence
+// args : milliseconds(integer), (optional, default : 1) loops(integer)
+// return nil
+static int Music_FadeIn(lua_State* L);
+// fade the given music out and stop it, if it is playing
+// args : milliseconds(integer)
+// return nil
+static int Music_FadeOut(lua_State* L);
+// return wether given music is playing, paused or not
+// args :
+// return boolean
+static int Music_IsPlaying(lua_State* L);
+// return wether given music is paused
+// args :
+// return boolean
+static int Music_IsPaused(lua_State* L);
+// get the position in the given music, and its duration, -1 when unknown
+// args :
+// return seconds(number), seconds(number)
+static int Music_GetPosition(lua_State* L);
+// free the music now instead of when it is collected, it can't be used afterwards
+// args :
+// return (nil)
+static int Music_Release(lua_State* L);
+static int MusicToString(lua_State* L);
+static int MusicGC(lua_State* L);
+static int lua_ismusic(lua_State* L, int idx)
+{
+	return lua_isuserdata(L, idx) & (luaL_checkudata(L, idx, MUSIC_TYPE_NAME) != NULL);
+}
+
+// load given music from filename, keeping the previous one if it can't be loaded
+// return false if it couldn't, see SDL_GetError
+static bool reloadMusic(Music* mus, const char* fn);
+
+// create a new audio stream, played from samples written by the script
+// samples are numbers from -1 to 1 at the audio device frequency, see LuaSDL.Audio.QuerySpec
+// args : (optional, default : 1) channels(1 or 2), (optional, default : a quarter second) capacity(integer) in frames
+// return AudioStream
+static int AudioStream_new(lua_State* L);
+// the __newindex metamethod for AudioStream datatype
+static int AudioStreamSet(lua_State* L);
+// the __index metamethod for AudioStream datatype
+static int AudioStreamGet(lua_State* L);
+// queue samples, interleaved left and right for stereo streams
+// a Float32Array is queued without going through lua values
+// args : samples(table | Float32Array)
+// return frames written(integer), fewer than given when the stream is full
+static int AudioStream_Write(lua_State* L);
+// start draining the given stream
+// args :
+// return nil
+static int AudioStream_Play(lua_State* L);
+// stop draining the given stream, queued samples are kept
+// args :
+// return nil
+static int AudioStream_Pause(lua_State* L);
+// return wether given stream is playing
+// args :
+// return boolean
+static int AudioStream_IsPlaying(lua_State* L);
+// get how many frames are queued and how many fit
+// args :
+// return fill(integer), capacity(integer)
+static int AudioStream_GetFill(lua_State* L);
+// get how many callbacks ran out of queued samples, and how many frames were played
+// args :
+// return underruns(integer), played(integer)
+static int AudioStream_GetUnderruns(lua_State* L);
+// free the stream now instead of when it is collected, it can't be used afterwards
+// args :
+// return (nil)
+static int AudioStream_Release(lua_State* L);
+static int AudioStreamToString(lua_State* L);
+static int AudioStreamGC(lua_State* L);
+static int lua_isaudiostream(lua_State* L, int idx)
+{
+	return lua_isuserdata(L, idx) & (luaL_checkudata(L, idx, AUDIOSTREAM_TYPE_NAME) != NULL);
+}
+
+// free the stream, does nothing once released
+static void releaseAudioStream(AudioStream* as);
+// get the stream at arg, raising an error if it was released
+static AudioStream* checkAudioStream(lua_State* L, int arg);
+
+// create a new audio group, sounds and musics put in it follow its volume, mute and pause
+// with one call, however many voices play
+// args :
+// return AudioGroup
+static int AudioGroup_new(lua_State* L);
+// the __newindex metamethod for AudioGroup datatype
+static int AudioGroupSet(lua_State* L);
+// the __index metamethod for AudioGroup datatype
+static int AudioGroupGet(lua_State* L);
+// move the volume of the given group over time
+// args : volume(number), ms(integer)
+// return nil
+static int AudioGroup_FadeTo(lua_State* L);
+// return wether the given group is fading
+// args :
+// return boolean
+static int AudioGroup_IsFading(lua_State* L);
+// pause every sound and music of the given group
+// args :
+// return nil
+static int AudioGroup_Pause(lua_State* L);
+// resume every sound and music of the given group, the ones paused on their own stay paused
+// args :
+// return nil
+static int AudioGroup_Resume(lua_State* L);
+// stop every sound and music of the given group
+// args :
+// return nil
+static int AudioGroup_Stop(lua_State* L);
+// free the group now instead of when it is collected, its sounds and musics leave it
+// args :
+// return (nil)
+static int AudioGroup_Release(lua_State* L);
+static int AudioGroupToString(lua_State* L);
+static int AudioGroupGC(lua_State* L);
+static int lua_isaudiogroup(lua_State* L, int idx)
+{
+	return lua_isuserdata(L, idx) & (luaL_checkudata(L, idx, AUDIOGROUP_TYPE_NAME) != NULL);
+}
+
+// free the group, does nothing once released
+static void releaseAudioGroup(AudioGroup* ag);
+// get the group at arg, raising an error if it was released
+static AudioGroup* checkAudioGroup(lua_State* L, int arg);
+// get the group id of the AudioGroup or nil at arg, keeping the group alive as long as the userdata at idx
+static int setGroup(lua_State* L, int idx, int arg);
+
+// create a new vector
+// args : (optional) x(number), (optional) y(number)
+// return Vec2
+static int Vec2_new(lua_State* L);
+// the __newindex metamethod for Vec2 datatype
+static int Vec2Set(lua_State* L);
+// the __index metamethod for Vec2 datatype
+static int Vec2Get(lua_State* L);
+// the __add, __sub, __mul (by a number), __div (by a number), __unm and __eq metamethods for Vec2 datatype
+static int Vec2Add(lua_State* L);
+static int Vec2Sub(lua_State* L);
+static int Vec2Mul(lua_State* L);
+static int Vec2Div(lua_State* L);
+static int Vec2Unm(lua_State* L);
+static int Vec2Eq(lua_State* L);
+static int Vec2ToString(lua_State* L);
+// args :
+// return number
+static int Vec2_Length(lua_State* L);
+// get the vector of length 1 going the same way, a null vector stays null
+// args :
+// return Vec2
+static int Vec2_Normalize(lua_State* L);
+// get the vector rotated by given angle, counterclockwise with y up
+// args : angle(number, radians)
+// return Vec2
+static int Vec2_Rotate(lua_State* L);
+// args : other(Vec2)
+// return number
+static int Vec2_Dot(lua_State* L);
+// the batch functions take Float32Arrays of interleaved x, y pairs
+// add src times scale to dst, both of the same length
+// args : dst(Float32Array), src(Float32Array), scale(number)
+// return (nil)
+static int Vec2_AddScaledArray(lua_State* L);
+// args : dst(Float32Array), src(Float32Array)
+// return (nil)
+static int Vec2_AddArray(lua_State* L);
+// args : vectors(Float32Array), scale(number)
+// return (nil)
+static int Vec2_ScaleArray(lua_State* L);
+// args : vectors(Float32Array), angle(number, radians)
+// return (nil)
+static int Vec2_RotateArray(lua_State* L);
+// args : vectors(Float32Array)
+// return (nil)
+static int Vec2_NormalizeArray(lua_State* L);
+// write the length of each vector to out, half as long as vectors
+// args : vectors(Float32Array), out(Float32Array)
+// return (nil)
+static int Vec2_LengthArray(lua_State* L);
+// get the batch calls, the vectors they went through and the time they took, in microseconds
+// args :
+// return { calls, vectors, time }(table)
+static int Vec2_GetStats(lua_State* L);
+static inline int lua_isvec2(lua_State* L, int idx)
+{
+	return lua_isuserdata(L, idx) & (luaL_checkudata(L, idx, VEC2_TYPE_NAME) != NULL);
+}
+// get the vector at arg
+static Vec2* checkVec2(lua_State* L, int arg);
+// push a new vector
+static Vec2* pushVec2(lua_State* L, double x, double y);
+
+// create a new array of floats, integers or bytes, zeroed or copied from a table of numbers
+// args : length(integer) | values(table)
+// return Float32Array, Int32Array or Uint8Array
+static int Float32Array_new(lua_State* L);
+static int Int32Array_new(lua_State* L);
+static int Uint8Array_new(lua_State* L);
+// the __index metamethod for typed arrays, from 1 to their length
+static int TypedArrayGet(lua_State* L);
+// the __newindex metamethod for typed arrays, integers are truncated and bytes wrap around
+static int TypedArraySet(lua_State* L);
+static int TypedArrayLen(lua_State* L);
+static int TypedArrayToString(lua_State* L);
+// get a view of the elements from first to last included, writing to it writes to the array
+// args : first(integer), (optional) last(integer)
+// return the same type of array
+static int TypedArray_Slice(lua_State* L);
+// set the elements from first to last included to value
+// args : value(number), (optional) first(integer), (optional) last(integer)
+// return (nil)
+static int TypedArray_Fill(lua_State* L);
+// copy the elements of src starting at offset, converting them if src is of another type
+// args : src(typed array), (optional) offset(integer)
+// return (nil)
+static int TypedArray_Set(lua_State* L);
+// args :
+// return table
+static int TypedArray_ToTable(lua_State* L);
+static inline int lua_isfloat32array(lua_State* L, int idx)
+{
+	return lua_isuserdata(L, idx) & (luaL_checkudata(L, idx, FLOAT32ARRAY_TYPE_NAME) != NULL);
+}
+// push a new array of length elements, zeroed
+static TypedArray* pushTypedArray(lua_State* L, int type, int length);
+// get the typed array at arg, of any type
+static TypedArray* checkTypedArray(lua_State* L, int arg);
+// get the Float32Array at arg
+static TypedArray* checkFloat32Array(lua_State* L, int arg);
+// get the array of x, y pairs at arg, raising an error if its length is odd
+static TypedArray* checkVec2Array(lua_State* L, int arg);
+// apply the gain and pause state of group to the voices and music not mixed natively
+static void applyGroup(int group);
+// free everything the music holds, does nothing once released
+static void releaseMusic(Music* mus);
+// get the music at arg, raising an error if it was released
+static Music* checkMusic(lua_State* L, int arg);
 
 // copy given values
 // args : ... (any)
@@ -208,4 +813,16 @@ static int LuaSDL_Drawing_DrawPixel(lua_State* L);
 // args : image(Image), x(integer), y(integer)
 // return (nil)
 static int LuaSDL_Drawing_DrawImage(lua_State* L);
+// draw a pixel for each x, y pair
+// args : points(Int32Array | Float32Array)
+// return (nil)
+static int LuaSDL_Drawing_DrawPixels(lua_State* L);
+// draw a rectangle outline for each x, y, width, height group
+// args : rects(Int32Array | Float32Array)
+// return (nil)
+static int LuaSDL_Drawing_DrawRects(lua_State* L);
+// draw a rectangle for each x, y, width, height group
+// args : rects(Int32Array | Float32Array)
+// return (nil)
+static int LuaSDL_Drawing_FillRects(lua_State* L);
 #endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include <iostream>
+
+#include <include/SDL.h>
+
+#include <include/lua.hpp>
+
+#include "Memory.hpp"
+#include "Pool.hpp"
+
+static MemCounter counters[MEM_CATEGORIES] = {};
+static const char* const names[MEM_CATEGORIES] = {
+    "lua",
+    "surfaces",
+    "textures",
+    "chunks",
+    "music",
+    "archives"
+};
+
+static bool leakReport = false;
+static double logInterval = 0.0;
+static Uint32 lastLog = 0;
+
+void Mem_Track(MemCategory category, Sint64 bytes, Sint64 count)
+{
+    MemCounter* c = &counters[category];
+    c->bytes += bytes;
+    c->count += count;
+    if (c->bytes > c->peak)
+        c->peak = c->bytes;
+}
+const MemCounter* Mem_Get(lua_State* L, MemCategory category)
+{
+    if (category == MEM_LUA && L != NULL)
+    {
+        // the heap is known by lua itself, the block count only by the allocator
+        const AllocStats* stats = Pool_GetStats();
+        MemCounter* c = &counters[MEM_LUA];
+        c->bytes = (Sint64)lua_gc(L, LUA_GCCOUNT) * 1024 + lua_gc(L, LUA_GCCOUNTB);
+        c->count = (Sint64)(stats->allocs - stats->frees);
+        if (c->bytes > c->peak)
+            c->peak = c->bytes;
+    }
+    return &counters[category];
+}
+const char* Mem_Name(MemCategory category)
+{
+    return names[category];
+}
+
+Sint64 Mem_SurfaceBytes(const SDL_Surface* surf)
+{
+    if (surf == NULL) return 0;
+    return (Sint64)surf->pitch * surf->h;
+}
+Sint64 Mem_TextureBytes(SDL_Texture* tex)
+{
+    Uint32 format;
+    int w, h;
+    if (tex == NULL || SDL_QueryTexture(tex, &format, NULL, &w, &h) != 0) return 0;
+    return (Sint64)w * h * SDL_BYTESPERPIXEL(format);
+}
+
+void Mem_SetLogInterval(double seconds)
+{
+    logInterval = SDL_max(seconds, 0.0);
+    lastLog = SDL_GetTicks();
+}
+double Mem_GetLogInterval()
+{
+    return logInterval;
+}
+void Mem_Frame(lua_State* L)
+{
+    if (logInterval <= 0.0) return;
+
+    Uint32 now = SDL_GetTicks();
+    if ((double)(now - lastLog) < logInterval * 1000.0) return;
+    lastLog = now;
+    Mem_Log(L);
+}
+void Mem_Log(lua_State* L)
+{
+    std::cout << "memory :";
+    for (int i = 0; i < MEM_CATEGORIES; i++)
+    {
+        const MemCounter* c = Mem_Get(L, (MemCategory)i);
+        std::cout << " " << names[i] << " " << (double)c->bytes / 1024.0 << " KB (" << c->count << ")";
+    }
+    std::cout << std::endl;
+}
+
+void Mem_SetLeakReport(bool enabled)
+{
+    leakReport = enabled;
+}
+bool Mem_GetLeakReport()
+{
+    return leakReport;
+}
+void Mem_ReportAlive(const char* type, const char* path, Sint64 bytes)
+{
+    if (!leakReport) return;
+    std::cout << "not released : " << type << " " << (path ? path : "?") << " (" << (double)bytes / 1024.0 << " KB)" << std::endl;
+}
+bool Mem_ReportLeaks()
+{
+    bool leaked = false;
+    // the lua heap is gone with its state, and archives have their own lifetime
+    for (int i = MEM_SURFACE; i <= MEM_MUSIC; i++)
+    {
+        const MemCounter* c = &counters[i];
+        if (c->count == 0 && c->bytes == 0) continue;
+        std::cout << "leaked : " << names[i] << " " << (double)c->bytes / 1024.0 << " KB (" << c->count << ")" << std::endl;
+        leaked = true;
+    }
+    return leaked;
+}
@@ -0,0 +1,53 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <include/SDL.h>
+
+#include <include/lua.hpp>
+
+// what native memory is accounted for
+typedef enum MemCategory
+{
+	MEM_LUA,
+	MEM_SURFACE,
+	MEM_TEXTURE,
+	MEM_CHUNK,
+	// encoded music sources, which are streamed rather than decoded whole
+	MEM_MUSIC,
+	MEM_ARCHIVE,
+	MEM_CATEGORIES
+} MemCategory;
+
+typedef struct MemCounter
+{
+	Sint64 bytes, peak;
+	Sint64 count;
+} MemCounter;
+
+// account for objects of given category being created (positive) or freed (negative)
+void Mem_Track(MemCategory category, Sint64 bytes, Sint64 count);
+// get a category, the lua heap is read from L
+const MemCounter* Mem_Get(lua_State* L, MemCategory category);
+const char* Mem_Name(MemCategory category);
+
+// size of the pixels of a surface
+Sint64 Mem_SurfaceBytes(const SDL_Surface* surf);
+// estimated size of a texture in video memory
+Sint64 Mem_TextureBytes(SDL_Texture* tex);
+
+// print every category each interval seconds, 0 disables the log
+void Mem_SetLogInterval(double seconds);
+double Mem_GetLogInterval();
+// print the log if the interval elapsed, called once per frame
+void Mem_Frame(lua_State* L);
+void Mem_Log(lua_State* L);
+
+// also list the objects scripts never released when quitting
+void Mem_SetLeakReport(bool enabled);
+bool Mem_GetLeakReport();
+// print an object still alive at quit, when the leak report is enabled
+void Mem_ReportAlive(const char* type, const char* path, Sint64 bytes);
+// print the surfaces, textures, chunks and musics still accounted for once everything was freed
+// return wether there were any
+bool Mem_ReportLeaks();
+#endif
@@ -0,0 +1,829 @@
+#include <vector>
+#include <atomic>
+#include <cstring>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MIXER_X86
+#include <immintrin.h>
+#endif
+
+#include <include/SDL.h>
+
+#include "Mixer.hpp"
+#include "Ring.hpp"
+#include "Voice.hpp"
+#include "Group.hpp"
+
+// avx2 kernels are compiled alongside the others and only picked when the cpu has it
+#if defined(MIXER_X86) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+typedef enum CommandType
+{
+    CMD_PLAY,
+    CMD_HALT,
+    CMD_HALT_OWNER,
+    CMD_HALT_ALL,
+    CMD_HALT_GROUP,
+    CMD_UNGROUP,
+    CMD_PAUSE,
+    CMD_RESUME,
+    CMD_VOLUME
+} CommandType;
+
+typedef struct MixerCommand
+{
+    CommandType type;
+    // sequence number, acknowledged once the callback ran the command
+    Uint32 seq;
+    Uint32 id;
+    const void* owner;
+    int group;
+    const Uint8* samples;
+    Uint32 frames;
+    int loops;
+    float gains[2];
+} MixerCommand;
+
+// only touched by the callback
+typedef struct NativeVoice
+{
+    // 0 when free
+    Uint32 id;
+    const void* owner;
+    int group;
+    const Uint8* samples;
+    Uint32 frames, pos;
+    int loops;
+    float gains[2];
+    bool paused;
+} NativeVoice;
+
+// the game thread's view of the voices, ended ones are removed when the callback reports them
+typedef struct MirrorVoice
+{
+    Uint32 id;
+    const void* owner;
+    int group;
+    int priority;
+    Uint32 start;
+    bool paused;
+    // halted voices keep their slot and their samples until the callback ran halt
+    bool halted;
+    // the queue was full, the halt is sent again until it fits
+    bool unsent;
+    Uint32 halt;
+} MirrorVoice;
+
+// what the voices of owner played, freed once none of them is left in the callback
+typedef struct MixerRelease
+{
+    const void* owner;
+    AudioFree free;
+    void* data;
+} MixerRelease;
+
+// samples (not frames) and gains alternate left and right, mono uses the same gain twice
+typedef void (*MixKernel)(float* acc, const void* src, int samples, const float* gains);
+typedef void (*OutKernel)(void* stream, const float* acc, int samples);
+
+typedef struct MixerKernels
+{
+    MixKernel mixS16, mixF32;
+    OutKernel outS16, outF32;
+    const char* name;
+} MixerKernels;
+
+static std::atomic<bool> running(false);
+static Ring commands;
+// ids of the voices that ended by themselves, sent back by the callback
+static Ring ended;
+static std::atomic<Uint32> acked(0);
+
+// set before running, then only read by the callback
+static MixerKernels kernels;
+static bool isFloat = false;
+static int channels = 2;
+static int frameSize = 4;
+static float* acc = NULL;
+static NativeVoice slots[MIXER_VOICES];
+// group gains and pauses, read once per callback
+static float groupGains[GROUP_MAX];
+static bool groupPaused[GROUP_MAX];
+
+static std::vector<MirrorVoice> mirror;
+static std::vector<MixerRelease> releases;
+static Uint32 nextId = 1;
+static Uint32 sentSeq = 0;
+
+static SDL_SpinLock statsLock = 0;
+static double timeSum = 0.0, timeMax = 0.0;
+static Uint64 callbacks = 0;
+static MixerStats stats = { 0, 0, 0, 0, 0, 0.0, 0.0, "scalar" };
+
+#pragma region Kernels
+static void mixS16Scalar(float* acc, const void* src, int samples, const float* gains)
+{
+    const Sint16* s = (const Sint16*)src;
+    for (int i = 0; i < samples; i++)
+        acc[i] += (float)s[i] * gains[i & 1];
+}
+static void mixF32Scalar(float* acc, const void* src, int samples, const float* gains)
+{
+    const float* s = (const float*)src;
+    for (int i = 0; i < samples; i++)
+        acc[i] += s[i] * gains[i & 1];
+}
+static void outS16Scalar(void* stream, const float* acc, int samples)
+{
+    Sint16* out = (Sint16*)stream;
+    for (int i = 0; i < samples; i++)
+    {
+        float v = SDL_clamp((float)out[i] + acc[i], -32768.0f, 32767.0f);
+        out[i] = (Sint16)lrintf(v);
+    }
+}
+static void outF32Scalar(void* stream, const float* acc, int samples)
+{
+    float* out = (float*)stream;
+    for (int i = 0; i < samples; i++)
+        out[i] = SDL_clamp(out[i] + acc[i], -1.0f, 1.0f);
+}
+
+#ifdef MIXER_X86
+// sign extend 8 samples by unpacking each into the high half of a 32 bit lane
+static inline __m128 s16LowSSE2(__m128i v)
+{
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+static inline __m128 s16HighSSE2(__m128i v)
+{
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+
+static void mixS16SSE2(float* acc, const void* src, int samples, const float* gains)
+{
+    const Sint16* s = (const Sint16*)src;
+    __m128 g = _mm_setr_ps(gains[0], gains[1], gains[0], gains[1]);
+    int i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(s16LowSSE2(v), g)));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(s16HighSSE2(v), g)));
+    }
+    mixS16Scalar(acc + i, s + i, samples - i, gains);
+}
+static void mixF32SSE2(float* acc, const void* src, int samples, const float* gains)
+{
+    const float* s = (const float*)src;
+    __m128 g = _mm_setr_ps(gains[0], gains[1], gains[0], gains[1]);
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(s + i), g)));
+    mixF32Scalar(acc + i, s + i, samples - i, gains);
+}
+static void outS16SSE2(void* stream, const float* acc, int samples)
+{
+    Sint16* out = (Sint16*)stream;
+    __m128 lo = _mm_set1_ps(-32768.0f), hi = _mm_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(out + i));
+        __m128 a = _mm_add_ps(s16LowSSE2(v), _mm_loadu_ps(acc + i));
+        __m128 b = _mm_add_ps(s16HighSSE2(v), _mm_loadu_ps(acc + i + 4));
+        a = _mm_min_ps(_mm_max_ps(a, lo), hi);
+        b = _mm_min_ps(_mm_max_ps(b, lo), hi);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+    outS16Scalar(out + i, acc + i, samples - i);
+}
+static void outF32SSE2(void* stream, const float* acc, int samples)
+{
+    float* out = (float*)stream;
+    __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(acc + i));
+        _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(v, lo), hi));
+    }
+    outF32Scalar(out + i, acc + i, samples - i);
+}
+
+static TARGET_AVX2 void mixS16AVX2(float* acc, const void* src, int samples, const float* gains)
+{
+    const Sint16* s = (const Sint16*)src;
+    __m256 g = _mm256_setr_ps(gains[0], gains[1], gains[0], gains[1], gains[0], gains[1], gains[0], gains[1]);
+    int i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(s + i))));
+        __m256 b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(s + i + 8))));
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(a, g)));
+        _mm256_storeu_ps(acc + i + 8, _mm256_add_ps(_mm256_loadu_ps(acc + i + 8), _mm256_mul_ps(b, g)));
+    }
+    mixS16Scalar(acc + i, s + i, samples - i, gains);
+}
+static TARGET_AVX2 void mixF32AVX2(float* acc, const void* src, int samples, const float* gains)
+{
+    const float* s = (const float*)src;
+    __m256 g = _mm256_setr_ps(gains[0], gains[1], gains[0], gains[1], gains[0], gains[1], gains[0], gains[1]);
+    int i = 0;
+    for (; i + 8 <= samples; i += 8)
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(_mm256_loadu_ps(s + i), g)));
+    mixF32Scalar(acc + i, s + i, samples - i, gains);
+}
+static TARGET_AVX2 void outS16AVX2(void* stream, const float* acc, int samples)
+{
+    Sint16* out = (Sint16*)stream;
+    __m256 lo = _mm256_set1_ps(-32768.0f), hi = _mm256_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(out + i))));
+        __m256 b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(out + i + 8))));
+        a = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(a, _mm256_loadu_ps(acc + i)), lo), hi);
+        b = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(b, _mm256_loadu_ps(acc + i + 8)), lo), hi);
+        // packing works within 128 bit lanes, put the four halves back in order
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    outS16Scalar(out + i, acc + i, samples - i);
+}
+static TARGET_AVX2 void outF32AVX2(void* stream, const float* acc, int samples)
+{
+    float* out = (float*)stream;
+    __m256 lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256 v = _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(acc + i));
+        _mm256_storeu_ps(out + i, _mm256_min_ps(_mm256_max_ps(v, lo), hi));
+    }
+    outF32Scalar(out + i, acc + i, samples - i);
+}
+#endif
+
+static void selectKernels()
+{
+    MixerKernels scalar = { mixS16Scalar, mixF32Scalar, outS16Scalar, outF32Scalar, "scalar" };
+    kernels = scalar;
+#ifdef MIXER_X86
+    if (SDL_HasAVX2())
+    {
+        MixerKernels avx2 = { mixS16AVX2, mixF32AVX2, outS16AVX2, outF32AVX2, "avx2" };
+        kernels = avx2;
+    }
+    else if (SDL_HasSSE2())
+    {
+        MixerKernels sse2 = { mixS16SSE2, mixF32SSE2, outS16SSE2, outF32SSE2, "sse2" };
+        kernels = sse2;
+    }
+#endif
+}
+#pragma endregion
+
+#pragma region Callback
+static NativeVoice* findVoice(Uint32 id)
+{
+    for (int i = 0; i < MIXER_VOICES; i++)
+        if (slots[i].id == id) return &slots[i];
+    return NULL;
+}
+
+static void execute(const MixerCommand* cmd)
+{
+    switch (cmd->type)
+    {
+    case CMD_PLAY:
+    {
+        NativeVoice* v = findVoice(0);
+        if (v == NULL)
+        {
+            // the game thread never plays more than there are slots, but don't lose the voice
+            Ring_Write(&ended, &cmd->id, 1);
+            break;
+        }
+        v->id = cmd->id;
+        v->owner = cmd->owner;
+        v->group = cmd->group;
+        v->samples = cmd->samples;
+        v->frames = cmd->frames;
+        v->pos = 0;
+        v->loops = cmd->loops;
+        v->gains[0] = cmd->gains[0];
+        v->gains[1] = cmd->gains[1];
+        v->paused = false;
+        break;
+    }
+    case CMD_HALT:
+    {
+        NativeVoice* v = findVoice(cmd->id);
+        if (v != NULL) v->id = 0;
+        break;
+    }
+    case CMD_HALT_ALL:
+        for (int i = 0; i < MIXER_VOICES; i++)
+            slots[i].id = 0;
+        break;
+    case CMD_HALT_GROUP:
+        for (int i = 0; i < MIXER_VOICES; i++)
+            if (slots[i].group == cmd->group) slots[i].id = 0;
+        break;
+    case CMD_UNGROUP:
+        for (int i = 0; i < MIXER_VOICES; i++)
+            if (slots[i].group == cmd->group) slots[i].group = 0;
+        break;
+    default:
+        for (int i = 0; i < MIXER_VOICES; i++)
+        {
+            NativeVoice* v = &slots[i];
+            if (v->id == 0 || v->owner != cmd->owner) continue;
+
+            if (cmd->type == CMD_HALT_OWNER) v->id = 0;
+            else if (cmd->type == CMD_PAUSE) v->paused = true;
+            else if (cmd->type == CMD_RESUME) v->paused = false;
+            else if (cmd->type == CMD_VOLUME)
+            {
+                v->gains[0] = cmd->gains[0];
+                v->gains[1] = cmd->gains[1];
+            }
+        }
+        break;
+    }
+}
+
+static void mixVoice(NativeVoice* v, int frames)
+{
+    MixKernel mix = isFloat ? kernels.mixF32 : kernels.mixS16;
+    float gain = groupGains[v->group];
+    float gains[2] = { v->gains[0] * gain, v->gains[1] * gain };
+    // silent voices, like emitters out of hearing range or muted groups, only move forward
+    bool silent = gains[0] == 0.0f && gains[1] == 0.0f;
+    int at = 0;
+    while (at < frames)
+    {
+        Uint32 n = SDL_min((Uint32)(frames - at), v->frames - v->pos);
+        if (!silent)
+            mix(acc + at * channels, v->samples + v->pos * frameSize, (int)n * channels, gains);
+        v->pos += n;
+        at += n;
+        if (v->pos < v->frames) continue;
+
+        if (v->loops != 0)
+        {
+            if (v->loops > 0) v->loops--;
+            v->pos = 0;
+            continue;
+        }
+        Ring_Write(&ended, &v->id, 1);
+        v->id = 0;
+        break;
+    }
+}
+
+void Mixer_Process(Uint8* stream, int len)
+{
+    if (!running.load(std::memory_order_acquire)) return;
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    MixerCommand cmd;
+    Uint32 seq = acked.load(std::memory_order_relaxed);
+    while (Ring_Read(&commands, &cmd, 1) == 1)
+    {
+        execute(&cmd);
+        seq = cmd.seq;
+    }
+    acked.store(seq, std::memory_order_release);
+
+    // every voice of a group follows it in this one pass, however many there are
+    for (int g = 0; g < GROUP_MAX; g++)
+    {
+        groupGains[g] = Group_GetGain(g);
+        groupPaused[g] = Group_IsPaused(g);
+    }
+
+    int frames = len / frameSize;
+    OutKernel out = isFloat ? kernels.outF32 : kernels.outS16;
+    for (int done = 0; done < frames;)
+    {
+        int block = SDL_min(frames - done, MIXER_BLOCK);
+        memset(acc, 0, block * channels * sizeof(float));
+        for (int i = 0; i < MIXER_VOICES; i++)
+            if (slots[i].id != 0 && !slots[i].paused && !groupPaused[slots[i].group]) mixVoice(&slots[i], block);
+        out(stream + done * frameSize, acc, block * channels);
+        done += block;
+    }
+
+    double us = (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    SDL_AtomicLock(&statsLock);
+    timeSum += us;
+    if (us > timeMax) timeMax = us;
+    callbacks++;
+    SDL_AtomicUnlock(&statsLock);
+}
+#pragma endregion
+
+#pragma region Game thread
+static bool send(MixerCommand* cmd)
+{
+    cmd->seq = sentSeq + 1;
+    stats.commands++;
+    if (Ring_Write(&commands, cmd, 1) == 1)
+    {
+        sentSeq++;
+        return true;
+    }
+    stats.dropped++;
+    return false;
+}
+static bool isAcked(void* seq)
+{
+    return (Sint32)(acked.load(std::memory_order_acquire) - *(Uint32*)seq) >= 0;
+}
+static bool trySend(void* cmd)
+{
+    return send((MixerCommand*)cmd);
+}
+// wait for the callback to run every command up to seq
+// return false if it didn't in time, the command may still run later
+static bool waitFor(Uint32 seq)
+{
+    return Audio_Wait(isAcked, &seq);
+}
+// commands the callback must not miss wait for room instead of being dropped
+// return false if there was none in time, the command wasn't sent
+static bool sendWait(MixerCommand* cmd)
+{
+    return Audio_Wait(trySend, cmd);
+}
+
+// mark the voice halted by cmd, or to halt again if cmd couldn't be sent
+static void halt(MirrorVoice* v, const MixerCommand* cmd, bool sent)
+{
+    v->halted = true;
+    v->unsent = !sent;
+    v->halt = cmd->seq;
+}
+// wether the callback may still play samples of owner
+static bool holds(const void* owner)
+{
+    for (const MirrorVoice& v : mirror)
+        if (v.owner == owner && v.halted) return true;
+    return false;
+}
+static int countLive()
+{
+    int live = 0;
+    for (const MirrorVoice& v : mirror)
+        if (!v.halted) live++;
+    return live;
+}
+
+static void drainEnded()
+{
+    Uint32 ids[64];
+    size_t count;
+    while ((count = Ring_Read(&ended, ids, 64)) > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            for (size_t j = 0; j < mirror.size(); j++)
+            {
+                if (mirror[j].id != ids[i]) continue;
+                mirror[j] = mirror.back();
+                mirror.pop_back();
+                break;
+            }
+        }
+    }
+
+    Uint32 seq = acked.load(std::memory_order_acquire);
+    bool full = false;
+    for (size_t i = 0; i < mirror.size();)
+    {
+        MirrorVoice* v = &mirror[i];
+        if (v->halted && v->unsent && !full)
+        {
+            MixerCommand cmd = {};
+            cmd.type = CMD_HALT;
+            cmd.id = v->id;
+            full = !send(&cmd);
+            if (!full) halt(v, &cmd, true);
+        }
+        if (v->halted && !v->unsent && (Sint32)(seq - v->halt) >= 0)
+        {
+            mirror[i] = mirror.back();
+            mirror.pop_back();
+        }
+        else
+            i++;
+    }
+
+    for (size_t i = 0; i < releases.size();)
+    {
+        if (holds(releases[i].owner))
+        {
+            i++;
+            continue;
+        }
+        MixerRelease r = releases[i];
+        releases[i] = releases.back();
+        releases.pop_back();
+        r.free(r.data);
+    }
+}
+
+// the voices of owner are gone, or the callback won't run their halts before the mixer restarts
+static bool isReleased(void* owner)
+{
+    drainEnded();
+    return !holds(owner) || !running.load();
+}
+static void computeGains(float volume, float pan, float* gains)
+{
+    volume = SDL_clamp(volume, 0.0f, 1.0f);
+    pan = SDL_clamp(pan, -1.0f, 1.0f);
+    if (channels == 1)
+    {
+        gains[0] = gains[1] = volume;
+        return;
+    }
+    gains[0] = volume * SDL_min(1.0f, 1.0f - pan);
+    gains[1] = volume * SDL_min(1.0f, 1.0f + pan);
+}
+
+bool Mixer_Start(const AudioSpec* spec)
+{
+    if (running.load()) return true;
+    if (!Audio_IsOpen())
+    {
+        SDL_SetError("Audio device isn't open");
+        return false;
+    }
+    if ((spec->format != AUDIO_S16SYS && spec->format != AUDIO_F32SYS) || spec->channels < 1 || spec->channels > 2)
+    {
+        SDL_SetError("The native mixer only mixes s16 or f32, mono or stereo");
+        return false;
+    }
+
+    if (acc == NULL)
+    {
+        acc = (float*)SDL_SIMDAlloc(MIXER_BLOCK * 2 * sizeof(float));
+        if (acc == NULL || !Ring_Init(&commands, sizeof(MixerCommand), MIXER_COMMANDS) ||
+            !Ring_Init(&ended, sizeof(Uint32), MIXER_VOICES))
+        {
+            Mixer_Shutdown();
+            SDL_OutOfMemory();
+            return false;
+        }
+    }
+
+    selectKernels();
+    isFloat = spec->format == AUDIO_F32SYS;
+    channels = spec->channels;
+    frameSize = SDL_AUDIO_BITSIZE(spec->format) / 8 * channels;
+    // once stopped the callback no longer reads the commands nor plays any voice,
+    // unless it never ran the halts of the stop, which then run before anything is mixed
+    if (mirror.empty())
+    {
+        for (int i = 0; i < MIXER_VOICES; i++)
+            slots[i].id = 0;
+        Ring_Reset(&commands);
+        Ring_Reset(&ended);
+        acked.store(sentSeq);
+    }
+
+    stats.kernel = kernels.name;
+    running.store(true, std::memory_order_release);
+    return true;
+}
+void Mixer_Stop()
+{
+    if (!running.load()) return;
+    drainEnded();
+
+    MixerCommand cmd = {};
+    cmd.type = CMD_HALT_ALL;
+    bool sent = sendWait(&cmd);
+    for (MirrorVoice& v : mirror)
+        if (!v.halted || sent) halt(&v, &cmd, sent);
+    if (sent) waitFor(cmd.seq);
+
+    running.store(false, std::memory_order_release);
+    drainEnded();
+}
+bool Mixer_IsRunning()
+{
+    return running.load();
+}
+void Mixer_Shutdown()
+{
+    running.store(false);
+    // the device is closed, nothing reads the samples anymore
+    for (const MixerRelease& r : releases)
+        r.free(r.data);
+    releases.clear();
+    mirror.clear();
+    SDL_SIMDFree(acc);
+    acc = NULL;
+    Ring_Free(&commands);
+    Ring_Free(&ended);
+}
+
+bool Mixer_Play(const void* samples, Uint32 bytes, const void* owner, int group, int priority, int loops, float volume, float pan)
+{
+    if (!running.load() || bytes < (Uint32)frameSize) return false;
+    drainEnded();
+
+    // halted voices free their slot before the play runs
+    int limit = SDL_min(Voice_GetLimit(), MIXER_VOICES);
+    if (countLive() >= limit)
+    {
+        int victim = -1;
+        for (int i = 0; i < (int)mirror.size(); i++)
+        {
+            const MirrorVoice* v = &mirror[i];
+            if (v->halted || v->priority > priority) continue;
+            if (victim < 0 || v->priority < mirror[victim].priority ||
+                (v->priority == mirror[victim].priority && (Sint32)(v->start - mirror[victim].start) < 0))
+                victim = i;
+        }
+        if (victim < 0)
+        {
+            stats.drops++;
+            return false;
+        }
+
+        MixerCommand cmd = {};
+        cmd.type = CMD_HALT;
+        cmd.id = mirror[victim].id;
+        if (!send(&cmd)) return false;
+        halt(&mirror[victim], &cmd, true);
+        stats.steals++;
+    }
+
+    MixerCommand cmd = {};
+    cmd.type = CMD_PLAY;
+    cmd.id = nextId++;
+    if (nextId == 0) nextId = 1;
+    cmd.owner = owner;
+    cmd.group = SDL_clamp(group, 0, GROUP_MAX - 1);
+    cmd.samples = (const Uint8*)samples;
+    cmd.frames = bytes / frameSize;
+    cmd.loops = loops;
+    computeGains(volume, pan, cmd.gains);
+    if (!send(&cmd)) return false;
+
+    MirrorVoice v = { cmd.id, owner, cmd.group, priority, SDL_GetTicks(), false, false, false, 0 };
+    mirror.push_back(v);
+    return true;
+}
+
+static void sendOwner(CommandType type, const void* owner)
+{
+    if (!running.load()) return;
+    drainEnded();
+
+    bool any = false;
+    for (MirrorVoice& v : mirror)
+    {
+        if (v.owner != owner || v.halted) continue;
+        any = true;
+        if (type == CMD_PAUSE) v.paused = true;
+        else if (type == CMD_RESUME) v.paused = false;
+    }
+    if (!any) return;
+
+    MixerCommand cmd = {};
+    cmd.type = type;
+    cmd.owner = owner;
+    send(&cmd);
+}
+void Mixer_Halt(const void* owner)
+{
+    if (!running.load()) return;
+    drainEnded();
+
+    bool any = false;
+    for (const MirrorVoice& v : mirror)
+        if (v.owner == owner && !v.halted) any = true;
+    if (!any) return;
+
+    MixerCommand cmd = {};
+    cmd.type = CMD_HALT_OWNER;
+    cmd.owner = owner;
+    bool sent = sendWait(&cmd);
+    for (MirrorVoice& v : mirror)
+        if (v.owner == owner && !v.halted) halt(&v, &cmd, sent);
+}
+void Mixer_HaltGroup(int group)
+{
+    if (!running.load() || group <= 0 || group >= GROUP_MAX) return;
+    drainEnded();
+
+    bool any = false;
+    for (const MirrorVoice& v : mirror)
+        if (v.group == group && !v.halted) any = true;
+    if (!any) return;
+
+    MixerCommand cmd = {};
+    cmd.type = CMD_HALT_GROUP;
+    cmd.group = group;
+    bool sent = sendWait(&cmd);
+    for (MirrorVoice& v : mirror)
+        if (v.group == group && !v.halted) halt(&v, &cmd, sent);
+}
+void Mixer_Ungroup(int group)
+{
+    if (!running.load() || group <= 0 || group >= GROUP_MAX) return;
+    drainEnded();
+
+    bool any = false;
+    for (const MirrorVoice& v : mirror)
+        if (v.group == group && !v.halted) any = true;
+
+    MixerCommand cmd = {};
+    cmd.type = CMD_UNGROUP;
+    cmd.group = group;
+    bool sent = !any || sendWait(&cmd);
+    for (MirrorVoice& v : mirror)
+    {
+        if (v.group != group) continue;
+        // a voice left tagged would follow the next group given that id, it stops instead
+        if (!sent && !v.halted) halt(&v, &cmd, false);
+        v.group = 0;
+    }
+}
+void Mixer_Pause(const void* owner)
+{
+    sendOwner(CMD_PAUSE, owner);
+}
+void Mixer_Resume(const void* owner)
+{
+    sendOwner(CMD_RESUME, owner);
+}
+void Mixer_SetVolume(const void* owner, float volume, float pan)
+{
+    if (!running.load()) return;
+    drainEnded();
+
+    for (const MirrorVoice& v : mirror)
+    {
+        if (v.owner != owner || v.halted) continue;
+
+        MixerCommand cmd = {};
+        cmd.type = CMD_VOLUME;
+        cmd.owner = owner;
+        computeGains(volume, pan, cmd.gains);
+        send(&cmd);
+        return;
+    }
+}
+bool Mixer_IsPlaying(const void* owner)
+{
+    drainEnded();
+    for (const MirrorVoice& v : mirror)
+        if (v.owner == owner && !v.halted) return true;
+    return false;
+}
+bool Mixer_IsPaused(const void* owner)
+{
+    drainEnded();
+    for (const MirrorVoice& v : mirror)
+        if (v.owner == owner && !v.halted && v.paused) return true;
+    return false;
+}
+void Mixer_Release(const void* owner, AudioFree free, void* data)
+{
+    Mixer_Halt(owner);
+
+    // the callback may still be reading the samples until it ran the halts
+    Audio_Wait(isReleased, (void*)owner);
+    if (holds(owner))
+    {
+        MixerRelease r = { owner, free, data };
+        releases.push_back(r);
+    }
+    else
+        free(data);
+}
+
+const MixerStats* Mixer_GetStats()
+{
+    drainEnded();
+    stats.voices = countLive();
+
+    SDL_AtomicLock(&statsLock);
+    stats.callbackTime = (callbacks > 0) ? timeSum / (double)callbacks : 0.0;
+    stats.maxCallbackTime = timeMax;
+    SDL_AtomicUnlock(&statsLock);
+    return &stats;
+}
+#pragma endregion
@@ -0,0 +1,64 @@
+#ifndef MIXER_HPP
+#define MIXER_HPP
+
+#include <include/SDL.h>
+
+#include "Audio.hpp"
+
+// voices the native mixer can play at once
+#define MIXER_VOICES 256
+// commands sent from the game thread that can wait for the next callback
+#define MIXER_COMMANDS 1024
+// frames mixed at a time, callbacks with more are split
+#define MIXER_BLOCK 1024
+
+typedef struct MixerStats
+{
+	// voices playing as last seen from the game thread
+	int voices;
+	// commands sent, and dropped because the queue was full
+	Uint64 commands, dropped;
+	// voices taken from another sound, and plays dropped for lack of a voice
+	Uint64 steals, drops;
+	// average and longest time spent mixing in a callback, in microseconds
+	double callbackTime, maxCallbackTime;
+	// "avx2", "sse2" or "scalar"
+	const char* kernel;
+} MixerStats;
+
+// mix voices in the audio callback instead of through SDL_mixer channels
+// the device must be s16 or f32, mono or stereo
+// return false if the device isn't open or its format can't be mixed
+bool Mixer_Start(const AudioSpec* spec);
+// stop every voice, waiting for the callback to let go of their samples
+// if it doesn't in time, the halts run first when the mixer starts again
+void Mixer_Stop();
+bool Mixer_IsRunning();
+// free the buffers and what waited on the callback to be released, after the device was closed
+void Mixer_Shutdown();
+// called from the audio callback, adds the voices to stream
+void Mixer_Process(Uint8* stream, int len);
+
+// play samples in the device format, owner is what the voice is looked up by afterwards
+// the voice follows the gain and pause state of group
+// past the voice limit, the voice with the lowest priority, then the oldest, is stolen
+// if it has a priority no higher than the new one
+// volume is from 0 to 1, pan from -1 (left) to 1 (right)
+// return false if the play was dropped
+bool Mixer_Play(const void* samples, Uint32 bytes, const void* owner, int group, int priority, int loops, float volume, float pan);
+void Mixer_Halt(const void* owner);
+void Mixer_HaltGroup(int group);
+// the voices of group play as if they were in none, before its id is reused
+// they are halted if the callback doesn't take the change in time
+void Mixer_Ungroup(int group);
+void Mixer_Pause(const void* owner);
+void Mixer_Resume(const void* owner);
+void Mixer_SetVolume(const void* owner, float volume, float pan);
+bool Mixer_IsPlaying(const void* owner);
+bool Mixer_IsPaused(const void* owner);
+// halt the voices of owner, then free what they played with free(data) once the callback let go of it
+// if it doesn't in time, data is freed by a later call instead, or once the mixer is shut down
+void Mixer_Release(const void* owner, AudioFree free, void* data);
+
+const MixerStats* Mixer_GetStats();
+#endif
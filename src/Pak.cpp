@@ -0,0 +1,292 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <climits>
+
+#include <include/SDL.h>
+
+#include "Pak.hpp"
+#include "Memory.hpp"
+
+#pragma region Archive
+bool Pak_Open(Pak* pak, const char* path)
+{
+    pak->header = NULL;
+    pak->entries = NULL;
+    pak->names = NULL;
+    if (!MapFile(&pak->map, path)) return false;
+
+    const Uint8* base = (const Uint8*)pak->map.data;
+    size_t size = pak->map.size;
+    const PakHeader* header = (const PakHeader*)base;
+
+    if (size < sizeof(PakHeader) || memcmp(header->magic, PAK_MAGIC, 4) != 0 || header->version != PAK_VERSION)
+    {
+        Pak_Close(pak);
+        SDL_SetError("%s is not a valid pak archive", path);
+        return false;
+    }
+    if (header->indexOffset > size
+        || (size - header->indexOffset) / sizeof(PakEntry) < header->count
+        || header->namesOffset > size)
+    {
+        Pak_Close(pak);
+        SDL_SetError("%s has a corrupted index", path);
+        return false;
+    }
+
+    const PakEntry* entries = (const PakEntry*)(base + header->indexOffset);
+    const char* names = (const char*)(base + header->namesOffset);
+    size_t namesSize = size - header->namesOffset;
+    for (Uint32 i = 0; i < header->count; i++)
+    {
+        const PakEntry* e = &entries[i];
+        // Pak_Find compares names with strcmp, each must end inside the mapping, where its length says
+        const char* name = names + e->nameOffset;
+        if (e->offset > size || e->size > size - e->offset
+            || e->nameOffset >= namesSize || e->nameLength >= namesSize - e->nameOffset
+            || name[e->nameLength] != '\0' || memchr(name, '\0', e->nameLength) != NULL)
+        {
+            Pak_Close(pak);
+            SDL_SetError("%s has a corrupted entry", path);
+            return false;
+        }
+        // and binary searches them, a name out of order would hide others
+        if (i > 0 && strcmp(names + entries[i - 1].nameOffset, name) >= 0)
+        {
+            Pak_Close(pak);
+            SDL_SetError("%s has an unsorted index", path);
+            return false;
+        }
+    }
+
+    pak->header = header;
+    pak->entries = entries;
+    pak->names = names;
+    Mem_Track(MEM_ARCHIVE, (Sint64)size, 1);
+    return true;
+}
+void Pak_Close(Pak* pak)
+{
+    if (pak->header != NULL)
+        Mem_Track(MEM_ARCHIVE, -(Sint64)pak->map.size, -1);
+    UnmapFile(&pak->map);
+    pak->header = NULL;
+    pak->entries = NULL;
+    pak->names = NULL;
+}
+const PakEntry* Pak_Find(const Pak* pak, const char* name)
+{
+    if (pak->header == NULL) return NULL;
+
+    Uint32 lo = 0, hi = pak->header->count;
+    while (lo < hi)
+    {
+        Uint32 mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(name, Pak_EntryName(pak, &pak->entries[mid]));
+        if (cmp == 0)
+            return &pak->entries[mid];
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return NULL;
+}
+#pragma endregion
+
+#pragma region Packer
+static void writePadding(std::ofstream& out, Uint64 alignment)
+{
+    static const char zeros[PAK_ALIGN] = { 0 };
+    Uint64 pos = (Uint64)out.tellp();
+    Uint64 pad = (alignment - pos % alignment) % alignment;
+    out.write(zeros, (std::streamsize)pad);
+}
+
+bool Pak_Write(const char* out, std::vector<PakInput>& inputs)
+{
+    // the loader binary searches the index with strcmp
+    std::sort(inputs.begin(), inputs.end(), [](const PakInput& a, const PakInput& b) {
+        return strcmp(a.name.c_str(), b.name.c_str()) < 0;
+    });
+
+    std::ofstream file(out, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Can't create " << out << std::endl;
+        return false;
+    }
+
+    PakHeader header = {};
+    memcpy(header.magic, PAK_MAGIC, 4);
+    header.version = PAK_VERSION;
+    header.count = (Uint32)inputs.size();
+    file.write((const char*)&header, sizeof(header));
+
+    std::vector<PakEntry> entries(inputs.size());
+    std::vector<char> buffer(1 << 16);
+    Uint32 nameOffset = 0;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        const PakInput& input = inputs[i];
+        writePadding(file, PAK_ALIGN);
+
+        PakEntry* e = &entries[i];
+        e->offset = (Uint64)file.tellp();
+        e->mtime = input.mtime;
+        e->nameOffset = nameOffset;
+        e->nameLength = (Uint32)input.name.size();
+        nameOffset += e->nameLength + 1;
+
+        if (input.path.empty())
+        {
+            file.write(input.data.data(), (std::streamsize)input.data.size());
+        }
+        else
+        {
+            std::ifstream in(input.path, std::ios::binary);
+            if (!in)
+            {
+                std::cout << "Can't read " << input.path << std::endl;
+                return false;
+            }
+            while (in)
+            {
+                in.read(buffer.data(), (std::streamsize)buffer.size());
+                file.write(buffer.data(), in.gcount());
+            }
+        }
+        e->size = (Uint64)file.tellp() - e->offset;
+    }
+
+    writePadding(file, sizeof(Uint64));
+    header.indexOffset = (Uint64)file.tellp();
+    if (!entries.empty())
+        file.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(PakEntry)));
+
+    header.namesOffset = (Uint64)file.tellp();
+    for (const PakInput& input : inputs)
+        file.write(input.name.c_str(), (std::streamsize)input.name.size() + 1);
+
+    file.seekp(0);
+    file.write((const char*)&header, sizeof(header));
+    if (!file)
+    {
+        std::cout << "Can't write " << out << std::endl;
+        return false;
+    }
+
+    std::cout << "packed " << inputs.size() << " files into " << out << std::endl;
+    return true;
+}
+
+bool Pak_List(const char* root, const char* ext, std::vector<PakInput>& inputs)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    size_t extLength = (ext != NULL) ? strlen(ext) : 0;
+
+    for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec))
+    {
+        if (!it->is_regular_file()) continue;
+
+        PakInput input;
+        input.path = it->path().string();
+        input.name = it->path().lexically_relative(root).generic_string();
+        if (ext != NULL && (input.name.size() < extLength
+            || input.name.compare(input.name.size() - extLength, extLength, ext) != 0))
+            continue;
+        input.mtime = FileModTime(input.path.c_str());
+        inputs.push_back(input);
+    }
+    if (ec)
+    {
+        std::cout << "Can't list " << root << " :\n" << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Pak_Build(const char* out, const char* root)
+{
+    std::vector<PakInput> inputs;
+    if (!Pak_List(root, NULL, inputs)) return false;
+    return Pak_Write(out, inputs);
+}
+#pragma endregion
+
+#pragma region Mount
+// mounted archives, searched from the last one
+static std::vector<Pak*> mounted;
+
+bool Pak_Mount(const char* path)
+{
+    Pak* pak = new Pak;
+    if (!Pak_Open(pak, path))
+    {
+        delete pak;
+        return false;
+    }
+    mounted.push_back(pak);
+    return true;
+}
+void Pak_UnmountAll()
+{
+    for (Pak* pak : mounted)
+    {
+        Pak_Close(pak);
+        delete pak;
+    }
+    mounted.clear();
+}
+const void* Pak_Lookup(const char* name, size_t* size, Sint64* mtime)
+{
+    for (size_t i = mounted.size(); i-- > 0;)
+    {
+        const PakEntry* e = Pak_Find(mounted[i], name);
+        if (e == NULL) continue;
+
+        if (size != NULL) *size = (size_t)e->size;
+        if (mtime != NULL) *mtime = e->mtime;
+        return Pak_EntryData(mounted[i], e);
+    }
+    return NULL;
+}
+
+SDL_RWops* OpenAsset(const char* path)
+{
+    size_t schemeLen = sizeof(PAK_SCHEME) - 1;
+    if (strncmp(path, PAK_SCHEME, schemeLen) != 0)
+        return SDL_RWFromFile(path, "rb");
+
+    size_t size;
+    const void* data = Pak_Lookup(path + schemeLen, &size, NULL);
+    if (data == NULL)
+    {
+        SDL_SetError("%s not found in mounted archives", path);
+        return NULL;
+    }
+    // SDL_RWops take an int size
+    if (size > INT_MAX)
+    {
+        SDL_SetError("%s is too big to be opened from an archive", path);
+        return NULL;
+    }
+    return SDL_RWFromConstMem(data, (int)size);
+}
+Sint64 AssetModTime(const char* path)
+{
+    size_t schemeLen = sizeof(PAK_SCHEME) - 1;
+    if (strncmp(path, PAK_SCHEME, schemeLen) != 0)
+        return FileModTime(path);
+
+    Sint64 mtime;
+    if (Pak_Lookup(path + schemeLen, NULL, &mtime) == NULL) return -1;
+    return mtime;
+}
+#pragma endregion
@@ -0,0 +1,95 @@
+#ifndef PAK_HPP
+#define PAK_HPP
+
+#include <string>
+#include <vector>
+
+#include <include/SDL.h>
+
+#include "FileMap.hpp"
+
+#define PAK_MAGIC "LPAK"
+#define PAK_VERSION 1
+// every entry starts on this boundary in the archive
+#define PAK_ALIGN 64
+// prefix of asset paths served from mounted archives
+#define PAK_SCHEME "pak://"
+
+// .pak layout (little-endian) :
+//   PakHeader
+//   entries data, each aligned to PAK_ALIGN
+//   PakEntry[count], sorted by name
+//   names, NUL-terminated
+typedef struct PakHeader
+{
+	char magic[4];
+	Uint32 version;
+	Uint32 count;
+	Uint32 reserved;
+	Uint64 indexOffset;
+	Uint64 namesOffset;
+} PakHeader;
+typedef struct PakEntry
+{
+	Uint64 offset;
+	Uint64 size;
+	Sint64 mtime;
+	Uint32 nameOffset;
+	Uint32 nameLength;
+} PakEntry;
+
+typedef struct Pak
+{
+	MappedFile map;
+	const PakHeader* header;
+	const PakEntry* entries;
+	const char* names;
+} Pak;
+
+// map an archive in memory and validate its header and index, whose names must be sorted and
+// NUL-terminated where their length says
+// return false and set the SDL error on failure
+bool Pak_Open(Pak* pak, const char* path);
+void Pak_Close(Pak* pak);
+// binary search the index for given name, return NULL if absent
+const PakEntry* Pak_Find(const Pak* pak, const char* name);
+static inline const char* Pak_EntryName(const Pak* pak, const PakEntry* e)
+{
+	return pak->names + e->nameOffset;
+}
+static inline const void* Pak_EntryData(const Pak* pak, const PakEntry* e)
+{
+	return (const Uint8*)pak->map.data + e->offset;
+}
+
+// an entry to pack, read from path or taken from data when path is empty
+typedef struct PakInput
+{
+	std::string name;
+	std::string path;
+	std::string data;
+	Sint64 mtime;
+} PakInput;
+
+// write inputs into out, sorting them by name
+// return false on failure
+bool Pak_Write(const char* out, std::vector<PakInput>& inputs);
+// list the files under root ending with ext (NULL for every file), named by their path relative to root
+bool Pak_List(const char* root, const char* ext, std::vector<PakInput>& inputs);
+// pack every file under root into out
+// return false on failure
+bool Pak_Build(const char* out, const char* root);
+
+// mount an archive so its entries can be opened with PAK_SCHEME paths
+bool Pak_Mount(const char* path);
+// unmap every mounted archive
+void Pak_UnmountAll();
+// find an entry in the mounted archives, latest mounted first
+const void* Pak_Lookup(const char* name, size_t* size, Sint64* mtime);
+
+// open an asset for reading, from a mounted archive if path starts with PAK_SCHEME
+// archive entries are served straight from the mapping, without copy
+SDL_RWops* OpenAsset(const char* path);
+// return the modification time of an asset, or -1 if it doesn't exist
+Sint64 AssetModTime(const char* path);
+#endif
@@ -0,0 +1,352 @@
+#include <vector>
+#include <atomic>
+
+#include <include/SDL.h>
+
+#include "Pipeline.hpp"
+
+typedef struct PipeFrame
+{
+    std::vector<PipeCommand> commands;
+    // what the commands drawing many read from
+    std::vector<Uint8> data;
+    Uint64 start;
+} PipeFrame;
+
+// recorded into by the game thread while the render thread replays the other
+static PipeFrame frames[2];
+static int recording = 0;
+// frame waiting for the render thread, -1 when none
+static std::atomic<int> pending(-1);
+
+static SDL_Thread* thread = NULL;
+static SDL_threadID threadId = 0;
+static Uint32 windowId = 0;
+static SDL_Renderer* owned = NULL;
+static std::atomic<bool> running(false);
+static std::atomic<bool> quitting(false);
+// wakes the render thread for a frame or a task
+static SDL_sem* wake = NULL;
+// held by the frame in flight, given back once it is presented
+static SDL_sem* idle = NULL;
+static SDL_sem* taskDone = NULL;
+
+typedef struct PipeTask
+{
+    void (*fn)(void* data);
+    void* data;
+} PipeTask;
+static std::atomic<PipeTask*> task(NULL);
+
+// the draw color the script last set, recorded frames replay it
+static Uint8 color[4] = { 0, 0, 0, 255 };
+
+static SDL_SpinLock statsLock = 0;
+static double frameSum = 0.0, renderSum = 0.0, waitSum = 0.0, latencySum = 0.0;
+static Uint64 presented = 0;
+// frames may be skipped, the frame time counts every frame begun
+static Uint64 intervals = 0;
+static Uint64 lastFrame = 0;
+static PipelineStats stats = { false, 0, 0.0, 0.0, 0.0, 0.0 };
+
+typedef struct StartArgs
+{
+    SDL_Window* window;
+    Uint32 flags;
+} StartArgs;
+
+static double elapsed(Uint64 from, Uint64 to)
+{
+    return (double)(to - from) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// SDL_Point and SDL_Rect are laid out as the ints, SDL_FPoint and SDL_FRect as the floats
+static void executeMany(SDL_Renderer* renderer, PipeCommandType type, const void* data, bool floats, int count)
+{
+    if (type == PIPE_POINT)
+        floats ? SDL_RenderDrawPointsF(renderer, (const SDL_FPoint*)data, count) : SDL_RenderDrawPoints(renderer, (const SDL_Point*)data, count);
+    else if (type == PIPE_RECT)
+        floats ? SDL_RenderDrawRectsF(renderer, (const SDL_FRect*)data, count) : SDL_RenderDrawRects(renderer, (const SDL_Rect*)data, count);
+    else if (type == PIPE_FILL)
+        floats ? SDL_RenderFillRectsF(renderer, (const SDL_FRect*)data, count) : SDL_RenderFillRects(renderer, (const SDL_Rect*)data, count);
+}
+static void execute(SDL_Renderer* renderer, const PipeCommand* cmd, const Uint8* data)
+{
+    if (cmd->count > 0)
+    {
+        executeMany(renderer, cmd->type, data + cmd->offset, cmd->floats, cmd->count);
+        return;
+    }
+    switch (cmd->type)
+    {
+    case PIPE_COLOR:
+        SDL_SetRenderDrawColor(renderer, cmd->r, cmd->g, cmd->b, cmd->a);
+        break;
+    case PIPE_CLEAR:
+        SDL_RenderClear(renderer);
+        break;
+    case PIPE_POINT:
+        SDL_RenderDrawPoint(renderer, cmd->rect.x, cmd->rect.y);
+        break;
+    case PIPE_RECT:
+        SDL_RenderDrawRect(renderer, &cmd->rect);
+        break;
+    case PIPE_FILL:
+        SDL_RenderFillRect(renderer, &cmd->rect);
+        break;
+    case PIPE_COPY:
+        if (cmd->tex != NULL) SDL_RenderCopy(renderer, cmd->tex, NULL, &cmd->rect);
+        break;
+    }
+}
+
+static int SDLCALL render(void* data)
+{
+    StartArgs* args = (StartArgs*)data;
+    threadId = SDL_ThreadID();
+    owned = SDL_CreateRenderer(args->window, -1, args->flags);
+    // no task can be waiting yet, taskDone tells the renderer was created
+    SDL_SemPost(taskDone);
+    if (owned == NULL) return 1;
+
+    while (true)
+    {
+        SDL_SemWait(wake);
+
+        PipeTask* t = task.exchange(NULL, std::memory_order_acquire);
+        if (t != NULL)
+        {
+            t->fn(t->data);
+            SDL_SemPost(taskDone);
+            continue;
+        }
+        if (quitting.load(std::memory_order_acquire)) break;
+
+        int index = pending.exchange(-1, std::memory_order_acquire);
+        if (index < 0) continue;
+
+        PipeFrame* frame = &frames[index];
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (const PipeCommand& cmd : frame->commands)
+            execute(owned, &cmd, frame->data.data());
+        SDL_RenderPresent(owned);
+        Uint64 end = SDL_GetPerformanceCounter();
+
+        SDL_AtomicLock(&statsLock);
+        renderSum += elapsed(start, end);
+        latencySum += elapsed(frame->start, end);
+        presented++;
+        SDL_AtomicUnlock(&statsLock);
+        SDL_SemPost(idle);
+    }
+
+    SDL_DestroyRenderer(owned);
+    owned = NULL;
+    return 0;
+}
+
+// SDL's renderer watches the events on the thread that polls them, and updates itself there
+// when the window changes : the render thread must be done with the frame in flight first
+// no frame can be handed over until the poll returns, mouse events only read the viewport
+// and scale, which no recorded command changes
+static int SDLCALL windowWatch(void*, SDL_Event* event)
+{
+    if (event->type == SDL_WINDOWEVENT && event->window.windowID == windowId &&
+        running.load() && SDL_ThreadID() != threadId)
+        Pipeline_Wait();
+    return 0;
+}
+
+SDL_Renderer* Pipeline_Start(SDL_Window* window, Uint32 flags)
+{
+    if (running.load()) return owned;
+
+    // added before the renderer's own, watches run in that order
+    windowId = SDL_GetWindowID(window);
+    SDL_AddEventWatch(windowWatch, NULL);
+
+    wake = SDL_CreateSemaphore(0);
+    idle = SDL_CreateSemaphore(1);
+    taskDone = SDL_CreateSemaphore(0);
+    StartArgs args = { window, flags };
+    if (wake == NULL || idle == NULL || taskDone == NULL ||
+        (thread = SDL_CreateThread(render, "render", &args)) == NULL)
+    {
+        Pipeline_Stop();
+        return NULL;
+    }
+
+    SDL_SemWait(taskDone);
+    if (owned == NULL)
+    {
+        SDL_WaitThread(thread, NULL);
+        thread = NULL;
+        Pipeline_Stop();
+        return NULL;
+    }
+
+    for (PipeFrame& frame : frames)
+    {
+        frame.commands.clear();
+        frame.data.clear();
+    }
+    recording = 0;
+    quitting.store(false);
+    stats.pipelined = true;
+    running.store(true);
+    return owned;
+}
+void Pipeline_Stop()
+{
+    if (running.load())
+    {
+        Pipeline_Wait();
+        running.store(false);
+        quitting.store(true, std::memory_order_release);
+        SDL_SemPost(wake);
+        SDL_WaitThread(thread, NULL);
+        thread = NULL;
+        stats.pipelined = false;
+    }
+    SDL_DelEventWatch(windowWatch, NULL);
+    if (wake != NULL) SDL_DestroySemaphore(wake);
+    if (idle != NULL) SDL_DestroySemaphore(idle);
+    if (taskDone != NULL) SDL_DestroySemaphore(taskDone);
+    wake = idle = taskDone = NULL;
+}
+bool Pipeline_IsRunning()
+{
+    return running.load();
+}
+
+void Pipeline_Invoke(void (*fn)(void* data), void* data)
+{
+    if (!running.load() || SDL_ThreadID() == threadId)
+    {
+        fn(data);
+        return;
+    }
+
+    // the render thread takes tasks once the frame in flight is presented
+    PipeTask t = { fn, data };
+    SDL_SemWait(idle);
+    task.store(&t, std::memory_order_release);
+    SDL_SemPost(wake);
+    SDL_SemWait(taskDone);
+    SDL_SemPost(idle);
+}
+void Pipeline_Wait()
+{
+    if (!running.load()) return;
+    SDL_SemWait(idle);
+    SDL_SemPost(idle);
+}
+void Pipeline_Forget(SDL_Texture* tex)
+{
+    if (!running.load()) return;
+    for (PipeCommand& cmd : frames[recording].commands)
+        if (cmd.type == PIPE_COPY && cmd.tex == tex) cmd.tex = NULL;
+}
+
+void Pipeline_Draw(SDL_Renderer* renderer, const PipeCommand* cmd)
+{
+    if (cmd->type == PIPE_COLOR)
+    {
+        color[0] = cmd->r;
+        color[1] = cmd->g;
+        color[2] = cmd->b;
+        color[3] = cmd->a;
+    }
+    if (running.load(std::memory_order_relaxed))
+        frames[recording].commands.push_back(*cmd);
+    else
+        execute(renderer, cmd, NULL);
+}
+void Pipeline_DrawMany(SDL_Renderer* renderer, PipeCommandType type, const void* data, bool floats, int count)
+{
+    if (count <= 0) return;
+    if (!running.load(std::memory_order_relaxed))
+    {
+        executeMany(renderer, type, data, floats, count);
+        return;
+    }
+
+    // the script may change the array before the frame is replayed
+    PipeFrame* frame = &frames[recording];
+    size_t size = (size_t)count * ((type == PIPE_POINT) ? 2 : 4) * sizeof(float);
+    PipeCommand cmd = {};
+    cmd.type = type;
+    cmd.count = count;
+    cmd.floats = floats;
+    cmd.offset = frame->data.size();
+    frame->data.insert(frame->data.end(), (const Uint8*)data, (const Uint8*)data + size);
+    frame->commands.push_back(cmd);
+}
+void Pipeline_GetColor(SDL_Renderer* renderer, Uint8* r, Uint8* g, Uint8* b, Uint8* a)
+{
+    if (!running.load(std::memory_order_relaxed))
+    {
+        SDL_GetRenderDrawColor(renderer, r, g, b, a);
+        return;
+    }
+    *r = color[0];
+    *g = color[1];
+    *b = color[2];
+    *a = color[3];
+}
+void Pipeline_BeginFrame()
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    frames[recording].start = now;
+    if (lastFrame != 0)
+    {
+        SDL_AtomicLock(&statsLock);
+        frameSum += elapsed(lastFrame, now);
+        intervals++;
+        SDL_AtomicUnlock(&statsLock);
+    }
+    lastFrame = now;
+}
+void Pipeline_Present(SDL_Renderer* renderer)
+{
+    if (!running.load(std::memory_order_relaxed))
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        SDL_RenderPresent(renderer);
+        Uint64 end = SDL_GetPerformanceCounter();
+
+        SDL_AtomicLock(&statsLock);
+        renderSum += elapsed(start, end);
+        latencySum += elapsed(frames[recording].start, end);
+        presented++;
+        SDL_AtomicUnlock(&statsLock);
+        return;
+    }
+
+    // the previous frame must be presented before its buffer is recorded into again
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_SemWait(idle);
+    double waited = elapsed(start, SDL_GetPerformanceCounter());
+
+    pending.store(recording, std::memory_order_release);
+    recording ^= 1;
+    frames[recording].commands.clear();
+    frames[recording].data.clear();
+    SDL_SemPost(wake);
+
+    SDL_AtomicLock(&statsLock);
+    waitSum += waited;
+    SDL_AtomicUnlock(&statsLock);
+}
+
+const PipelineStats* Pipeline_GetStats()
+{
+    SDL_AtomicLock(&statsLock);
+    stats.frames = presented;
+    stats.frameTime = (intervals > 0) ? frameSum / (double)intervals : 0.0;
+    stats.renderTime = (presented > 0) ? renderSum / (double)presented : 0.0;
+    stats.waitTime = (presented > 0) ? waitSum / (double)presented : 0.0;
+    stats.latency = (presented > 0) ? latencySum / (double)presented : 0.0;
+    SDL_AtomicUnlock(&statsLock);
+    return &stats;
+}
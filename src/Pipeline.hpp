@@ -0,0 +1,73 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <include/SDL.h>
+
+typedef enum PipeCommandType
+{
+	PIPE_COLOR,
+	PIPE_CLEAR,
+	PIPE_POINT,
+	PIPE_RECT,
+	PIPE_FILL,
+	PIPE_COPY
+} PipeCommandType;
+
+typedef struct PipeCommand
+{
+	PipeCommandType type;
+	// PIPE_COLOR
+	Uint8 r, g, b, a;
+	// PIPE_POINT uses x and y
+	SDL_Rect rect;
+	// PIPE_COPY, NULL draws nothing
+	SDL_Texture* tex;
+	// PIPE_POINT, PIPE_RECT and PIPE_FILL recorded by Pipeline_DrawMany : count of them, of floats
+	// or ints, copied in the frame at offset, 0 draws rect alone
+	int count;
+	bool floats;
+	size_t offset;
+} PipeCommand;
+
+typedef struct PipelineStats
+{
+	bool pipelined;
+	Uint64 frames;
+	// average time between two frames, spent replaying and presenting,
+	// and spent by the game thread waiting for the render thread, in milliseconds
+	double frameTime, renderTime, waitTime;
+	// average time from the start of a frame to the end of its present, in milliseconds
+	double latency;
+} PipelineStats;
+
+// create the renderer of window on a render thread that owns it from now on
+// window events polled afterwards wait for the frame in flight, SDL updates the renderer on them
+// return the renderer, or NULL if it or the thread can't be created
+SDL_Renderer* Pipeline_Start(SDL_Window* window, Uint32 flags);
+// wait for the frame in flight, destroy the renderer and join the thread
+void Pipeline_Stop();
+bool Pipeline_IsRunning();
+
+// run fn on the thread that owns the renderer and wait for it,
+// once the frame in flight is done, or right away without a render thread
+void Pipeline_Invoke(void (*fn)(void* data), void* data);
+// wait for the frame in flight to be presented
+void Pipeline_Wait();
+// drop the recorded commands drawing tex, before it is destroyed
+void Pipeline_Forget(SDL_Texture* tex);
+
+// record cmd for the render thread, or run it right away without one
+void Pipeline_Draw(SDL_Renderer* renderer, const PipeCommand* cmd);
+// draw count points (x, y) for PIPE_POINT, or rects (x, y, w, h) for PIPE_RECT and PIPE_FILL,
+// of ints or floats, straight from data without a render thread or recorded as a copy with it
+void Pipeline_DrawMany(SDL_Renderer* renderer, PipeCommandType type, const void* data, bool floats, int count);
+// the draw color as last set, recorded or not
+void Pipeline_GetColor(SDL_Renderer* renderer, Uint8* r, Uint8* g, Uint8* b, Uint8* a);
+// mark the start of a frame, for the statistics
+void Pipeline_BeginFrame();
+// hand the recorded frame to the render thread and start recording the next one,
+// or present right away without a render thread
+void Pipeline_Present(SDL_Renderer* renderer);
+
+const PipelineStats* Pipeline_GetStats();
+#endif
@@ -0,0 +1,198 @@
+#include <cstdlib>
+#include <cstring>
+
+#include <include/SDL.h>
+
+#include "Pool.hpp"
+
+typedef struct FreeBlock
+{
+    struct FreeBlock* next;
+} FreeBlock;
+typedef struct Slab
+{
+    struct Slab* next;
+} Slab;
+
+typedef struct Pool
+{
+    FreeBlock* free[POOL_CLASSES];
+    Slab* slabs;
+    // unused end of the last slab
+    Uint8* cursor;
+    size_t left;
+    AllocStats stats;
+} Pool;
+
+static thread_local Pool pool = {};
+
+// the slab header is padded so blocks stay aligned on POOL_GRANULE
+static const size_t slabHeader = (sizeof(Slab) + POOL_GRANULE - 1) & ~(size_t)(POOL_GRANULE - 1);
+
+static inline size_t sizeClass(size_t size)
+{
+    return (size - 1) / POOL_GRANULE;
+}
+
+static void* allocSmall(size_t size)
+{
+    size_t c = sizeClass(size);
+    FreeBlock* block = pool.free[c];
+    if (block != NULL)
+    {
+        pool.free[c] = block->next;
+        return block;
+    }
+
+    size_t blockSize = (c + 1) * POOL_GRANULE;
+    if (pool.left < blockSize)
+    {
+        // the rest of the current slab is dropped, at most POOL_MAX_SMALL bytes
+        Slab* slab = (Slab*)malloc(POOL_SLAB_SIZE);
+        if (slab == NULL) return NULL;
+        slab->next = pool.slabs;
+        pool.slabs = slab;
+        pool.cursor = (Uint8*)slab + slabHeader;
+        pool.left = POOL_SLAB_SIZE - slabHeader;
+        pool.stats.reserved += POOL_SLAB_SIZE;
+    }
+    void* p = pool.cursor;
+    pool.cursor += blockSize;
+    pool.left -= blockSize;
+    return p;
+}
+static void freeSmall(void* p, size_t size)
+{
+    size_t c = sizeClass(size);
+    FreeBlock* block = (FreeBlock*)p;
+    block->next = pool.free[c];
+    pool.free[c] = block;
+}
+
+static void* allocBlock(size_t size)
+{
+    void* p;
+    if (size <= POOL_MAX_SMALL)
+    {
+        p = allocSmall(size);
+        if (p != NULL) pool.stats.smallAllocs++;
+    }
+    else
+    {
+        p = malloc(size);
+        if (p != NULL) pool.stats.largeAllocs++;
+    }
+    return p;
+}
+static void freeBlock(void* p, size_t size)
+{
+    if (size <= POOL_MAX_SMALL)
+        freeSmall(p, size);
+    else
+        free(p);
+}
+
+static inline void countBytes(size_t osize, size_t nsize)
+{
+    pool.stats.bytes = pool.stats.bytes - osize + nsize;
+    if (pool.stats.bytes > pool.stats.peak)
+        pool.stats.peak = pool.stats.bytes;
+}
+
+void* Pool_Alloc(void*, void* ptr, size_t osize, size_t nsize)
+{
+    // with no block, osize is the type of the object being created
+    if (ptr == NULL)
+    {
+        if (nsize == 0) return NULL;
+        void* p = allocBlock(nsize);
+        if (p == NULL) return NULL;
+        pool.stats.allocs++;
+        countBytes(0, nsize);
+        return p;
+    }
+    if (nsize == 0)
+    {
+        freeBlock(ptr, osize);
+        pool.stats.frees++;
+        countBytes(osize, 0);
+        return NULL;
+    }
+
+    pool.stats.reallocs++;
+    bool oldSmall = osize <= POOL_MAX_SMALL, newSmall = nsize <= POOL_MAX_SMALL;
+    if (oldSmall && newSmall && sizeClass(osize) == sizeClass(nsize))
+    {
+        countBytes(osize, nsize);
+        return ptr;
+    }
+    if (!oldSmall && !newSmall)
+    {
+        void* p = realloc(ptr, nsize);
+        if (p == NULL) return NULL;
+        countBytes(osize, nsize);
+        return p;
+    }
+
+    void* p = allocBlock(nsize);
+    if (p == NULL)
+    {
+        // a shrinking block can stay where it is : it is big enough for its new class
+        if (nsize < osize && newSmall)
+        {
+            countBytes(osize, nsize);
+            return ptr;
+        }
+        return NULL;
+    }
+    memcpy(p, ptr, SDL_min(osize, nsize));
+    freeBlock(ptr, osize);
+    countBytes(osize, nsize);
+    return p;
+}
+
+void* Pool_SystemAlloc(void*, void* ptr, size_t osize, size_t nsize)
+{
+    if (nsize == 0)
+    {
+        if (ptr == NULL) return NULL;
+        free(ptr);
+        pool.stats.frees++;
+        countBytes(osize, 0);
+        return NULL;
+    }
+
+    void* p = realloc(ptr, nsize);
+    if (p == NULL) return NULL;
+    if (ptr == NULL)
+    {
+        pool.stats.allocs++;
+        pool.stats.largeAllocs++;
+        countBytes(0, nsize);
+    }
+    else
+    {
+        pool.stats.reallocs++;
+        countBytes(osize, nsize);
+    }
+    return p;
+}
+
+const AllocStats* Pool_GetStats()
+{
+    return &pool.stats;
+}
+
+void Pool_Release()
+{
+    while (pool.slabs != NULL)
+    {
+        Slab* next = pool.slabs->next;
+        free(pool.slabs);
+        pool.slabs = next;
+    }
+    memset(pool.free, 0, sizeof(pool.free));
+    pool.cursor = NULL;
+    pool.left = 0;
+    pool.stats.reserved = 0;
+}
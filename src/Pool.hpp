@@ -0,0 +1,37 @@
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include <cstddef>
+
+#include <include/SDL.h>
+
+// blocks up to POOL_MAX_SMALL bytes are served from per-thread free lists,
+// one per POOL_GRANULE-sized class, carved out of POOL_SLAB_SIZE slabs
+// bigger blocks go to the system allocator
+#define POOL_GRANULE 16
+#define POOL_MAX_SMALL 256
+#define POOL_CLASSES (POOL_MAX_SMALL / POOL_GRANULE)
+#define POOL_SLAB_SIZE (64 * 1024)
+
+typedef struct AllocStats
+{
+	// calls, by kind
+	Uint64 allocs, frees, reallocs;
+	// allocations served by the pools and by the system
+	Uint64 smallAllocs, largeAllocs;
+	// bytes currently allocated, and the highest it went
+	size_t bytes, peak;
+	// bytes of slabs reserved by the pools
+	size_t reserved;
+} AllocStats;
+
+// lua_Alloc using the pools of the calling thread
+void* Pool_Alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+// lua_Alloc using malloc for every block, as luaL_newstate does, counted in the same statistics
+void* Pool_SystemAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+// statistics of the calling thread
+const AllocStats* Pool_GetStats();
+// give the slabs of the calling thread back to the system
+// only once every state using them is closed
+void Pool_Release();
+#endif
@@ -0,0 +1,81 @@
+#include <cstring>
+
+#include <include/SDL.h>
+
+#include "Ring.hpp"
+
+bool Ring_Init(Ring* ring, size_t elementSize, size_t capacity)
+{
+    size_t rounded = 1;
+    while (rounded < capacity)
+        rounded <<= 1;
+
+    ring->data = (Uint8*)SDL_malloc(elementSize * rounded);
+    ring->elementSize = elementSize;
+    ring->capacity = (ring->data != NULL) ? rounded : 0;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    return ring->data != NULL;
+}
+void Ring_Free(Ring* ring)
+{
+    SDL_free(ring->data);
+    ring->data = NULL;
+    ring->capacity = 0;
+    Ring_Reset(ring);
+}
+void Ring_Reset(Ring* ring)
+{
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+}
+
+// copy count elements from or to the ring at index, wrapping around its end
+static void copyIn(Ring* ring, size_t index, const Uint8* src, size_t count)
+{
+    size_t at = index & (ring->capacity - 1);
+    size_t first = SDL_min(count, ring->capacity - at);
+    memcpy(ring->data + at * ring->elementSize, src, first * ring->elementSize);
+    memcpy(ring->data, src + first * ring->elementSize, (count - first) * ring->elementSize);
+}
+static void copyOut(const Ring* ring, size_t index, Uint8* dst, size_t count)
+{
+    size_t at = index & (ring->capacity - 1);
+    size_t first = SDL_min(count, ring->capacity - at);
+    memcpy(dst, ring->data + at * ring->elementSize, first * ring->elementSize);
+    memcpy(dst + first * ring->elementSize, ring->data, (count - first) * ring->elementSize);
+}
+
+size_t Ring_Write(Ring* ring, const void* elements, size_t count)
+{
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    size_t tail = ring->tail.load(std::memory_order_acquire);
+    count = SDL_min(count, ring->capacity - (head - tail));
+    if (count == 0) return 0;
+
+    copyIn(ring, head, (const Uint8*)elements, count);
+    // publish the elements only once they are written
+    ring->head.store(head + count, std::memory_order_release);
+    return count;
+}
+size_t Ring_Read(Ring* ring, void* elements, size_t count)
+{
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    size_t head = ring->head.load(std::memory_order_acquire);
+    count = SDL_min(count, head - tail);
+    if (count == 0) return 0;
+
+    copyOut(ring, tail, (Uint8*)elements, count);
+    // hand the room back only once the elements are copied out
+    ring->tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+size_t Ring_Count(const Ring* ring)
+{
+    return ring->head.load(std::memory_order_acquire) - ring->tail.load(std::memory_order_acquire);
+}
+size_t Ring_Space(const Ring* ring)
+{
+    return ring->capacity - Ring_Count(ring);
+}
@@ -0,0 +1,34 @@
+#ifndef RING_HPP
+#define RING_HPP
+
+#include <atomic>
+
+#include <include/SDL.h>
+
+// lock-free ring of fixed size elements, between one producer and one consumer thread
+// head is only written by the producer and tail by the consumer, each on its own cache line
+typedef struct Ring
+{
+	Uint8* data;
+	size_t elementSize;
+	// in elements, a power of two
+	size_t capacity;
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+} Ring;
+
+// capacity is rounded up to a power of two
+bool Ring_Init(Ring* ring, size_t elementSize, size_t capacity);
+void Ring_Free(Ring* ring);
+// empty the ring, neither side may be using it
+void Ring_Reset(Ring* ring);
+
+// producer : copy up to count elements in, return how many were
+size_t Ring_Write(Ring* ring, const void* elements, size_t count);
+// consumer : copy up to count elements out, return how many were
+size_t Ring_Read(Ring* ring, void* elements, size_t count);
+
+// elements ready to read, and room left to write
+size_t Ring_Count(const Ring* ring);
+size_t Ring_Space(const Ring* ring);
+#endif
@@ -0,0 +1,62 @@
+#include <cmath>
+
+#include <include/SDL.h>
+
+#include "Spatial.hpp"
+
+static float listenerX = 0.0f, listenerY = 0.0f;
+static float radius = SPATIAL_DEFAULT_RADIUS;
+static SpatialStats stats = { 0, 0, 0.0 };
+
+void Spatial_SetListener(float x, float y)
+{
+    listenerX = x;
+    listenerY = y;
+}
+void Spatial_GetListener(float* x, float* y)
+{
+    *x = listenerX;
+    *y = listenerY;
+}
+void Spatial_SetRadius(float r)
+{
+    radius = SDL_max(r, 1.0f);
+}
+float Spatial_GetRadius()
+{
+    return radius;
+}
+
+int Spatial_Compute(const float* xs, const float* ys, int count, float* attenuations, float* pans)
+{
+    // a tenth of the radius around the listener is heard from both sides
+    float near2 = radius * radius * 0.01f;
+    float invRadius = 1.0f / radius;
+    int culled = 0;
+
+    // branchless so the compiler can vectorize it
+    for (int i = 0; i < count; i++)
+    {
+        float dx = xs[i] - listenerX;
+        float dy = ys[i] - listenerY;
+        float d2 = dx * dx + dy * dy;
+        float falloff = SDL_max(1.0f - sqrtf(d2) * invRadius, 0.0f);
+
+        // quadratic falloff sounds closer to the inverse square law than a linear one
+        attenuations[i] = falloff * falloff;
+        pans[i] = dx / sqrtf(d2 + near2);
+        culled += falloff <= 0.0f;
+    }
+    return culled;
+}
+
+void Spatial_Record(int emitters, int culled, double time)
+{
+    stats.emitters = emitters;
+    stats.culled = culled;
+    stats.time = time;
+}
+const SpatialStats* Spatial_GetStats()
+{
+    return &stats;
+}
@@ -0,0 +1,30 @@
+#ifndef SPATIAL_HPP
+#define SPATIAL_HPP
+
+#include <include/SDL.h>
+
+// distance, in pixels, past which emitters are silent
+#define SPATIAL_DEFAULT_RADIUS 1000.0f
+
+typedef struct SpatialStats
+{
+	// emitters computed during the last frame, and the ones out of the radius
+	int emitters, culled;
+	// time the last pass took, in microseconds
+	double time;
+} SpatialStats;
+
+void Spatial_SetListener(float x, float y);
+void Spatial_GetListener(float* x, float* y);
+void Spatial_SetRadius(float radius);
+float Spatial_GetRadius();
+
+// compute the attenuation (0 to 1) and pan (-1 to 1) of count emitters at once
+// emitters out of the radius get an attenuation of 0
+// return how many were out of the radius
+int Spatial_Compute(const float* xs, const float* ys, int count, float* attenuations, float* pans);
+
+// record the last pass, for the statistics
+void Spatial_Record(int emitters, int culled, double time);
+const SpatialStats* Spatial_GetStats();
+#endif
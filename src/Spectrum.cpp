@@ -0,0 +1,320 @@
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+// four butterflies, or four bins, at a time
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPECTRUM_SSE
+#include <emmintrin.h>
+#endif
+
+#include <include/SDL.h>
+
+#include "Spectrum.hpp"
+#include "Ring.hpp"
+
+// samples the tap can queue ahead of the worker
+#define SPECTRUM_QUEUE (SPECTRUM_SIZE * 16)
+// converted at a time by the tap
+#define SPECTRUM_TAP_BLOCK 256
+// flux above its running mean by this ratio is an onset
+#define SPECTRUM_ONSET_RATIO 1.5f
+// analyses between two onsets, about 50 ms
+#define SPECTRUM_ONSET_GAP 5
+#define SPECTRUM_LOW 40.0f
+#define SPECTRUM_HIGH 16000.0f
+
+static Ring queue;
+static std::atomic<bool> tapping(false);
+static std::atomic<int> frequency(AUDIO_DEFAULT_FREQUENCY);
+static std::atomic<Uint64> dropped(0);
+
+static SDL_Thread* thread = NULL;
+static SDL_sem* ready = NULL;
+static std::atomic<bool> running(false);
+static int bandCount = SPECTRUM_DEFAULT_BANDS;
+
+// published by the worker, read by the game thread
+static SDL_SpinLock frameLock = 0;
+static SpectrumFrame published;
+
+// only touched by the worker
+static float window[SPECTRUM_SIZE];
+// twiddles of each stage one after another, the stage of half size h starts at h - 1
+static float twiddleRe[SPECTRUM_SIZE], twiddleIm[SPECTRUM_SIZE];
+static int reversed[SPECTRUM_SIZE];
+static float samples[SPECTRUM_SIZE];
+static float re[SPECTRUM_SIZE], im[SPECTRUM_SIZE];
+static float magnitudes[SPECTRUM_SIZE / 2], previous[SPECTRUM_SIZE / 2];
+static int bandStart[SPECTRUM_MAX_BANDS + 1];
+static int bandFrequency = 0;
+static float fluxMean = 0.0f;
+static int sinceOnset = 0;
+
+static void prepare()
+{
+    int bits = 0;
+    while ((1 << bits) < SPECTRUM_SIZE) bits++;
+    for (int i = 0; i < SPECTRUM_SIZE; i++)
+    {
+        // hann
+        window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (float)(SPECTRUM_SIZE - 1));
+        int r = 0;
+        for (int b = 0; b < bits; b++)
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        reversed[i] = r;
+    }
+    for (int h = 1; h < SPECTRUM_SIZE; h <<= 1)
+    {
+        for (int k = 0; k < h; k++)
+        {
+            float angle = -(float)M_PI * k / (float)h;
+            twiddleRe[h - 1 + k] = cosf(angle);
+            twiddleIm[h - 1 + k] = sinf(angle);
+        }
+    }
+}
+
+// iterative radix 2, in place on split real and imaginary parts
+static void fft()
+{
+    for (int i = 0; i < SPECTRUM_SIZE; i++)
+    {
+        int j = reversed[i];
+        if (j <= i) continue;
+        float t = re[i]; re[i] = re[j]; re[j] = t;
+        t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+
+    for (int h = 1; h < SPECTRUM_SIZE; h <<= 1)
+    {
+        const float* wr = twiddleRe + h - 1;
+        const float* wi = twiddleIm + h - 1;
+        for (int base = 0; base < SPECTRUM_SIZE; base += 2 * h)
+        {
+            float* ar = re + base, * ai = im + base;
+            float* br = ar + h, * bi = ai + h;
+            int k = 0;
+#ifdef SPECTRUM_SSE
+            // the first two stages have fewer than four butterflies per group
+            for (; k + 4 <= h; k += 4)
+            {
+                __m128 xr = _mm_loadu_ps(br + k), xi = _mm_loadu_ps(bi + k);
+                __m128 cr = _mm_loadu_ps(wr + k), ci = _mm_loadu_ps(wi + k);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+                __m128 ur = _mm_loadu_ps(ar + k), ui = _mm_loadu_ps(ai + k);
+                _mm_storeu_ps(ar + k, _mm_add_ps(ur, tr));
+                _mm_storeu_ps(ai + k, _mm_add_ps(ui, ti));
+                _mm_storeu_ps(br + k, _mm_sub_ps(ur, tr));
+                _mm_storeu_ps(bi + k, _mm_sub_ps(ui, ti));
+            }
+#endif
+            for (; k < h; k++)
+            {
+                float tr = br[k] * wr[k] - bi[k] * wi[k];
+                float ti = br[k] * wi[k] + bi[k] * wr[k];
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+}
+
+// log spaced, each band at least one bin past the previous one
+static void splitBands(int rate)
+{
+    float binWidth = (float)rate / SPECTRUM_SIZE;
+    float high = SDL_min(SPECTRUM_HIGH, rate * 0.5f);
+    int last = SPECTRUM_SIZE / 2;
+    bandStart[0] = SDL_max((int)(SPECTRUM_LOW / binWidth), 1);
+    for (int b = 1; b <= bandCount; b++)
+    {
+        float edge = SPECTRUM_LOW * powf(high / SPECTRUM_LOW, (float)b / bandCount);
+        int bin = (int)(edge / binWidth + 0.5f);
+        bandStart[b] = SDL_min(SDL_max(bin, bandStart[b - 1] + 1), last);
+    }
+    bandFrequency = rate;
+}
+
+static void analyse()
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    int rate = frequency.load(std::memory_order_relaxed);
+    if (rate != bandFrequency) splitBands(rate);
+
+    int i = 0;
+#ifdef SPECTRUM_SSE
+    for (; i + 4 <= SPECTRUM_SIZE; i += 4)
+    {
+        _mm_storeu_ps(re + i, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(window + i)));
+        _mm_storeu_ps(im + i, _mm_setzero_ps());
+    }
+#endif
+    for (; i < SPECTRUM_SIZE; i++)
+    {
+        re[i] = samples[i] * window[i];
+        im[i] = 0.0f;
+    }
+    fft();
+
+    // a full scale sine peaks at a quarter of the size through the window
+    const float scale = 4.0f / SPECTRUM_SIZE;
+    float flux = 0.0f;
+    for (int k = 0; k < SPECTRUM_SIZE / 2; k++)
+    {
+        float m = sqrtf(re[k] * re[k] + im[k] * im[k]) * scale;
+        flux += SDL_max(m - previous[k], 0.0f);
+        previous[k] = magnitudes[k] = m;
+    }
+
+    float bands[SPECTRUM_MAX_BANDS];
+    for (int b = 0; b < bandCount; b++)
+    {
+        float power = 0.0f;
+        for (int k = bandStart[b]; k < bandStart[b + 1]; k++)
+            power += magnitudes[k] * magnitudes[k];
+        int bins = bandStart[b + 1] - bandStart[b];
+        bands[b] = (bins > 0) ? sqrtf(power / bins) : 0.0f;
+    }
+
+    bool onset = flux > fluxMean * SPECTRUM_ONSET_RATIO + 0.0001f && sinceOnset >= SPECTRUM_ONSET_GAP;
+    fluxMean = fluxMean * 0.95f + flux * 0.05f;
+    sinceOnset = onset ? 0 : sinceOnset + 1;
+    double us = (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+
+    SDL_AtomicLock(&frameLock);
+    memcpy(published.bands, bands, bandCount * sizeof(float));
+    published.bandCount = bandCount;
+    published.flux = flux;
+    if (onset) published.onsets++;
+    published.analyses++;
+    published.dropped = dropped.load(std::memory_order_relaxed);
+    published.time = us;
+    SDL_AtomicUnlock(&frameLock);
+}
+
+static int SDLCALL work(void*)
+{
+    // what was queued before the previous stop is stale
+    float stale[SPECTRUM_TAP_BLOCK];
+    while (Ring_Read(&queue, stale, SPECTRUM_TAP_BLOCK) > 0) {}
+    memset(samples, 0, sizeof(samples));
+    memset(previous, 0, sizeof(previous));
+    fluxMean = 0.0f;
+    sinceOnset = SPECTRUM_ONSET_GAP;
+    tapping.store(true, std::memory_order_release);
+
+    while (running.load(std::memory_order_acquire))
+    {
+        SDL_SemWaitTimeout(ready, 100);
+        while (Ring_Count(&queue) >= SPECTRUM_HOP)
+        {
+            memmove(samples, samples + SPECTRUM_HOP, (SPECTRUM_SIZE - SPECTRUM_HOP) * sizeof(float));
+            Ring_Read(&queue, samples + SPECTRUM_SIZE - SPECTRUM_HOP, SPECTRUM_HOP);
+            analyse();
+        }
+    }
+    tapping.store(false, std::memory_order_release);
+    return 0;
+}
+
+bool Spectrum_Start(int bands)
+{
+    if (running.load()) return true;
+
+    if (queue.data == NULL)
+    {
+        if (!Ring_Init(&queue, sizeof(float), SPECTRUM_QUEUE))
+        {
+            SDL_OutOfMemory();
+            return false;
+        }
+        prepare();
+    }
+    if (ready == NULL && (ready = SDL_CreateSemaphore(0)) == NULL)
+        return false;
+
+    bandCount = SDL_clamp(bands, 1, SPECTRUM_MAX_BANDS);
+    bandFrequency = 0;
+    SDL_AtomicLock(&frameLock);
+    SDL_zero(published);
+    published.bandCount = bandCount;
+    SDL_AtomicUnlock(&frameLock);
+    dropped.store(0);
+
+    running.store(true);
+    thread = SDL_CreateThread(work, "spectrum", NULL);
+    if (thread == NULL)
+    {
+        running.store(false);
+        return false;
+    }
+    return true;
+}
+void Spectrum_Stop()
+{
+    if (!running.load()) return;
+    running.store(false, std::memory_order_release);
+    SDL_SemPost(ready);
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+}
+bool Spectrum_IsRunning()
+{
+    return running.load();
+}
+void Spectrum_Shutdown()
+{
+    Spectrum_Stop();
+    Ring_Free(&queue);
+    if (ready != NULL) SDL_DestroySemaphore(ready);
+    ready = NULL;
+}
+
+void Spectrum_Tap(const Uint8* stream, int len, const AudioSpec* spec)
+{
+    if (!tapping.load(std::memory_order_acquire)) return;
+    frequency.store(spec->frequency, std::memory_order_relaxed);
+
+    // down to mono floats
+    float block[SPECTRUM_TAP_BLOCK];
+    int sampleSize = SDL_AUDIO_BITSIZE(spec->format) / 8;
+    int frames = len / (sampleSize * spec->channels);
+    float inv = 1.0f / spec->channels;
+    for (int done = 0; done < frames;)
+    {
+        int count = SDL_min(frames - done, SPECTRUM_TAP_BLOCK);
+        for (int f = 0; f < count; f++)
+        {
+            float sum = 0.0f;
+            for (int c = 0; c < spec->channels; c++)
+            {
+                int i = (done + f) * spec->channels + c;
+                switch (spec->format)
+                {
+                case AUDIO_S16SYS: sum += ((const Sint16*)stream)[i] * (1.0f / 32768.0f); break;
+                case AUDIO_S32SYS: sum += ((const Sint32*)stream)[i] * (1.0f / 2147483648.0f); break;
+                case AUDIO_F32SYS: sum += ((const float*)stream)[i]; break;
+                case AUDIO_S8: sum += ((const Sint8*)stream)[i] * (1.0f / 128.0f); break;
+                case AUDIO_U8: sum += (stream[i] - 128) * (1.0f / 128.0f); break;
+                }
+            }
+            block[f] = sum * inv;
+        }
+        size_t written = Ring_Write(&queue, block, count);
+        if (written < (size_t)count)
+            dropped.fetch_add(count - written, std::memory_order_relaxed);
+        done += count;
+    }
+    SDL_SemPost(ready);
+}
+
+void Spectrum_Get(SpectrumFrame* frame)
+{
+    SDL_AtomicLock(&frameLock);
+    *frame = published;
+    SDL_AtomicUnlock(&frameLock);
+}
@@ -0,0 +1,39 @@
+#ifndef SPECTRUM_HPP
+#define SPECTRUM_HPP
+
+#include <include/SDL.h>
+
+#include "Audio.hpp"
+
+// samples per analysis, a power of two, and how many new ones start the next
+#define SPECTRUM_SIZE 1024
+#define SPECTRUM_HOP 512
+#define SPECTRUM_MAX_BANDS 32
+#define SPECTRUM_DEFAULT_BANDS 16
+
+typedef struct SpectrumFrame
+{
+	// rms magnitude of the bins of each band from low to high frequencies, a full scale sine is 1 in its bin
+	float bands[SPECTRUM_MAX_BANDS];
+	int bandCount;
+	// rise of the spectrum since the previous analysis, and onsets detected from it so far
+	float flux;
+	Uint32 onsets;
+	// analyses done, samples the worker was too late for, and time the last one took in microseconds
+	Uint64 analyses, dropped;
+	double time;
+} SpectrumFrame;
+
+// start analysing the output on a worker thread, split into bands log spaced in frequency
+// return false if the thread can't be created
+bool Spectrum_Start(int bands);
+// stop and join the worker, the last frame stays readable
+void Spectrum_Stop();
+bool Spectrum_IsRunning();
+// free the tap buffer, after the device was closed
+void Spectrum_Shutdown();
+// called from the audio callback, copies the mixed output for the worker
+void Spectrum_Tap(const Uint8* stream, int len, const AudioSpec* spec);
+// copy the last analysis
+void Spectrum_Get(SpectrumFrame* frame);
+#endif
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <fstream>
+
+#include <include/SDL.h>
+
+#include "Startup.hpp"
+
+static bool enabled = false, finished = false;
+static const char* trace = NULL;
+static Uint64 origin = 0;
+
+static StartupSpan spans[STARTUP_MAX_SPANS];
+static int spanCount = 0;
+// indexes of the open spans
+static int openSpans[STARTUP_MAX_DEPTH];
+static int depth = 0;
+// spans begun past the limits, their end is dropped too
+static int skipped = 0;
+
+static double toMs(Uint64 counter)
+{
+    return (double)(counter - origin) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static void printTimeline()
+{
+    std::cout << "startup timeline, start and duration in ms :" << std::endl;
+    char line[160];
+    for (int i = 0; i < spanCount; i++)
+    {
+        const StartupSpan* span = &spans[i];
+        SDL_snprintf(line, sizeof(line), "%9.3f %9.3f  %*s%s%s%s%s", toMs(span->start), toMs(span->end) - toMs(span->start),
+            span->depth * 2, "", span->name,
+            span->detail ? " (" : "", span->detail ? span->detail : "", span->detail ? ")" : "");
+        std::cout << line << std::endl;
+    }
+}
+static void writeTrace()
+{
+    std::ofstream file(trace);
+    if (!file)
+    {
+        std::cout << "Can't write startup trace :\n" << trace << std::endl;
+        return;
+    }
+
+    // chrome://tracing and perfetto read complete events, in microseconds
+    file << "{\"traceEvents\":[";
+    char event[256];
+    for (int i = 0; i < spanCount; i++)
+    {
+        const StartupSpan* span = &spans[i];
+        SDL_snprintf(event, sizeof(event), "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f",
+            i > 0 ? "," : "", span->name, toMs(span->start) * 1000.0, (toMs(span->end) - toMs(span->start)) * 1000.0);
+        file << event;
+        if (span->detail != NULL)
+            file << ",\"args\":{\"detail\":\"" << span->detail << "\"}";
+        file << "}";
+    }
+    file << "\n]}" << std::endl;
+    std::cout << "startup trace written to " << trace << std::endl;
+}
+
+void Startup_Enable(const char* tracePath)
+{
+    origin = SDL_GetPerformanceCounter();
+    enabled = true;
+    finished = false;
+    trace = tracePath;
+    spanCount = depth = skipped = 0;
+}
+bool Startup_IsEnabled()
+{
+    return enabled && !finished;
+}
+void Startup_Begin(const char* name, const char* detail)
+{
+    if (!enabled || finished) return;
+    if (skipped > 0 || spanCount == STARTUP_MAX_SPANS || depth == STARTUP_MAX_DEPTH)
+    {
+        skipped++;
+        return;
+    }
+
+    StartupSpan* span = &spans[spanCount];
+    span->name = name;
+    span->detail = detail;
+    span->start = SDL_GetPerformanceCounter();
+    span->end = 0;
+    span->depth = depth;
+    openSpans[depth++] = spanCount++;
+}
+void Startup_End()
+{
+    if (!enabled || finished) return;
+    if (skipped > 0)
+        skipped--;
+    else if (depth > 0)
+        spans[openSpans[--depth]].end = SDL_GetPerformanceCounter();
+}
+void Startup_Finish()
+{
+    if (!enabled || finished) return;
+    while (depth > 0 || skipped > 0)
+        Startup_End();
+    finished = true;
+
+    if (trace != NULL)
+        writeTrace();
+    else
+        printTimeline();
+}
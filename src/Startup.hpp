@@ -0,0 +1,29 @@
+#ifndef STARTUP_HPP
+#define STARTUP_HPP
+
+#include <include/SDL.h>
+
+#define STARTUP_MAX_SPANS 128
+#define STARTUP_MAX_DEPTH 16
+
+typedef struct StartupSpan
+{
+	// static strings, detail may be NULL
+	const char* name;
+	const char* detail;
+	// performance counter at both ends, end is 0 while the span is open
+	Uint64 start, end;
+	int depth;
+} StartupSpan;
+
+// start recording the timeline from now, the very start of main
+// it is printed once finished, or written as a chrome trace to tracePath when not NULL
+void Startup_Enable(const char* tracePath);
+bool Startup_IsEnabled();
+// open a span inside the one open, does nothing when disabled or finished
+void Startup_Begin(const char* name, const char* detail);
+// close the last span opened
+void Startup_End();
+// close what is still open, then print or write the timeline, once
+void Startup_Finish();
+#endif
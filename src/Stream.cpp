@@ -0,0 +1,152 @@
+#include <new>
+
+#include <include/SDL.h>
+
+#include "Stream.hpp"
+
+static std::atomic<Stream*> slots[STREAM_SLOTS];
+
+static void freeStream(void* data)
+{
+    Stream* stream = (Stream*)data;
+    Ring_Free(&stream->ring);
+    delete stream;
+}
+
+Stream* Stream_Create(int channels, int capacity)
+{
+    int slot = -1;
+    for (int i = 0; i < STREAM_SLOTS && slot < 0; i++)
+        if (slots[i].load() == NULL) slot = i;
+    if (slot < 0)
+    {
+        SDL_SetError("Too many audio streams");
+        return NULL;
+    }
+
+    Stream* stream = new (std::nothrow) Stream;
+    if (stream == NULL || !Ring_Init(&stream->ring, channels * sizeof(float), capacity))
+    {
+        delete stream;
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    stream->channels = channels;
+    stream->playing.store(false);
+    stream->volume.store(1.0f);
+    stream->underruns.store(0);
+    stream->played.store(0);
+    stream->slot = slot;
+
+    // the callback only sees it once it is complete
+    slots[slot].store(stream, std::memory_order_release);
+    return stream;
+}
+void Stream_Destroy(Stream* stream)
+{
+    if (stream == NULL) return;
+    // a callback running through the slots may still hold the stream
+    slots[stream->slot].store(NULL);
+    Audio_Retire(freeStream, stream);
+}
+
+int Stream_Write(Stream* stream, const float* samples, int frames)
+{
+    return (int)Ring_Write(&stream->ring, samples, (size_t)SDL_max(frames, 0));
+}
+int Stream_GetFill(const Stream* stream)
+{
+    return (int)Ring_Count(&stream->ring);
+}
+int Stream_GetCapacity(const Stream* stream)
+{
+    return (int)stream->ring.capacity;
+}
+
+// add frames of the stream to output, converting to the device layout and format
+static void addFrames(Uint8* output, const float* frames, int count, int streamChannels, float volume, const AudioSpec* spec)
+{
+    int samples = count * spec->channels;
+    for (int i = 0; i < samples; i++)
+    {
+        int frame = i / spec->channels, channel = i % spec->channels;
+        const float* f = frames + frame * streamChannels;
+        // mono plays on every channel, stereo down to mono is averaged
+        float v = (streamChannels == 1) ? f[0]
+            : (spec->channels == 1) ? (f[0] + f[1]) * 0.5f
+            : f[SDL_min(channel, 1)];
+        v = SDL_clamp(v * volume, -1.0f, 1.0f);
+
+        switch (spec->format)
+        {
+        case AUDIO_S16SYS:
+        {
+            Sint16* out = (Sint16*)output + i;
+            *out = (Sint16)SDL_clamp(*out + v * 32767.0f, -32768.0f, 32767.0f);
+            break;
+        }
+        case AUDIO_S32SYS:
+        {
+            Sint32* out = (Sint32*)output + i;
+            *out = (Sint32)SDL_clamp((double)*out + v * 2147483647.0, -2147483648.0, 2147483647.0);
+            break;
+        }
+        case AUDIO_F32SYS:
+        {
+            float* out = (float*)output + i;
+            *out = SDL_clamp(*out + v, -1.0f, 1.0f);
+            break;
+        }
+        case AUDIO_S8:
+        {
+            Sint8* out = (Sint8*)output + i;
+            *out = (Sint8)SDL_clamp(*out + v * 127.0f, -128.0f, 127.0f);
+            break;
+        }
+        case AUDIO_U8:
+        {
+            Uint8* out = output + i;
+            *out = (Uint8)SDL_clamp(*out + v * 127.0f, 0.0f, 255.0f);
+            break;
+        }
+        }
+    }
+}
+
+int Stream_Process(Uint8* output, int len, const AudioSpec* spec, int* lowest)
+{
+    // only touched by the callback
+    static float block[STREAM_BLOCK * 2];
+
+    int dry = 0;
+    *lowest = -1;
+
+    int frameSize = SDL_AUDIO_BITSIZE(spec->format) / 8 * spec->channels;
+    int frames = (frameSize > 0) ? len / frameSize : 0;
+    for (int i = 0; i < STREAM_SLOTS; i++)
+    {
+        Stream* stream = slots[i].load();
+        if (stream == NULL || !stream->playing.load(std::memory_order_relaxed)) continue;
+
+        float volume = stream->volume.load(std::memory_order_relaxed);
+        int fill = (int)Ring_Count(&stream->ring);
+        if (*lowest < 0 || fill < *lowest) *lowest = fill;
+        int done = 0;
+        while (done < frames)
+        {
+            int want = SDL_min(frames - done, STREAM_BLOCK);
+            int got = (int)Ring_Read(&stream->ring, block, want);
+            addFrames(output + done * frameSize, block, got, stream->channels, volume, spec);
+            done += got;
+            if (got < want) break;
+        }
+        // the rest of the callback stays silent
+        if (done < frames)
+        {
+            stream->underruns.fetch_add(1, std::memory_order_relaxed);
+            dry++;
+        }
+        stream->played.fetch_add(done, std::memory_order_relaxed);
+    }
+    return dry;
+}
@@ -0,0 +1,45 @@
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <atomic>
+
+#include <include/SDL.h>
+
+#include "Audio.hpp"
+#include "Ring.hpp"
+
+// streams the audio callback can mix at once
+#define STREAM_SLOTS 32
+// frames mixed at a time, callbacks with more are split
+#define STREAM_BLOCK 1024
+
+// samples written by the game thread and drained by the audio callback
+typedef struct Stream
+{
+	// frames of 1 or 2 float samples, from -1 to 1, at the device frequency
+	Ring ring;
+	int channels;
+	std::atomic<bool> playing;
+	std::atomic<float> volume;
+	// callbacks that wanted more frames than were queued
+	std::atomic<Uint64> underruns;
+	std::atomic<Uint64> played;
+	int slot;
+} Stream;
+
+// create a stream holding up to capacity frames, return NULL if all slots are taken
+Stream* Stream_Create(int channels, int capacity);
+// take the stream from the callback, then free it once the callback let go of it, see Audio_Retire
+void Stream_Destroy(Stream* stream);
+
+// queue frames, return how many fit
+int Stream_Write(Stream* stream, const float* samples, int frames);
+// frames queued, not played yet
+int Stream_GetFill(const Stream* stream);
+int Stream_GetCapacity(const Stream* stream);
+
+// called from the audio callback, during a pass, adds the playing streams to output
+// lowest is set to the frames queued in the emptiest playing stream, -1 if none plays
+// return how many playing streams ran dry
+int Stream_Process(Uint8* output, int len, const AudioSpec* spec, int* lowest);
+#endif
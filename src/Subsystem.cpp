@@ -0,0 +1,131 @@
+#include <include/SDL.h>
+#include <include/SDL_image.h>
+#include <include/SDL_mixer.h>
+
+#include "Subsystem.hpp"
+#include "Startup.hpp"
+
+typedef struct Codec
+{
+    const char* ext;
+    int flag;
+} Codec;
+
+static const Codec imageCodecs[] = {
+    { "jpg", IMG_INIT_JPG }, { "jpeg", IMG_INIT_JPG }, { "png", IMG_INIT_PNG },
+    { "tif", IMG_INIT_TIF }, { "tiff", IMG_INIT_TIF }, { "webp", IMG_INIT_WEBP },
+    { "jxl", IMG_INIT_JXL }, { "avif", IMG_INIT_AVIF }, { NULL, 0 }
+};
+static const Codec mixerCodecs[] = {
+    { "flac", MIX_INIT_FLAC }, { "mod", MIX_INIT_MOD }, { "xm", MIX_INIT_MOD },
+    { "s3m", MIX_INIT_MOD }, { "it", MIX_INIT_MOD }, { "mp3", MIX_INIT_MP3 },
+    { "ogg", MIX_INIT_OGG }, { "mid", MIX_INIT_MID }, { "midi", MIX_INIT_MID },
+    { "opus", MIX_INIT_OPUS }, { NULL, 0 }
+};
+static const struct
+{
+    Uint32 flag;
+    const char* name;
+} subsystemNames[] = {
+    { SDL_INIT_TIMER, "timer" }, { SDL_INIT_AUDIO, "audio" }, { SDL_INIT_VIDEO, "video" },
+    { SDL_INIT_JOYSTICK, "joystick" }, { SDL_INIT_HAPTIC, "haptic" },
+    { SDL_INIT_GAMECONTROLLER, "gamecontroller" }, { SDL_INIT_EVENTS, "events" },
+    { SDL_INIT_SENSOR, "sensor" }, { 0, NULL }
+};
+
+static int imageFlags = 0, mixerFlags = 0;
+static SubsystemStats stats[SUBSYSTEM_MAX];
+static int statCount = 0;
+
+static double elapsed(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+static void record(const char* name, double time)
+{
+    if (statCount == SUBSYSTEM_MAX) return;
+    stats[statCount].name = name;
+    stats[statCount].time = time;
+    statCount++;
+}
+static const Codec* findCodec(const Codec* codecs, const char* path)
+{
+    const char* ext = (path != NULL) ? SDL_strrchr(path, '.') : NULL;
+    if (ext == NULL) return NULL;
+    for (const Codec* codec = codecs; codec->ext != NULL; codec++)
+        if (SDL_strcasecmp(ext + 1, codec->ext) == 0) return codec;
+    return NULL;
+}
+
+bool Subsystem_Init(Uint32 flags)
+{
+    Uint32 fresh = flags & ~SDL_WasInit(flags);
+    if (fresh == 0) return SDL_InitSubSystem(flags) == 0;
+
+    // subsystems brought up together share the time
+    const char* name = "sdl";
+    for (int i = 0; subsystemNames[i].name != NULL; i++)
+    {
+        if (fresh & subsystemNames[i].flag)
+        {
+            name = subsystemNames[i].name;
+            break;
+        }
+    }
+
+    Startup_Begin("SDL_InitSubSystem", name);
+    Uint64 start = SDL_GetPerformanceCounter();
+    bool inited = SDL_InitSubSystem(flags) == 0;
+    double time = elapsed(start);
+    Startup_End();
+    if (!inited) return false;
+
+    record(name, time);
+    return true;
+}
+bool Subsystem_InitImage(const char* path)
+{
+    const Codec* codec = findCodec(imageCodecs, path);
+    if (codec == NULL || (imageFlags & codec->flag)) return true;
+
+    Startup_Begin("IMG_Init", codec->ext);
+    Uint64 start = SDL_GetPerformanceCounter();
+    bool inited = (IMG_Init(codec->flag) & codec->flag) != 0;
+    double time = elapsed(start);
+    Startup_End();
+    if (!inited) return false;
+    imageFlags |= codec->flag;
+    record(codec->ext, time);
+    return true;
+}
+bool Subsystem_InitMixer(const char* path)
+{
+    const Codec* codec = findCodec(mixerCodecs, path);
+    if (codec == NULL || (mixerFlags & codec->flag)) return true;
+
+    Startup_Begin("Mix_Init", codec->ext);
+    Uint64 start = SDL_GetPerformanceCounter();
+    bool inited = (Mix_Init(codec->flag) & codec->flag) != 0;
+    double time = elapsed(start);
+    Startup_End();
+    if (!inited) return false;
+    mixerFlags |= codec->flag;
+    record(codec->ext, time);
+    return true;
+}
+void Subsystem_QuitAll()
+{
+    if (SDL_WasInit(SDL_INIT_EVERYTHING) != 0)
+        SDL_Quit();
+    if (imageFlags != 0)
+        IMG_Quit();
+    if (mixerFlags != 0)
+        Mix_Quit();
+    imageFlags = mixerFlags = 0;
+}
+
+int Subsystem_GetStats(const SubsystemStats** out)
+{
+    *out = stats;
+    return statCount;
+}
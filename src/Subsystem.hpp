@@ -0,0 +1,31 @@
+#ifndef SUBSYSTEM_HPP
+#define SUBSYSTEM_HPP
+
+#include <include/SDL.h>
+
+// subsystems, image codecs and audio decoders that can be initialised
+#define SUBSYSTEM_MAX 24
+
+typedef struct SubsystemStats
+{
+	const char* name;
+	// time the first initialisation took, in milliseconds
+	double time;
+} SubsystemStats;
+
+// SDL_InitSubSystem, timed the first time each subsystem comes up
+// balance it with SDL_QuitSubSystem like SDL_InitSubSystem
+bool Subsystem_Init(Uint32 flags);
+// bring up the SDL_image codec that decodes path, from its extension
+// formats built in SDL_image need none
+bool Subsystem_InitImage(const char* path);
+// bring up the SDL_mixer decoder that plays path, from its extension
+// wav needs none
+bool Subsystem_InitMixer(const char* path);
+// quit SDL_image, SDL_mixer and SDL, whichever was initialised
+void Subsystem_QuitAll();
+
+// what was initialised so far, in order, with the time each took
+// return the count
+int Subsystem_GetStats(const SubsystemStats** stats);
+#endif
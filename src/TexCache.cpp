@@ -0,0 +1,139 @@
+#include <fstream>
+#include <string>
+#include <filesystem>
+#include <cstring>
+
+#include <include/SDL.h>
+
+#include "TexCache.hpp"
+#include "Pak.hpp"
+
+// cache directory, empty when the cache is disabled
+static std::string cacheDir;
+
+// FNV-1a
+static Uint64 hashBytes(Uint64 h, const void* data, size_t size)
+{
+    const Uint8* p = (const Uint8*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// the cache file name is keyed by path, mtime and format
+static std::string cachePath(const char* path, Sint64 mtime, Uint32 format)
+{
+    Uint64 h = 0xcbf29ce484222325ULL;
+    h = hashBytes(h, path, strlen(path));
+    h = hashBytes(h, &mtime, sizeof(mtime));
+    h = hashBytes(h, &format, sizeof(format));
+
+    char name[32];
+    SDL_snprintf(name, sizeof(name), "%016llx.tex", (unsigned long long)h);
+    return cacheDir + "/" + name;
+}
+
+void TexCache_SetDir(const char* dir)
+{
+    cacheDir = (dir != NULL) ? dir : "";
+}
+const char* TexCache_GetDir()
+{
+    return cacheDir.empty() ? NULL : cacheDir.c_str();
+}
+
+bool TexCache_Open(const char* path, Uint32 format, TexCacheEntry* entry)
+{
+    if (cacheDir.empty()) return false;
+    Sint64 mtime = AssetModTime(path);
+    if (mtime < 0) return false;
+
+    std::string fn = cachePath(path, mtime, format);
+    if (FileModTime(fn.c_str()) < 0) return false;
+    if (!MapFile(&entry->map, fn.c_str())) return false;
+
+    const Uint8* base = (const Uint8*)entry->map.data;
+    size_t size = entry->map.size;
+    const TexCacheHeader* header = (const TexCacheHeader*)base;
+    size_t pathLength = strlen(path);
+
+    // reject anything stale, truncated or colliding with another source
+    if (size < sizeof(TexCacheHeader)
+        || memcmp(header->magic, TEXCACHE_MAGIC, 4) != 0
+        || header->version != TEXCACHE_VERSION
+        || header->format != format
+        || header->mtime != mtime
+        || header->pathLength != pathLength
+        || size - sizeof(TexCacheHeader) <= pathLength
+        || memcmp(base + sizeof(TexCacheHeader), path, pathLength + 1) != 0
+        || header->pixelsOffset <= sizeof(TexCacheHeader) + pathLength
+        || header->w <= 0 || header->h <= 0 || header->pitch <= 0
+        || header->pixelsOffset > size
+        || (size - header->pixelsOffset) / (size_t)header->pitch < (size_t)header->h)
+    {
+        UnmapFile(&entry->map);
+        return false;
+    }
+
+    entry->format = header->format;
+    entry->w = header->w;
+    entry->h = header->h;
+    entry->pitch = header->pitch;
+    entry->pixels = base + header->pixelsOffset;
+    return true;
+}
+void TexCache_Close(TexCacheEntry* entry)
+{
+    UnmapFile(&entry->map);
+    entry->pixels = NULL;
+}
+
+bool TexCache_Store(const char* path, const SDL_Surface* surf)
+{
+    if (cacheDir.empty()) return false;
+    Sint64 mtime = AssetModTime(path);
+    if (mtime < 0) return false;
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    if (ec) return false;
+
+    TexCacheHeader header = {};
+    memcpy(header.magic, TEXCACHE_MAGIC, 4);
+    header.version = TEXCACHE_VERSION;
+    header.format = surf->format->format;
+    header.w = surf->w;
+    header.h = surf->h;
+    header.pitch = surf->pitch;
+    header.mtime = mtime;
+    header.pathLength = (Uint32)strlen(path);
+    // keep the pixels aligned for the texture upload, after the path and its terminator
+    header.pixelsOffset = (Uint32)((sizeof(header) + header.pathLength + 1 + 63) & ~(size_t)63);
+
+    // write to a temporary file first so a crash never leaves a truncated cache
+    std::string fn = cachePath(path, mtime, header.format);
+    std::string tmp = fn + ".tmp";
+    bool written;
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        static const char zeros[64] = { 0 };
+        out.write((const char*)&header, sizeof(header));
+        out.write(path, header.pathLength);
+        out.write(zeros, header.pixelsOffset - sizeof(header) - header.pathLength);
+        out.write((const char*)surf->pixels, (std::streamsize)surf->pitch * surf->h);
+        written = (bool)out;
+    }
+    if (written)
+        std::filesystem::rename(tmp, fn, ec);
+    if (!written || ec)
+    {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
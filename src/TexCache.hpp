@@ -0,0 +1,45 @@
+#ifndef TEXCACHE_HPP
+#define TEXCACHE_HPP
+
+#include <include/SDL.h>
+
+#include "FileMap.hpp"
+
+#define TEXCACHE_MAGIC "LTEX"
+#define TEXCACHE_VERSION 2
+
+// cache file layout :
+//   TexCacheHeader
+//   source path, NUL-terminated
+//   pixels, h rows of pitch bytes starting at pixelsOffset
+typedef struct TexCacheHeader
+{
+	char magic[4];
+	Uint32 version;
+	Uint32 format;
+	Sint32 w, h, pitch;
+	Sint64 mtime;
+	Uint32 pathLength;
+	Uint32 pixelsOffset;
+} TexCacheHeader;
+
+// a cached image mapped in memory
+typedef struct TexCacheEntry
+{
+	MappedFile map;
+	Uint32 format;
+	int w, h, pitch;
+	const void* pixels;
+} TexCacheEntry;
+
+// set the cache directory, NULL disables the cache, which is off until a directory is set
+void TexCache_SetDir(const char* dir);
+const char* TexCache_GetDir();
+
+// map the cached pixels of path converted to format
+// return false if there is no up-to-date cache for it
+bool TexCache_Open(const char* path, Uint32 format, TexCacheEntry* entry);
+void TexCache_Close(TexCacheEntry* entry);
+// write surf (already converted) as the cache of path
+bool TexCache_Store(const char* path, const SDL_Surface* surf);
+#endif
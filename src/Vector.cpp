@@ -0,0 +1,126 @@
+#include <cmath>
+
+#include <include/SDL.h>
+
+#include "Vector.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VECTOR_SSE
+#include <emmintrin.h>
+#endif
+
+static VectorStats stats = { 0, 0, 0.0 };
+
+// the SSE loops take two vectors at a time, the scalar tails finish the odd one
+void Vector_AddScaled(float* dst, const float* src, float scale, int count)
+{
+    int i = 0;
+#ifdef VECTOR_SSE
+    __m128 s = _mm_set1_ps(scale);
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128 d = _mm_loadu_ps(dst + i * 2);
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(src + i * 2), s));
+        _mm_storeu_ps(dst + i * 2, d);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        dst[i * 2] += src[i * 2] * scale;
+        dst[i * 2 + 1] += src[i * 2 + 1] * scale;
+    }
+}
+void Vector_Scale(float* v, float scale, int count)
+{
+    int i = 0;
+#ifdef VECTOR_SSE
+    __m128 s = _mm_set1_ps(scale);
+    for (; i + 2 <= count; i += 2)
+        _mm_storeu_ps(v + i * 2, _mm_mul_ps(_mm_loadu_ps(v + i * 2), s));
+#endif
+    for (; i < count; i++)
+    {
+        v[i * 2] *= scale;
+        v[i * 2 + 1] *= scale;
+    }
+}
+void Vector_Rotate(float* v, float angle, int count)
+{
+    float c = cosf(angle), s = sinf(angle);
+    int i = 0;
+#ifdef VECTOR_SSE
+    // (x, y) -> (x c - y s, x s + y c) : v * c + swapped v * (-s, s)
+    __m128 cs = _mm_set1_ps(c);
+    __m128 sn = _mm_setr_ps(-s, s, -s, s);
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128 p = _mm_loadu_ps(v + i * 2);
+        __m128 swapped = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_ps(v + i * 2, _mm_add_ps(_mm_mul_ps(p, cs), _mm_mul_ps(swapped, sn)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float x = v[i * 2], y = v[i * 2 + 1];
+        v[i * 2] = x * c - y * s;
+        v[i * 2 + 1] = x * s + y * c;
+    }
+}
+void Vector_Normalize(float* v, int count)
+{
+    int i = 0;
+#ifdef VECTOR_SSE
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128 p = _mm_loadu_ps(v + i * 2);
+        __m128 sq = _mm_mul_ps(p, p);
+        // x*x + y*y in both lanes of each vector
+        __m128 len2 = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128 len = _mm_sqrt_ps(len2);
+        // a full division keeps the result as exact as the scalar path
+        __m128 inv = _mm_and_ps(_mm_div_ps(one, len), _mm_cmpgt_ps(len2, zero));
+        _mm_storeu_ps(v + i * 2, _mm_mul_ps(p, inv));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float x = v[i * 2], y = v[i * 2 + 1];
+        float len2 = x * x + y * y;
+        if (len2 <= 0.0f) continue;
+        float inv = 1.0f / sqrtf(len2);
+        v[i * 2] = x * inv;
+        v[i * 2 + 1] = y * inv;
+    }
+}
+void Vector_Length(float* out, const float* v, int count)
+{
+    int i = 0;
+#ifdef VECTOR_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(v + i * 2);
+        __m128 b = _mm_loadu_ps(v + i * 2 + 4);
+        a = _mm_mul_ps(a, a);
+        b = _mm_mul_ps(b, b);
+        // gather the x and y squares of four vectors, then add them
+        __m128 xs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 ys = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(xs, ys)));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = sqrtf(v[i * 2] * v[i * 2] + v[i * 2 + 1] * v[i * 2 + 1]);
+}
+
+void Vector_Record(int count, Uint64 start)
+{
+    stats.calls++;
+    stats.vectors += (Uint64)count;
+    stats.time += (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+}
+const VectorStats* Vector_GetStats()
+{
+    return &stats;
+}
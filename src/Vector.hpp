@@ -0,0 +1,30 @@
+#ifndef VECTOR_HPP
+#define VECTOR_HPP
+
+#include <include/SDL.h>
+
+// the batch kernels work on interleaved x, y floats, count is the number of vectors
+
+typedef struct VectorStats
+{
+	// batch calls and vectors they went through
+	Uint64 calls, vectors;
+	// time spent in the kernels, in microseconds
+	double time;
+} VectorStats;
+
+// dst += src * scale
+void Vector_AddScaled(float* dst, const float* src, float scale, int count);
+// v *= scale
+void Vector_Scale(float* v, float scale, int count);
+// rotate v by angle radians, counterclockwise with y up
+void Vector_Rotate(float* v, float angle, int count);
+// make v of length 1, null vectors stay null
+void Vector_Normalize(float* v, int count);
+// out[i] = length of the i-th vector of v
+void Vector_Length(float* out, const float* v, int count);
+
+// count a batch call that started at the performance counter start
+void Vector_Record(int count, Uint64 start);
+const VectorStats* Vector_GetStats();
+#endif
@@ -0,0 +1,263 @@
+#include <vector>
+
+#include <include/SDL.h>
+#include <include/SDL_mixer.h>
+
+#include "Voice.hpp"
+#include "Group.hpp"
+
+typedef struct Voice
+{
+    const void* owner;
+    int group;
+    int priority;
+    Uint32 start;
+    // as played, before the group gain
+    float volume, pan;
+    // paused by its owner, the group may pause it too
+    bool paused;
+} Voice;
+
+// one per allocated mixer channel
+static std::vector<Voice> voices;
+static int limit = VOICE_DEFAULT_LIMIT;
+static VoiceStats stats = { 0, 0, 0, 0 };
+
+// a channel is free once its chunk is done, the owner is only cleared lazily
+static bool isActive(int ch)
+{
+    return voices[ch].owner != NULL && Mix_Playing(ch);
+}
+
+static int freeVoice()
+{
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+        if (!isActive(ch)) return ch;
+
+    // grow geometrically, the mixer reallocates every channel each time
+    int count = (int)voices.size();
+    if (count < limit)
+    {
+        int grown = SDL_min(SDL_max(count * 2, 8), limit);
+        int allocated = Mix_AllocateChannels(grown);
+        if (allocated > count)
+        {
+            Voice none = { NULL, 0, 0, 0, 1.0f, 0.0f, false };
+            voices.resize(allocated, none);
+            stats.allocated = allocated;
+            return count;
+        }
+    }
+    return -1;
+}
+static int victim(int priority)
+{
+    int best = -1;
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+    {
+        const Voice* v = &voices[ch];
+        if (v->priority > priority) continue;
+        if (best < 0 || v->priority < voices[best].priority ||
+            (v->priority == voices[best].priority && (Sint32)(v->start - voices[best].start) < 0))
+            best = ch;
+    }
+    return best;
+}
+
+static void applyVolume(int ch)
+{
+    float volume = SDL_clamp(voices[ch].volume, 0.0f, 1.0f) * Group_GetGain(voices[ch].group);
+    float pan = SDL_clamp(voices[ch].pan, -1.0f, 1.0f);
+    Mix_Volume(ch, (int)(volume * MIX_MAX_VOLUME));
+    Mix_SetPanning(ch, (Uint8)(255 * SDL_min(1.0f, 1.0f - pan)), (Uint8)(255 * SDL_min(1.0f, 1.0f + pan)));
+}
+
+static void SDLCALL runEffect(int, void* stream, int len, void* udata)
+{
+    Dsp_Process((DspEffect*)udata, stream, len);
+}
+static void SDLCALL freeEffect(int, void* udata)
+{
+    Dsp_Destroy((DspEffect*)udata);
+}
+static void SDLCALL feedSend(int chan, void* stream, int len, void* udata)
+{
+    // the mixer applies the channel volume after the effects
+    Dsp_Feed((DspSend*)udata, chan, stream, len, Mix_Volume(chan, -1) / (float)MIX_MAX_VOLUME);
+}
+// the mixer drops a channel's effects when it is done playing, and calls freeEffect,
+// so the delay and reverb run in the owner's send, which rings on after the voice
+static void applyEffects(int ch, const void* owner, const DspParams* effects, int count)
+{
+    DspSend* send = NULL;
+    for (int i = 0; i < count && send == NULL; i++)
+        if (Dsp_IsTail(effects[i].type)) send = Dsp_GetSend(owner, effects, count, Audio_GetSpec());
+
+    for (int i = 0; i < count; i++)
+    {
+        // without a send the voice runs them itself, and they stop with it
+        if (send != NULL && Dsp_IsTail(effects[i].type)) continue;
+        DspEffect* effect = Dsp_Create(&effects[i], Audio_GetSpec());
+        if (effect == NULL) continue;
+        if (Mix_RegisterEffect(ch, runEffect, freeEffect, effect) == 0)
+            Dsp_Destroy(effect);
+    }
+    // last, the send gets what the filters let through
+    if (send != NULL) Mix_RegisterEffect(ch, feedSend, NULL, send);
+}
+
+int Voice_Play(Mix_Chunk* chunk, const void* owner, int group, int priority, int loops, float volume, float pan,
+    const DspParams* effects, int effectCount)
+{
+    int ch = freeVoice();
+    if (ch < 0)
+    {
+        ch = victim(priority);
+        if (ch < 0)
+        {
+            stats.drops++;
+            return -1;
+        }
+        Mix_HaltChannel(ch);
+        stats.steals++;
+    }
+
+    voices[ch].group = group;
+    voices[ch].volume = volume;
+    voices[ch].pan = pan;
+    voices[ch].paused = false;
+    applyVolume(ch);
+    applyEffects(ch, owner, effects, effectCount);
+    if (Mix_PlayChannel(ch, chunk, loops) < 0)
+    {
+        Mix_UnregisterAllEffects(ch);
+        voices[ch].owner = NULL;
+        return -1;
+    }
+    // lets the mixer halt the whole group at once
+    Mix_GroupChannel(ch, (group > 0) ? group : -1);
+    if (Group_IsPaused(group)) Mix_Pause(ch);
+    voices[ch].owner = owner;
+    voices[ch].priority = priority;
+    voices[ch].start = SDL_GetTicks();
+    return ch;
+}
+
+void Voice_Halt(const void* owner)
+{
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+        if (voices[ch].owner == owner) Mix_HaltChannel(ch);
+}
+void Voice_Pause(const void* owner)
+{
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+    {
+        if (!isActive(ch) || voices[ch].owner != owner) continue;
+        voices[ch].paused = true;
+        Mix_Pause(ch);
+    }
+}
+void Voice_Resume(const void* owner)
+{
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+    {
+        if (!isActive(ch) || voices[ch].owner != owner) continue;
+        voices[ch].paused = false;
+        if (!Group_IsPaused(voices[ch].group)) Mix_Resume(ch);
+    }
+}
+void Voice_SetVolume(const void* owner, float volume, float pan)
+{
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+    {
+        if (!isActive(ch) || voices[ch].owner != owner) continue;
+        voices[ch].volume = volume;
+        voices[ch].pan = pan;
+        applyVolume(ch);
+    }
+}
+bool Voice_IsPlaying(const void* owner)
+{
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+        if (voices[ch].owner == owner && isActive(ch)) return true;
+    return false;
+}
+bool Voice_IsPaused(const void* owner)
+{
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+        if (voices[ch].owner == owner && isActive(ch) && Mix_Paused(ch)) return true;
+    return false;
+}
+void Voice_Release(const void* owner)
+{
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+    {
+        if (voices[ch].owner != owner) continue;
+        Mix_HaltChannel(ch);
+        voices[ch].owner = NULL;
+    }
+    Dsp_ReleaseSend(owner);
+}
+void Voice_ReleaseSend(const void* owner)
+{
+    // the mixer holds the audio lock, no channel feeds the send once it returns
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+        if (voices[ch].owner == owner) Mix_UnregisterEffect(ch, feedSend);
+    Dsp_ReleaseSend(owner);
+}
+
+void Voice_ApplyGroup(int group)
+{
+    bool groupPaused = Group_IsPaused(group);
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+    {
+        if (!isActive(ch) || voices[ch].group != group) continue;
+        applyVolume(ch);
+        if (groupPaused || voices[ch].paused) Mix_Pause(ch);
+        else Mix_Resume(ch);
+    }
+}
+void Voice_HaltGroup(int group)
+{
+    if (group > 0) Mix_HaltGroup(group);
+}
+void Voice_Ungroup(int group)
+{
+    if (group <= 0) return;
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+    {
+        if (voices[ch].group != group) continue;
+        // the mixer keeps the tag once the channel is done, Mix_HaltGroup would still find it
+        voices[ch].group = 0;
+        Mix_GroupChannel(ch, -1);
+        if (!isActive(ch)) continue;
+        applyVolume(ch);
+        if (!voices[ch].paused) Mix_Resume(ch);
+    }
+}
+
+void Voice_SetLimit(int l)
+{
+    limit = SDL_max(l, 1);
+    if ((int)voices.size() <= limit) return;
+
+    // the mixer halts the channels past the new count
+    stats.allocated = Mix_AllocateChannels(limit);
+    voices.resize(stats.allocated);
+}
+int Voice_GetLimit()
+{
+    return limit;
+}
+const VoiceStats* Voice_GetStats()
+{
+    stats.playing = 0;
+    for (int ch = 0; ch < (int)voices.size(); ch++)
+        if (isActive(ch)) stats.playing++;
+    return &stats;
+}
+void Voice_Reset()
+{
+    voices.clear();
+    stats.allocated = stats.playing = 0;
+}
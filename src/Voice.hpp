@@ -0,0 +1,53 @@
+#ifndef VOICE_HPP
+#define VOICE_HPP
+
+#include <include/SDL.h>
+#include <include/SDL_mixer.h>
+
+#include "Dsp.hpp"
+
+// default limit of sounds playing at once
+#define VOICE_DEFAULT_LIMIT 32
+
+typedef struct VoiceStats
+{
+	// mixer channels allocated so far, and playing right now
+	int allocated, playing;
+	// voices taken from another sound, and plays dropped for lack of a voice
+	Uint64 steals, drops;
+} VoiceStats;
+
+// play chunk on a free mixer channel, allocating more up to the limit
+// past the limit the voice with the lowest priority, then the oldest, is stolen
+// if it has a priority no higher than the new one
+// owner is what the voice is looked up by afterwards, group what it is tagged with in the mixer
+// volume is from 0 to 1, pan from -1 (left) to 1 (right), the group gain is applied on top
+// filters are created for the voice and freed by the mixer once it is done, the delay and
+// reverb are shared by the voices of owner and ring on after them, see Dsp_GetSend
+// return the channel, or -1 if the play was dropped
+int Voice_Play(Mix_Chunk* chunk, const void* owner, int group, int priority, int loops, float volume, float pan,
+	const DspParams* effects, int effectCount);
+// halt, pause or resume every voice of owner
+void Voice_Halt(const void* owner);
+void Voice_Pause(const void* owner);
+void Voice_Resume(const void* owner);
+void Voice_SetVolume(const void* owner, float volume, float pan);
+// return wether a voice of owner is playing (paused or not), or paused
+bool Voice_IsPlaying(const void* owner);
+bool Voice_IsPaused(const void* owner);
+// halt the voices of owner and forget it, before it is freed
+void Voice_Release(const void* owner);
+// stop the voices of owner feeding its delay and reverb and free them, before its effects change
+void Voice_ReleaseSend(const void* owner);
+// apply the gain and pause state of group to its voices
+void Voice_ApplyGroup(int group);
+void Voice_HaltGroup(int group);
+// the voices of group play as if they were in none, before its id is reused
+void Voice_Ungroup(int group);
+
+void Voice_SetLimit(int limit);
+int Voice_GetLimit();
+const VoiceStats* Voice_GetStats();
+// forget every voice, after the mixer was closed
+void Voice_Reset();
+#endif
@@ -0,0 +1,169 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#include <include/SDL.h>
+
+#include "Watcher.hpp"
+#include "FileMap.hpp"
+
+typedef struct WatchedFile
+{
+    // path as given to Watcher_Add, and its file name
+    std::string path;
+    std::string name;
+    long long mtime;
+} WatchedFile;
+typedef struct WatchedDir
+{
+    std::string dir;
+    int wd;
+    std::vector<WatchedFile> files;
+} WatchedDir;
+
+static bool running = false;
+static std::vector<WatchedDir> dirs;
+
+#ifdef __linux__
+static int inotifyFd = -1;
+#else
+// modification times are checked at most this often
+static const Uint32 pollInterval = 250;
+static Uint32 lastPoll = 0;
+#endif
+
+static void splitPath(const std::string& path, std::string& dir, std::string& name)
+{
+    size_t sep = path.find_last_of("/\\");
+    if (sep == std::string::npos)
+    {
+        dir = ".";
+        name = path;
+    }
+    else
+    {
+        dir = (sep == 0) ? "/" : path.substr(0, sep);
+        name = path.substr(sep + 1);
+    }
+}
+
+bool Watcher_Start()
+{
+    if (running) return true;
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        SDL_SetError("Can't initialize inotify");
+        return false;
+    }
+#endif
+    running = true;
+    return true;
+}
+void Watcher_Stop()
+{
+#ifdef __linux__
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+    inotifyFd = -1;
+#endif
+    dirs.clear();
+    running = false;
+}
+bool Watcher_IsRunning()
+{
+    return running;
+}
+
+void Watcher_Add(const char* path)
+{
+    if (!running || Watcher_IsWatched(path)) return;
+
+    WatchedFile file;
+    std::string dir;
+    file.path = path;
+    file.mtime = FileModTime(path);
+    splitPath(file.path, dir, file.name);
+
+    for (WatchedDir& d : dirs)
+    {
+        if (d.dir == dir)
+        {
+            d.files.push_back(file);
+            return;
+        }
+    }
+
+    WatchedDir d;
+    d.dir = dir;
+    d.wd = -1;
+#ifdef __linux__
+    // editors either rewrite files in place or rename a new one over them
+    d.wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (d.wd < 0) return;
+#endif
+    d.files.push_back(file);
+    dirs.push_back(d);
+}
+bool Watcher_IsWatched(const char* path)
+{
+    for (const WatchedDir& d : dirs)
+        for (const WatchedFile& f : d.files)
+            if (f.path == path) return true;
+    return false;
+}
+
+static void addChanged(std::vector<std::string>& changed, const std::string& path)
+{
+    if (std::find(changed.begin(), changed.end(), path) == changed.end())
+        changed.push_back(path);
+}
+
+void Watcher_Poll(std::vector<std::string>& changed)
+{
+    if (!running) return;
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t len = read(inotifyFd, buffer, sizeof(buffer));
+        if (len <= 0) break;
+
+        for (char* p = buffer; p < buffer + len;)
+        {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->len == 0) continue;
+
+            for (const WatchedDir& d : dirs)
+            {
+                if (d.wd != ev->wd) continue;
+                for (const WatchedFile& f : d.files)
+                    if (f.name == ev->name) addChanged(changed, f.path);
+            }
+        }
+    }
+#else
+    Uint32 now = SDL_GetTicks();
+    if (now - lastPoll < pollInterval) return;
+    lastPoll = now;
+
+    for (WatchedDir& d : dirs)
+    {
+        for (WatchedFile& f : d.files)
+        {
+            long long mtime = FileModTime(f.path.c_str());
+            if (mtime < 0 || mtime == f.mtime) continue;
+            f.mtime = mtime;
+            addChanged(changed, f.path);
+        }
+    }
+#endif
+}
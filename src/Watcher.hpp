@@ -0,0 +1,21 @@
+#ifndef WATCHER_HPP
+#define WATCHER_HPP
+
+#include <string>
+#include <vector>
+
+// file change notifications, with inotify on linux and by polling
+// modification times elsewhere
+
+// start watching, return false if notifications are unavailable
+bool Watcher_Start();
+// stop watching and forget every file
+void Watcher_Stop();
+bool Watcher_IsRunning();
+
+// watch a file, changes are reported with the exact same path
+void Watcher_Add(const char* path);
+bool Watcher_IsWatched(const char* path);
+// append the paths changed since the last call, each once
+void Watcher_Poll(std::vector<std::string>& changed);
+#endif